@@ -31,6 +31,7 @@
 
 #include "types.h"
 #include "midiEvent.h"
+#include "actionPool.h"
 
 
 namespace giada {
@@ -40,17 +41,28 @@ struct Action
 {
     int       id; // For persistence only
 	int       channel;
-	Frame     frame;
+	Tick      tick;  // Position in musical time, tempo-independent
+	Frame     frame; // Position in frames, derived from 'tick'
 	MidiEvent event;
     int       pluginIndex;
     int       pluginParam;
-	const Action* prev;
-	const Action* next;
+
+	/* handle, prev, next
+	Actions are owned by actionPool: 'handle' is this action's own place in
+	there, 'prev' and 'next' refer to chained actions (e.g. envelopes), if any.
+	NO_ACTION otherwise. */
+
+	ActionHandle handle;
+	ActionHandle prev;
+	ActionHandle next;
 
     bool isVolumeEnvelope() const
     { 
         return event.getStatus() == MidiEvent::ENVELOPE && pluginIndex == -1; 
     }
+
+	const Action* getPrev() const { return actionPool::get(prev); }
+	const Action* getNext() const { return actionPool::get(next); }
 };
 
 }} // giada::m::
@@ -0,0 +1,188 @@
+/* -----------------------------------------------------------------------------
+ *
+ * Giada - Your Hardcore Loopmachine
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2019 Giovanni A. Zuliani | Monocasual
+ *
+ * This file is part of Giada - Your Hardcore Loopmachine.
+ *
+ * Giada - Your Hardcore Loopmachine is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * Giada - Your Hardcore Loopmachine is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Giada - Your Hardcore Loopmachine. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------------- */
+
+
+#include <memory>
+#include <mutex>
+#include <cassert>
+#include "../utils/log.h"
+#include "action.h"
+#include "actionPool.h"
+
+
+namespace giada {
+namespace m {
+namespace actionPool
+{
+namespace
+{
+/* chunks_
+Fixed table of chunks, allocated lazily. A chunk pointer is written once, 
+before any handle pointing into it is handed out: readers don't need a lock. */
+
+std::unique_ptr<Action[]> chunks_[MAX_CHUNKS];
+
+/* free_, next_
+List of handles given back to the pool, plus the next never-used handle. 
+Both guarded by mutex_. */
+
+std::vector<ActionHandle> free_;
+ActionHandle              next_  = 0;
+size_t                    used_  = 0;
+std::mutex                mutex_;
+
+
+/* -------------------------------------------------------------------------- */
+
+
+static_assert(MAX_CHUNKS * CHUNK_SIZE == 1 << INDEX_BITS, "Chunk and slot must fill the index bits");
+static_assert(INDEX_BITS + GENERATION_BITS == 32, "ActionHandle is 32 bits");
+
+
+/* -------------------------------------------------------------------------- */
+
+
+ActionHandle getIndex_(ActionHandle h)
+{
+	return h & ((1u << INDEX_BITS) - 1);
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+/* nextGeneration_
+Returns handle 'h' with its generation moved one step forward. */
+
+ActionHandle nextGeneration_(ActionHandle h)
+{
+	return getIndex_(h) | (((h >> INDEX_BITS) + 1) << INDEX_BITS);
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+Action* getMutable_(ActionHandle h)
+{
+	ActionHandle i = getIndex_(h);
+	return &chunks_[i >> CHUNK_BITS][i & (CHUNK_SIZE - 1)];
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void free_locked_(const Action* a)
+{
+	assert(a != nullptr);
+	assert(a->handle != NO_ACTION);
+
+	/* Stamp the slot with the next generation right away: handles still around
+	stop resolving to it. */
+
+	ActionHandle h = nextGeneration_(a->handle);
+	getMutable_(h)->handle = h;
+	free_.push_back(h);
+	used_--;
+}
+} // {anonymous}
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+
+Action* alloc()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	ActionHandle h;
+	if (!free_.empty()) {
+		h = free_.back();
+		free_.pop_back();
+	}
+	else {
+		/* The very last index is left out: with the highest generation it would
+		be NO_ACTION. */
+
+		if (next_ == static_cast<ActionHandle>(MAX_CHUNKS * CHUNK_SIZE) - 1) {
+			gu_log("[actionPool::alloc] pool is full!\n");
+			return nullptr;
+		}
+		h = next_++;
+		if (chunks_[h >> CHUNK_BITS] == nullptr)
+			chunks_[h >> CHUNK_BITS].reset(new Action[CHUNK_SIZE]);
+	}
+	used_++;
+
+	Action* a = getMutable_(h);
+	*a = Action{ -1, 0, 0, 0, MidiEvent(), -1, -1, h, NO_ACTION, NO_ACTION };
+	return a;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void free(const Action* a)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	free_locked_(a);
+}
+
+
+void free(const std::vector<const Action*>& as)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	free_.reserve(free_.size() + as.size());
+	for (const Action* a : as)
+		free_locked_(a);
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+const Action* get(ActionHandle h)
+{
+	if (h == NO_ACTION)
+		return nullptr;
+	const Action* a = getMutable_(h);
+	return a->handle == h ? a : nullptr;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+size_t countUsed()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return used_;
+}
+}}}; // giada::m::actionPool::
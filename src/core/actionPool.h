@@ -0,0 +1,86 @@
+/* -----------------------------------------------------------------------------
+ *
+ * Giada - Your Hardcore Loopmachine
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2019 Giovanni A. Zuliani | Monocasual
+ *
+ * This file is part of Giada - Your Hardcore Loopmachine.
+ *
+ * Giada - Your Hardcore Loopmachine is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * Giada - Your Hardcore Loopmachine is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Giada - Your Hardcore Loopmachine. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------------- */
+
+
+#ifndef G_ACTION_POOL_H
+#define G_ACTION_POOL_H
+
+
+#include <vector>
+#include <cstddef>
+#include "types.h"
+
+
+namespace giada {
+namespace m 
+{
+struct Action;
+
+namespace actionPool
+{
+/* Actions live in fixed-size chunks that are never moved nor released, so both
+pointers and 32-bit handles to them stay valid until the action is freed. A 
+handle is made of (generation, chunk index, slot index). The generation goes up
+each time a slot is freed: a stale handle to a reused slot no longer resolves
+(it wraps around after 256 reuses of the same slot). */
+
+constexpr int CHUNK_BITS      = 12;
+constexpr int CHUNK_SIZE      = 1 << CHUNK_BITS;
+constexpr int MAX_CHUNKS      = 4096;
+constexpr int INDEX_BITS      = 24;  // chunk index + slot index
+constexpr int GENERATION_BITS = 8;
+
+/* alloc
+Returns a new blank action with its handle already set, or nullptr if the pool
+is full. Not to be called by the audio thread. */
+
+Action* alloc();
+
+/* free (1)
+Gives back an action to the pool. */
+
+void free(const Action* a);
+
+/* free (2)
+Gives back a bunch of actions at once (e.g. all actions of a channel). */
+
+void free(const std::vector<const Action*>& as);
+
+/* get
+Returns the action referred by handle 'h', or nullptr if h == NO_ACTION or if
+the action 'h' referred to has been freed in the meantime. Safe to call from 
+any thread. */
+
+const Action* get(ActionHandle h);
+
+/* countUsed
+Returns the number of actions currently allocated. */
+
+size_t countUsed();
+}}}; // giada::m::actionPool::
+
+
+#endif
@@ -123,4 +123,53 @@ void AudioBuffer::copyData(float* data, int frames, int offset)
 	memcpy(m_data + (offset * m_channels), data, frames * m_channels * sizeof(float));
 }
 
+
+/* -------------------------------------------------------------------------- */
+
+
+void AudioBuffer::deinterleave(float* const* out) const
+{
+	assert(m_data != nullptr);
+
+	/* Stereo is by far the most common case: a constant stride lets the 
+	compiler vectorize the loop. */
+
+	if (m_channels == 2) {
+		float* l = out[0];
+		float* r = out[1];
+		for (int i=0; i<m_size; i++) {
+			l[i] = m_data[i * 2];
+			r[i] = m_data[i * 2 + 1];
+		}
+		return;
+	}
+
+	for (int j=0; j<m_channels; j++)
+		for (int i=0; i<m_size; i++)
+			out[j][i] = m_data[i * m_channels + j];
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void AudioBuffer::interleave(const float* const* in)
+{
+	assert(m_data != nullptr);
+
+	if (m_channels == 2) {
+		const float* l = in[0];
+		const float* r = in[1];
+		for (int i=0; i<m_size; i++) {
+			m_data[i * 2]     = l[i];
+			m_data[i * 2 + 1] = r[i];
+		}
+		return;
+	}
+
+	for (int j=0; j<m_channels; j++)
+		for (int i=0; i<m_size; i++)
+			m_data[i * m_channels + j] = in[j][i];
+}
+
 }} // giada::m::
\ No newline at end of file
@@ -63,6 +63,17 @@ public:
 	
 	void clear(int a=0, int b=-1);
 
+	/* deinterleave
+	Splits the internal data into separate per-channel arrays, one for each 
+	channel, 'out[channel][frame]'. Each array must hold countFrames() floats. */
+
+	void deinterleave(float* const* out) const;
+
+	/* interleave
+	The other way around: fills the internal data with per-channel arrays. */
+
+	void interleave(const float* const* in);
+
 private:
 
 	float* m_data;
@@ -56,6 +56,7 @@ namespace m
 {
 Channel::Channel(ChannelType type, ChannelStatus status, int bufferSize)
 :	guiChannel     (nullptr),
+	directOut      (nullptr),
 	type           (type),
 	status         (status),
 	recStatus      (ChannelStatus::OFF),
@@ -82,16 +83,42 @@ Channel::Channel(ChannelType type, ChannelStatus status, int bufferSize)
 	midiOutL       (false),
 	midiOutLplaying(0x0),
 	midiOutLmute   (0x0),
-	midiOutLsolo   (0x0)
+	midiOutLsolo   (0x0),
+	frozenTracker  (-1),
+	frozenFirst    (0),
+	frozenLast     (0)
 {
 	buffer.alloc(bufferSize, G_MAX_IO_CHANS);
+#ifdef WITH_VST
+	pluginContext.alloc(bufferSize);
+#endif
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void Channel::setBufferSize(int bufferSize)
+{
+	buffer.alloc(bufferSize, G_MAX_IO_CHANS);
+#ifdef WITH_VST
+	pluginContext.alloc(bufferSize);
+#endif
 }
 
 
 /* -------------------------------------------------------------------------- */
 
 
-void Channel::copy(const Channel* src, pthread_mutex_t* pluginMutex)
+Channel::~Channel()
+{
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void Channel::copy(const Channel* src)
 {
 	key             = src->key;
 	volume          = src->volume;
@@ -118,9 +145,9 @@ void Channel::copy(const Channel* src, pthread_mutex_t* pluginMutex)
 
 #ifdef WITH_VST
 
-	for (const std::unique_ptr<Plugin>& plugin : src->plugins)
-		pluginHost::addPlugin(pluginManager::makePlugin(*plugin.get()), 
-			pluginHost::StackType::CHANNEL, pluginMutex, this);
+	for (const Plugin* plugin : src->plugins.get())
+		pluginHost::addPlugin(pluginManager::makePlugin(*plugin), 
+			pluginHost::StackType::CHANNEL, this);
 
 #endif
 
@@ -289,22 +316,57 @@ bool Channel::isReadingActions() const
 /* -------------------------------------------------------------------------- */
 
 
-#ifdef WITH_VST
+bool Channel::isFrozen() const
+{
+	return frozen != nullptr;
+}
 
-const juce::MidiBuffer& Channel::getPluginMidiEvents() const
+
+/* -------------------------------------------------------------------------- */
+
+
+void Channel::parseFrozen(const mixer::FrameEvents& fe, bool active)
 {
-	return midiBuffer;
+	if (!active)
+		return;
+	if (frozenTracker == -1) {
+		frozenTracker = fe.frameGlobal;
+		frozenFirst   = fe.frameLocal;
+	}
+	frozenLast = fe.frameLocal + 1;
 }
 
 
 /* -------------------------------------------------------------------------- */
 
 
-void Channel::clearMidiBuffer()
+void Channel::processFrozen(AudioBuffer& out, bool audible)
 {
-	midiBuffer.clear();
+	/* Frozen data spans exactly one loop, starting on the first beat: the 
+	sequencer frame is the read position. Volume envelopes and boost are already
+	in there. Data rendered for another loop length is stale: stay silent until
+	freezer::refresh() renders it again. */
+
+	const Frame size = frozen->getSize();
+
+	if (frozenTracker != -1 && audible && !mute && size == clock::getFramesInLoop()) {
+		const Frame wrap = clock::getWrapFrame();
+		Frame f = frozenTracker % size;
+		for (int i=frozenFirst; i<frozenLast; i++) {
+			if (i == wrap)  // Loops may be one frame shorter than the data
+				f = 0;
+			const float* frame = frozen->getFrame(f);
+			const float  vol   = volumeSmooth.next(volume);
+			for (int j=0; j<out.countChannels(); j++)
+				out[i][j] += frame[j] * vol * calcPanning(j);
+			if (++f == size)
+				f = 0;
+		}
+	}
+	else
+		volumeSmooth.reset();
+	frozenTracker = -1;
 }
 
-#endif
 
 }} // giada::m::
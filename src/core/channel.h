@@ -31,6 +31,7 @@
 
 #include <vector>
 #include <string>
+#include <memory>
 #include <pthread.h>
 #include "types.h"
 #include "patch.h"
@@ -39,29 +40,37 @@
 #include "midiEvent.h"
 #include "recorder.h"
 #include "audioBuffer.h"
+#include "smoothedValue.h"
 
 #ifdef WITH_VST
 	#include "../deps/juce-config.h"
 	#include "plugin.h"
+	#include "pluginHost.h"
 #endif
 
 
 class geChannel;
+class Wave;
 
 
 namespace giada {
 namespace m
 {
+namespace kernelAudio
+{
+struct DirectOut;
+}
+
 class Channel
 {
 public:
 
-	virtual ~Channel() {};
+	virtual ~Channel();
 
 	/* copy
 	Makes a shallow copy (no internal buffers allocation) of another channel. */
 
-	virtual void copy(const Channel* src, pthread_mutex_t* pluginMutex) = 0;
+	virtual void copy(const Channel* src) = 0;
 
 	/* parseEvents
 	Prepares channel for rendering. This is called on each frame. */
@@ -143,6 +152,12 @@ public:
 		bool recsStopOnChanHalt) {};
 
 	virtual void stopInputRec(int globalFrame) {};
+
+	/* setBufferSize
+	Reallocates the buffers that depend on the audio block size. Call it while 
+	holding mixer::mutex. */
+
+	virtual void setBufferSize(int bufferSize);
 	
 	virtual void readPatch(const std::string& basePath, const patch::channel_t& pch);
 	virtual void writePatch(int i, bool isProject);
@@ -160,6 +175,16 @@ public:
 	bool isPlaying() const;
 	float getPan() const;
 	bool isPreview() const;
+	bool isFrozen() const;
+
+	/* parseFrozen, processFrozen
+	Replacements for the audio part of parseEvents() and process() while the 
+	channel is frozen: play the pre-rendered data in sync with the sequencer, 
+	with the current volume, panning and mute settings. The channel status keeps
+	going as usual; 'active' tells whether the channel is heard on this frame. */
+
+	void parseFrozen(const mixer::FrameEvents& fe, bool active);
+	void processFrozen(AudioBuffer& out, bool audible);
 
 	/* isMidiInAllowed
 	Given a MIDI channel 'c' tells whether this channel should be allowed to 
@@ -183,24 +208,18 @@ public:
 
 	void calcVolumeEnvelope();
 
-#ifdef WITH_VST
-
-	/* getPluginMidiEvents
-	Returns a reference to midiBuffer stack. This is available for any kind of
-	channel, but it makes sense only for MIDI channels. */
-
-	const juce::MidiBuffer& getPluginMidiEvents() const;
-
-	void clearMidiBuffer();
-
-#endif
-
 	/* guiChannel
 	Pointer to a gChannel object, part of the GUI. TODO - remove this and send
 	signals instead. */
 
 	geChannel* guiChannel;
 
+	/* directOut
+	JACK ports carrying this channel alone, if direct outputs are enabled. Set
+	and released by mixerHandler, owned by kernelAudio. */
+
+	kernelAudio::DirectOut* directOut;
+
 	/* buffer
 	Working buffer for internal processing. */
 	
@@ -231,6 +250,12 @@ public:
 	
 	double volume_i;
 	double volume_d;
+
+	/* volumeSmooth
+	Follows 'volume' frame by frame in the mixing kernels: volume changes come
+	in as steps. Reset while the channel is idle. Audio thread only. */
+
+	SmoothedValue volumeSmooth;
 	
 	bool hasActions;      // If has some actions recorded
 	bool readActions;     // If should read recorded actions
@@ -260,23 +285,37 @@ public:
 	uint32_t midiOutLmute;
 	uint32_t midiOutLsolo;
 
+	/* frozen
+	Output of the channel (actions + plug-ins) rendered offline over a loop, if 
+	the channel is frozen. See freezer. Change it while holding mixer::mutex. */
+
+	std::unique_ptr<Wave> frozen;
+
 #ifdef WITH_VST
-	std::vector<std::unique_ptr<Plugin>> plugins;
+	pluginHost::Stack plugins;
+
+	/* pluginContext
+	Buffers and MIDI events for the plug-in stack. MIDI events can be posted 
+	there from any thread. This is available for any kind of channel, but MIDI
+	events make sense only for MIDI channels. */
+
+	pluginHost::Context pluginContext;
 #endif
 
 protected:
 
 	Channel(ChannelType type, ChannelStatus status, int bufferSize);
 
-#ifdef WITH_VST
-
-	/* MidiBuffer contains MIDI events. When ready, events are sent to each plugin 
-	in the channel. This is available for any kind of channel, but it makes sense 
-	only for MIDI channels. */
+private:
 
-	juce::MidiBuffer midiBuffer;
+	/* frozenTracker, frozenFirst, frozenLast
+	Where to read frozen data from in the current block (sequencer frame) and 
+	the range of frames in the block the channel was active. frozenTracker is -1 
+	if it wasn't active at all. */
 
-#endif
+	Frame frozenTracker;
+	Frame frozenFirst;
+	Frame frozenLast;
 };
 
 }} // giada::m::
@@ -60,8 +60,10 @@ void writePlugins_(const Channel* ch, patch::channel_t& pch)
 		patch::plugin_t pp;
 		pp.path   = p->getUniqueId();
 		pp.bypass = p->isBypassed();
-		for (int k=0; k<p->getNumParameters(); k++)
-			pp.params.push_back(p->getParameter(k));
+		pp.state  = p->getState();
+		if (pp.state.empty())  // No chunk: parameters are the only way
+			for (int k=0; k<p->getNumParameters(); k++)
+				pp.params.push_back(p->getParameter(k));
 		for (uint32_t param : p->midiInParams)
 			pp.midiInParams.push_back(param);
 		pch.plugins.push_back(pp);
@@ -90,25 +92,23 @@ void readPlugins_(Channel* ch, const patch::channel_t& pch)
 #ifdef WITH_VST
 
 	for (const patch::plugin_t& ppl : pch.plugins) {
-
-		std::unique_ptr<Plugin> plugin = pluginManager::makePlugin(ppl.path);
-		if (plugin == nullptr)
-			continue;
-
-		plugin->setBypass(ppl.bypass);
-		for (unsigned j=0; j<ppl.params.size(); j++)
-			plugin->setParameter(j, ppl.params.at(j));
-
-		/* Don't fill Channel::midiInParam if Patch::midiInParams are 0: it would
-		wipe out the current default 0x0 values. */
-
-		if (!ppl.midiInParams.empty()) {
-			plugin->midiInParams.clear();
-			for (uint32_t midiInParam : ppl.midiInParams)
-				plugin->midiInParams.push_back(midiInParam);
-		}
-
-		pluginHost::addPlugin(std::move(plugin), pluginHost::StackType::CHANNEL, &mixer::mutex, ch);
+		pluginManager::makePluginAsync(ppl.path, pluginHost::StackType::CHANNEL, ch, 
+			[ppl] (Plugin& plugin)
+		{
+			plugin.setBypass(ppl.bypass);
+			if (ppl.state.empty() || !plugin.setState(ppl.state))
+				for (unsigned j=0; j<ppl.params.size(); j++)
+					plugin.setParameter(j, ppl.params.at(j));
+
+			/* Don't fill Channel::midiInParam if Patch::midiInParams are 0: it 
+			would wipe out the current default 0x0 values. */
+
+			if (!ppl.midiInParams.empty()) {
+				plugin.midiInParams.clear();
+				for (uint32_t midiInParam : ppl.midiInParams)
+					plugin.midiInParams.push_back(midiInParam);
+			}
+		});
 	}
 
 #endif
@@ -25,14 +25,17 @@
  * -------------------------------------------------------------------------- */
 
 
+#include <algorithm>
 #include <atomic>
 #include <cassert>
+#include <cmath>
 #include "../glue/transport.h"
-#include "../glue/main.h"
 #include "conf.h"
 #include "const.h"
 #include "kernelAudio.h"
 #include "kernelMidi.h"
+#include "midiSync.h"
+#include "worker.h"
 #include "clock.h"
 
 
@@ -57,7 +60,35 @@ std::atomic<int> currentFrameWait_(0);  // Used only in wait mode
 std::atomic<int> currentFrame_(0);
 std::atomic<int> currentBeat_(0);
 
-int midiTCrate_    = 0;      // Send MTC data every midiTCrate_ frames
+/* Phase accumulator. The beat length is kept fractional and positions are 
+computed in beats as loopOffset_ + currentFrame_ * beatStep_: a boundary (beat,
+bar, quanto, ...) falls on the frame nearest to its exact position, so rounding
+errors never add up. A loop lasts one frame more or less from time to time, 
+and loopOffset_ carries over what's left. */
+
+double framesInBeatExact_ = 0.0;
+double beatStep_          = 0.0;  // Length of a frame, in beats
+double loopOffset_        = 0.0;
+double loopOffsetWait_    = 0.0;  // Used only in wait mode
+
+/* Boundaries the current frame falls on, updated at every step for the fast
+is*() queries. */
+
+std::atomic<bool> onBeat_(true);
+std::atomic<bool> onBeatWait_(true);
+std::atomic<bool> onBar_(true);
+std::atomic<bool> onQuanto_(true);
+std::atomic<bool> onMidiClock_(true);
+
+/* blockFrame_, wrapFrame_
+Audio thread only. Frame within the current audio block and the one where the
+loop started over in it, -1 if it didn't. */
+
+Frame blockFrame_ = 0;
+Frame wrapFrame_  = -1;
+
+double midiTCstep_  = 0.0;   // Length of a frame, in timecode frames
+double midiTCphase_ = 0.0;
 int midiTCframes_  = 0;
 int midiTCseconds_ = 0;
 int midiTCminutes_ = 0;
@@ -67,11 +98,159 @@ int midiTChours_   = 0;
 kernelAudio::JackState jackStatePrev_;
 #endif
 
+midiSync::Event midiSyncTick_;  // Last tick from the MIDI master
+bool            midiSyncHasTick_ = false;
+double          midiSyncBpmTime_ = 0.0;  // Last time the tempo matched the master's
+
 
 void updateQuanto_()
 {
 	if (quantize_.load() != 0)
-		quanto_ = framesInBeat_ / quantize_.load();
+		quanto_ = std::lround(framesInBeatExact_ / quantize_.load());
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+double getBeatPos_(Frame frame, double offset)
+{
+	return offset + frame * beatStep_;
+}
+
+
+/* crosses_
+Whether a multiple of 'unit' beats falls within half a frame from 'pos'. */
+
+bool crosses_(double pos, double unit)
+{
+	double half = beatStep_ / 2;
+	return std::floor((pos + half) / unit) != std::floor((pos - half) / unit);
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void updateBoundaries_()
+{
+	double pos = getBeatPos_(currentFrame_.load(), loopOffset_);
+
+	onBeat_.store(crosses_(pos, 1.0));
+	onBeatWait_.store(crosses_(getBeatPos_(currentFrameWait_.load(), loopOffsetWait_), 1.0));
+	onBar_.store(crosses_(pos, beats_ / bars_));
+	onQuanto_.store(quantize_.load() == 0 || crosses_(pos, 1.0 / quantize_.load()));
+	onMidiClock_.store(crosses_(pos, 1.0 / G_MIDI_CLOCK_PPQ));
+
+	int beat = std::floor(pos + beatStep_ / 2);
+	currentBeat_.store(std::max(0, std::min(beat, beats_ - 1)));
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+/* advance_
+Moves 'frame' one step forward. The loop ends on the frame nearest to its 
+exact length: start over from there. Returns whether the loop started over. 
+No loop lasts more than framesInLoop_, even when held back by the MIDI sync:
+what's left carries over. */
+
+bool advance_(std::atomic<int>& frame, double& offset)
+{
+	double pos = getBeatPos_(frame.load() + 1, offset);
+	if (pos + beatStep_ / 2 < beats_ && frame.load() + 1 < framesInLoop_) {
+		frame++;
+		return false;
+	}
+	offset = pos - beats_;
+	if (offset >= beatStep_ / 2)  // Way past the end, e.g. after a tempo change
+		offset = 0.0;
+	frame.store(0);
+	return true;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void setCurrentFrame_(Frame f)
+{
+	currentFrame_.store(f);
+	loopOffset_ = 0.0;
+	updateBoundaries_();
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+/* toBeats_
+Position of the MIDI master in beats within the loop, given its position in 
+beats (MIDI clock) or seconds (MTC). */
+
+double toBeats_(double position, bool mtc)
+{
+	double beats = mtc ? position * conf::samplerate / framesInBeatExact_ : position;
+	beats = std::fmod(beats, beats_);
+	return beats < 0.0 ? beats + beats_ : beats;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+/* relocateToMidiSync_
+Moves the sequencer right where the MIDI master is. On start and song position
+only: the playhead jumps. */
+
+void relocateToMidiSync_(double position, bool mtc)
+{
+	setCurrentFrame_(std::lround(toBeats_(position, mtc) * framesInBeatExact_) % framesInLoop_);
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+/* steerToMidiSync_
+Phase-locked loop: pulls the sequencer phase towards the master's a bit at a 
+time, by nudging the fractional position (loopOffset_). Boundaries move by 
+fractions of a frame and loops get slightly shorter or longer until the phase 
+error is gone: no frame is ever skipped. */
+
+void steerToMidiSync_(double position, bool mtc)
+{
+	double error = toBeats_(position, mtc) - getBeatPos_(currentFrame_.load(), loopOffset_);
+	if (error > beats_ / 2.0)  // Shortest way around the loop
+		error -= beats_;
+	else
+	if (error < -beats_ / 2.0)
+		error += beats_;
+
+	double slew = G_MIDI_SYNC_MAX_SLEW * beatStep_;
+	loopOffset_ += std::max(-slew, std::min(error * G_MIDI_SYNC_PLL_GAIN, slew));
+	updateBoundaries_();
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+/* startBySync_, stopBySync_
+Start and stop the sequencer on behalf of a MIDI master. Only the clock status
+changes here, the rest is posted to the worker thread. A clock waiting for the
+rec trigger is left as it is: starting it is up to c::transport::startSeq(). */
+
+void startBySync_()
+{
+	if (status_.load() == ClockStatus::STOPPED)
+		status_.store(ClockStatus::RUNNING);
+	worker::startSeq();
+}
+
+
+void stopBySync_()
+{
+	status_.store(ClockStatus::STOPPED);
+	worker::stopSeq();
 }
 
 }; // {anonymous}
@@ -85,7 +264,7 @@ void updateQuanto_()
 void init(int sampleRate, float midiTCfps)
 {
 	status_.store(ClockStatus::STOPPED);  // Must be the first thing to do
-	midiTCrate_ = (sampleRate / midiTCfps) * G_MAX_IO_CHANS;  // stereo values
+	midiTCstep_ = static_cast<double>(midiTCfps) / sampleRate;
 	bpm_        = G_DEFAULT_BPM;
 	bars_       = G_DEFAULT_BARS;
 	beats_      = G_DEFAULT_BEATS;
@@ -111,7 +290,13 @@ bool isActive()
 
 bool quantoHasPassed()
 {
-	return currentFrame_.load() % (quanto_) == 0;
+	return onQuanto_.load();
+}
+
+
+bool quantoHasPassed(Frame f)
+{
+	return quantize_.load() == 0 || crosses_(getBeatPos_(f, 0.0), 1.0 / quantize_.load());
 }
 
 
@@ -119,15 +304,21 @@ bool isOnBar()
 {
 	if (status_.load() == ClockStatus::WAITING)
 		return false;
-	return currentFrame_.load() % framesInBar_ == 0;
+	return onBar_.load();
+}
+
+
+bool isOnBar(Frame f)
+{
+	return crosses_(getBeatPos_(f, 0.0), beats_ / bars_);
 }
 
 
 bool isOnBeat()
 {
 	if (status_.load() == ClockStatus::WAITING)
-		return currentFrameWait_.load() % framesInBeat_ == 0;
-	return currentFrame_.load() % framesInBeat_ == 0;
+		return onBeatWait_.load();
+	return onBeat_.load();
 }
 
 
@@ -180,6 +371,7 @@ void setQuantize(int q)
 {
 	quantize_.store(q);
 	updateQuanto_();
+	updateBoundaries_();
 }
 
 
@@ -204,31 +396,39 @@ void setStatus(ClockStatus s)
 /* -------------------------------------------------------------------------- */
 
 
+void beginBlock(Frame first)
+{
+	blockFrame_ = first;
+	wrapFrame_  = -1;
+}
+
+
+Frame getWrapFrame()
+{
+	return wrapFrame_;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
 void incrCurrentFrame() 
 {
-	if (status_.load() == ClockStatus::WAITING) {
-		currentFrameWait_++;
-		if (currentFrameWait_.load() >= framesInLoop_)
-			currentFrameWait_ = 0;
-	}
-	else {
-		currentFrame_++;
-		if (currentFrame_.load() >= framesInLoop_) {
-			currentFrame_.store(0);
-			currentBeat_.store(0);
-		}
-		else
-		if (isOnBeat())
-			currentBeat_++;
-	}
+	blockFrame_++;
+	if (status_.load() == ClockStatus::WAITING)
+		advance_(currentFrameWait_, loopOffsetWait_);
+	else
+	if (advance_(currentFrame_, loopOffset_))
+		wrapFrame_ = blockFrame_;
+	updateBoundaries_();
 }
 
 
 void rewind()
 {
 	currentFrameWait_.store(0);
-	currentFrame_.store(0);
-	currentBeat_.store(0);
+	loopOffsetWait_ = 0.0;
+	setCurrentFrame_(0);
 	sendMIDIrewind();
 }
 
@@ -239,35 +439,40 @@ void rewind()
 void updateFrameBars()
 {
 	/* framesInLoop_ ... loop length in frames, or samplerate * # frames per 
-	 *                  current bpm_ * beats_;
-	 * framesInBar_ .... n. of frames within a bar;
-	 * framesInBeat_ ... n. of frames within a beat;
-	 * framesInSeq_ .... number of frames in the whole sequencer. */
+	 *                  current bpm_ * beats_, rounded up: no loop is longer;
+	 * framesInBar_ .... n. of frames within a bar, rounded;
+	 * framesInBeat_ ... n. of frames within a beat, rounded;
+	 * framesInSeq_ .... number of frames in the whole sequencer, rounded. 
+	 * The clock itself runs on framesInBeatExact_. */
 
-	framesInLoop_ = (conf::samplerate * (60.0f / bpm_)) * beats_;
-	framesInBar_  = framesInLoop_ / bars_;
-	framesInBeat_ = framesInLoop_ / beats_;
-	framesInSeq_  = framesInBeat_ * G_MAX_BEATS;
+	framesInBeatExact_ = conf::samplerate * (60.0 / bpm_);
+	beatStep_          = 1.0 / framesInBeatExact_;
+
+	framesInLoop_ = std::ceil(framesInBeatExact_ * beats_ - 0.000001);
+	framesInBar_  = std::lround(framesInBeatExact_ * beats_ / bars_);
+	framesInBeat_ = std::lround(framesInBeatExact_);
+	framesInSeq_  = std::lround(framesInBeatExact_ * G_MAX_BEATS);
 
 	updateQuanto_();
+	updateBoundaries_();
 }
 
 
 /* -------------------------------------------------------------------------- */
 
 
-void sendMIDIsync()
+void sendMIDIsync(Frame localFrame)
 {
 	/* Sending MIDI sync while waiting is meaningless. */
 
 	if (status_.load() == ClockStatus::WAITING)
 		return;
 
-	/* TODO - only Master (_M) is implemented so far. */
+	/* Master modes only: slaves are driven by recvMidiSync(). */
 
 	if (conf::midiSync == MIDI_SYNC_CLOCK_M) {
-		if (currentFrame_.load() % (framesInBeat_/24) == 0)
-			kernelMidi::send(MIDI_CLOCK, -1, -1);
+		if (onMidiClock_.load())
+			kernelMidi::send(MIDI_CLOCK, -1, -1, localFrame);
 		return;
 	}
 
@@ -278,8 +483,10 @@ void sendMIDIsync()
 		 * 1-4 and 5-8. We check timecode frame's parity: if even, send
 		 * range 1-4, if odd send 5-8. */
 
-		if (currentFrame_.load() % midiTCrate_ != 0)  // no timecode frame passed
-			return;
+		double phase = midiTCphase_;
+		midiTCphase_ += midiTCstep_;
+		if (std::floor(phase + midiTCstep_ / 2) == std::floor(phase - midiTCstep_ / 2))
+			return;  // no timecode frame passed
 
 		/* frame low nibble
 		 * frame high nibble
@@ -287,10 +494,10 @@ void sendMIDIsync()
 		 * seconds high nibble */
 
 		if (midiTCframes_ % 2 == 0) {
-			kernelMidi::send(MIDI_MTC_QUARTER, (midiTCframes_ & 0x0F)  | 0x00, -1);
-			kernelMidi::send(MIDI_MTC_QUARTER, (midiTCframes_ >> 4)    | 0x10, -1);
-			kernelMidi::send(MIDI_MTC_QUARTER, (midiTCseconds_ & 0x0F) | 0x20, -1);
-			kernelMidi::send(MIDI_MTC_QUARTER, (midiTCseconds_ >> 4)   | 0x30, -1);
+			kernelMidi::send(MIDI_MTC_QUARTER, (midiTCframes_ & 0x0F)  | 0x00, -1, localFrame);
+			kernelMidi::send(MIDI_MTC_QUARTER, (midiTCframes_ >> 4)    | 0x10, -1, localFrame);
+			kernelMidi::send(MIDI_MTC_QUARTER, (midiTCseconds_ & 0x0F) | 0x20, -1, localFrame);
+			kernelMidi::send(MIDI_MTC_QUARTER, (midiTCseconds_ >> 4)   | 0x30, -1, localFrame);
 		}
 
 		/* minutes low nibble
@@ -299,10 +506,10 @@ void sendMIDIsync()
 		 * hours high nibble SMPTE frame rate */
 
 		else {
-			kernelMidi::send(MIDI_MTC_QUARTER, (midiTCminutes_ & 0x0F) | 0x40, -1);
-			kernelMidi::send(MIDI_MTC_QUARTER, (midiTCminutes_ >> 4)   | 0x50, -1);
-			kernelMidi::send(MIDI_MTC_QUARTER, (midiTChours_ & 0x0F)   | 0x60, -1);
-			kernelMidi::send(MIDI_MTC_QUARTER, (midiTChours_ >> 4)     | 0x70, -1);
+			kernelMidi::send(MIDI_MTC_QUARTER, (midiTCminutes_ & 0x0F) | 0x40, -1, localFrame);
+			kernelMidi::send(MIDI_MTC_QUARTER, (midiTCminutes_ >> 4)   | 0x50, -1, localFrame);
+			kernelMidi::send(MIDI_MTC_QUARTER, (midiTChours_ & 0x0F)   | 0x60, -1, localFrame);
+			kernelMidi::send(MIDI_MTC_QUARTER, (midiTChours_ >> 4)     | 0x70, -1, localFrame);
 		}
 
 		midiTCframes_++;
@@ -310,7 +517,7 @@ void sendMIDIsync()
 		/* check if total timecode frames are greater than timecode fps:
 		 * if so, a second has passed */
 
-		if (midiTCframes_ > conf::midiTCfps) {
+		if (midiTCframes_ >= conf::midiTCfps) {
 			midiTCframes_ = 0;
 			midiTCseconds_++;
 			if (midiTCseconds_ >= 60) {
@@ -332,6 +539,7 @@ void sendMIDIsync()
 
 void sendMIDIrewind()
 {
+	midiTCphase_   = 0.0;
 	midiTCframes_  = 0;
 	midiTCseconds_ = 0;
 	midiTCminutes_ = 0;
@@ -370,9 +578,12 @@ void recvJackSync()
 				c::transport::stopSeq(false); // not from UI
 		}
 	}
+	/* Audio thread here: only the clock is updated in place, everything else
+	is deferred to the worker thread. */
+
 	if (jackState.bpm != jackStatePrev_.bpm)
 		if (jackState.bpm > 1.0f)  // 0 bpm if Jack does not send that info
-			c::main::setBpm(jackState.bpm);
+			worker::setBpm(jackState.bpm);
 
 	if (jackState.frame == 0 && jackState.frame != jackStatePrev_.frame)
 		c::transport::rewindSeq(false, false);  // not from UI, don't notify jack (avoid loop)
@@ -386,6 +597,87 @@ void recvJackSync()
 /* -------------------------------------------------------------------------- */
 
 
+bool recvMidiSync()
+{
+	if (conf::midiSync != MIDI_SYNC_CLOCK_S && conf::midiSync != MIDI_SYNC_MTC_S)
+		return false;
+
+	bool mtc    = conf::midiSync == MIDI_SYNC_MTC_S;
+	bool rewind = false;
+
+	midiSync::Event e;
+	while (midiSync::getEvent(e)) {
+		switch (e.type) {
+			case midiSync::Event::Type::START:
+				rewind = e.position == 0.0;
+				relocateToMidiSync_(e.position, mtc);
+				if (!isRunning())
+					startBySync_();
+				break;
+			case midiSync::Event::Type::STOP:
+				if (isRunning())
+					stopBySync_();
+				break;
+			case midiSync::Event::Type::POSITION:
+				rewind = false;
+				relocateToMidiSync_(e.position, mtc);
+				break;
+			case midiSync::Event::Type::TICK:
+				midiSyncTick_    = e;
+				midiSyncHasTick_ = true;
+				break;
+		}
+	}
+
+	if (!midiSyncHasTick_)
+		return rewind;
+
+	double now = midiSync::getTime();
+
+	/* MTC carries no start nor stop: the sequencer runs as long as quarter 
+	frames keep coming. MIDI clock carries the tempo instead, changed through 
+	the worker as Jack does, but only when the master has really moved: the PLL
+	below absorbs the jitter. The clock gets the tempo as estimated, not 
+	rounded: only the UI shows it rounded. */
+
+	if (mtc) {
+		if (now - midiSyncTick_.time > G_MIDI_SYNC_TIMEOUT) {
+			if (isRunning())
+				stopBySync_();
+			midiSyncHasTick_ = false;
+			return rewind;
+		}
+		if (!isRunning())
+			startBySync_();
+	}
+	else {
+		float bpm = 60.0 / (midiSyncTick_.period * G_MIDI_CLOCK_PPQ);
+		if (std::abs(bpm - bpm_) < G_MIDI_SYNC_BPM_STEP)
+			midiSyncBpmTime_ = now;
+		else
+		if (now - midiSyncBpmTime_ >= G_MIDI_SYNC_BPM_HOLD) {
+			worker::setBpm(bpm);
+			midiSyncBpmTime_ = now;
+		}
+	}
+
+	if (!isRunning())
+		return rewind;
+
+	/* Where the master is right now, extrapolated from its last tick with the
+	unrounded tick period. */
+
+	double elapsed  = now - midiSyncTick_.time;
+	double position = mtc ? midiSyncTick_.position + elapsed : 
+		midiSyncTick_.position + elapsed / (midiSyncTick_.period * G_MIDI_CLOCK_PPQ);
+	steerToMidiSync_(position, mtc);
+	return rewind;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
 bool canQuantize()
 {
 	return getQuantize() > 0 && isRunning();
@@ -466,4 +758,30 @@ ClockStatus getStatus()
 	return status_;
 }
 
+
+/* -------------------------------------------------------------------------- */
+
+
+Tick frameToTick(Frame f)
+{
+	return frameToTick(f, framesInBeatExact_);
+}
+
+
+Tick frameToTick(Frame f, double framesInBeat)
+{
+	/* Round up here and down in tickToFrame(): as long as a beat has less 
+	frames than G_PPQ ticks, a round trip gives back the original frame. The
+	small bias in tickToFrame() absorbs floating point errors. */
+
+	assert(framesInBeat > 0);
+	return std::ceil(((double) f * G_PPQ) / framesInBeat);
+}
+
+
+Frame tickToFrame(Tick t)
+{
+	return std::floor(((double) t * framesInBeatExact_) / G_PPQ + 0.000001);
+}
+
 }}}; // giada::m::clock::
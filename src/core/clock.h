@@ -39,9 +39,10 @@ namespace clock
 void init(int sampleRate, float midiTCfps);
 
 /* sendMIDIsync
-Generates MIDI sync output data. */
+Generates MIDI sync output data. 'localFrame' is the current frame within the
+audio block, used to timestamp outgoing messages. */
 
-void sendMIDIsync();
+void sendMIDIsync(Frame localFrame);
 
 /* sendMIDIrewind
 Rewinds timecode to beat 0 and also send a MTC full frame to cue the slave. */
@@ -52,6 +53,15 @@ void sendMIDIrewind();
 void recvJackSync();
 #endif
 
+/* recvMidiSync
+Follows an external MIDI clock or MTC master, if Giada is a slave: applies the
+start, stop, tempo and position changes collected by midiSync. Audio thread 
+only: just the clock changes in place, the rest of start and stop (Jack, input
+recording, UI) is left to the worker thread. Returns true if the master asked 
+for a rewind, which the caller must carry out on channels too. */
+
+bool recvMidiSync();
+
 float getBpm();
 int getBeats();
 int getBars();
@@ -65,15 +75,43 @@ int getQuantize();
 int getQuanto();
 ClockStatus getStatus();
 
+/* frameToTick (1), (2)
+Converts a frame into musical time (G_PPQ ticks per beat), according to the 
+current tempo or to a custom beat length 'framesInBeat'. */
+
+Tick frameToTick(Frame f);
+Tick frameToTick(Frame f, double framesInBeat);
+
+/* tickToFrame
+Converts musical time back to frames, according to the current tempo. */
+
+Frame tickToFrame(Tick t);
+
 /* incrCurrentFrame
 Increases current frame of a single step (+1). */
 
 void incrCurrentFrame();
 
-/* quantoHasPassed
-Tells whether a quanto unit has passed yet. */
+/* beginBlock
+Starts a new audio block, whose first clock step is frame 'first' within the
+block. Call it before the first incrCurrentFrame() of each block. */
+
+void beginBlock(Frame first);
+
+/* getWrapFrame
+Frame within the current audio block where the loop started over by itself, or
+-1 if it didn't (jumps such as rewind don't count). Loops last one frame more 
+or less from time to time with fractional tempos: never count frames with 
+getFramesInLoop() to find out when the next loop starts. Audio thread only. */
+
+Frame getWrapFrame();
+
+/* quantoHasPassed (1), (2)
+Tells whether a quanto unit has passed yet (1), or whether one falls on frame 
+'f' of a loop (2), with the same rounding of the running clock. */
 
 bool quantoHasPassed();
+bool quantoHasPassed(Frame f);
 
 /* quantoHasPassed
 Whether the quantizer value is > 0 and the clock is running. */
@@ -102,9 +140,14 @@ ClockStatus == WAITING. */
 bool isActive();
 
 bool isOnBeat();
-bool isOnBar();
 bool isOnFirstBeat();
 
+/* isOnBar (1), (2)
+Whether the current frame (1) or frame 'f' of a loop (2) is on a bar. */
+
+bool isOnBar();
+bool isOnBar(Frame f);
+
 void rewind();
 void setStatus(ClockStatus s);
 }}}; // giada::m::clock::
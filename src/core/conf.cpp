@@ -105,6 +105,9 @@ void sanitize()
 	if (aboutY < 0) aboutY = 0;
 	if (samplerate < 8000) samplerate = G_DEFAULT_SAMPLERATE;
 	if (rsmpQuality < 0 || rsmpQuality > 4) rsmpQuality = 0;
+	if (recTriggerLookback < 0 || recTriggerLookback > G_MAX_REC_TRIGGER_LOOKBACK) recTriggerLookback = G_DEFAULT_REC_TRIGGER_LOOKBACK;
+	if (recLatency < 0 || recLatency > samplerate) recLatency = 0;
+	if (retroCaptureBudget < 1 || retroCaptureBudget > G_MAX_RETRO_CAPTURE_BUDGET) retroCaptureBudget = G_DEFAULT_RETRO_CAPTURE_BUDGET;
 }
 
 
@@ -159,6 +162,7 @@ int  channelsIn     = 0;
 int  samplerate     = G_DEFAULT_SAMPLERATE;
 int  buffersize     = G_DEFAULT_BUFSIZE;
 bool limitOutput    = false;
+bool jackDirectOuts = false;
 int  rsmpQuality    = 0;
 
 int    midiSystem  = 0;
@@ -250,6 +254,11 @@ int nameY = 0;
 
 int   recTriggerMode  = static_cast<int>(RecTriggerMode::NORMAL);
 float recTriggerLevel = G_DEFAULT_REC_TRIGGER_LEVEL;
+int   recTriggerLookback = G_DEFAULT_REC_TRIGGER_LOOKBACK;
+int   recLatency         = 0;
+
+bool retroCapture       = false;
+int  retroCaptureBudget = G_DEFAULT_RETRO_CAPTURE_BUDGET;
 
 #ifdef WITH_VST
 
@@ -323,6 +332,7 @@ int read()
 	if (!storager::setInt(jRoot, CONF_KEY_SAMPLERATE, samplerate)) return 0;
 	if (!storager::setInt(jRoot, CONF_KEY_BUFFER_SIZE, buffersize)) return 0;
 	if (!storager::setBool(jRoot, CONF_KEY_LIMIT_OUTPUT, limitOutput)) return 0;
+	if (!storager::setBool(jRoot, CONF_KEY_JACK_DIRECT_OUTS, jackDirectOuts)) return 0;
 	if (!storager::setInt(jRoot, CONF_KEY_RESAMPLE_QUALITY, rsmpQuality)) return 0;
 	if (!storager::setInt(jRoot, CONF_KEY_MIDI_SYSTEM, midiSystem)) return 0;
 	if (!storager::setInt(jRoot, CONF_KEY_MIDI_PORT_OUT, midiPortOut)) return 0;
@@ -396,6 +406,10 @@ int read()
 	if (!storager::setInt(jRoot, CONF_KEY_MIDI_INPUT_H, midiInputH)) return 0;
 	if (!storager::setInt(jRoot, CONF_KEY_REC_TRIGGER_MODE, recTriggerMode)) return 0;
 	if (!storager::setFloat(jRoot, CONF_KEY_REC_TRIGGER_LEVEL, recTriggerLevel)) return 0;
+	if (!storager::setInt(jRoot, CONF_KEY_REC_TRIGGER_LOOKBACK, recTriggerLookback)) return 0;
+	if (!storager::setInt(jRoot, CONF_KEY_REC_LATENCY, recLatency)) return 0;
+	if (!storager::setBool(jRoot, CONF_KEY_RETRO_CAPTURE, retroCapture)) return 0;
+	if (!storager::setInt(jRoot, CONF_KEY_RETRO_CAPTURE_BUDGET, retroCaptureBudget)) return 0;
 
 #ifdef WITH_VST
 
@@ -435,6 +449,7 @@ int write()
 	json_object_set_new(jRoot, CONF_KEY_SAMPLERATE,                json_integer(samplerate));
 	json_object_set_new(jRoot, CONF_KEY_BUFFER_SIZE,               json_integer(buffersize));
 	json_object_set_new(jRoot, CONF_KEY_LIMIT_OUTPUT,              json_boolean(limitOutput));
+	json_object_set_new(jRoot, CONF_KEY_JACK_DIRECT_OUTS,          json_boolean(jackDirectOuts));
 	json_object_set_new(jRoot, CONF_KEY_RESAMPLE_QUALITY,          json_integer(rsmpQuality));
 	json_object_set_new(jRoot, CONF_KEY_MIDI_SYSTEM,               json_integer(midiSystem));
 	json_object_set_new(jRoot, CONF_KEY_MIDI_PORT_OUT,             json_integer(midiPortOut));
@@ -508,6 +523,10 @@ int write()
 	json_object_set_new(jRoot, CONF_KEY_MIDI_INPUT_H,              json_integer(midiInputH));
 	json_object_set_new(jRoot, CONF_KEY_REC_TRIGGER_MODE,          json_integer(recTriggerMode));
 	json_object_set_new(jRoot, CONF_KEY_REC_TRIGGER_LEVEL,         json_real(recTriggerLevel));
+	json_object_set_new(jRoot, CONF_KEY_REC_TRIGGER_LOOKBACK,      json_integer(recTriggerLookback));
+	json_object_set_new(jRoot, CONF_KEY_REC_LATENCY,               json_integer(recLatency));
+	json_object_set_new(jRoot, CONF_KEY_RETRO_CAPTURE,             json_boolean(retroCapture));
+	json_object_set_new(jRoot, CONF_KEY_RETRO_CAPTURE_BUDGET,      json_integer(retroCaptureBudget));
 
 #ifdef WITH_VST
 
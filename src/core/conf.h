@@ -57,6 +57,7 @@ extern int  channelsIn;
 extern int  samplerate;
 extern int  buffersize;
 extern bool limitOutput;
+extern bool jackDirectOuts;
 extern int  rsmpQuality;
 
 extern int  midiSystem;
@@ -116,6 +117,11 @@ extern int nameX, nameY;
 
 extern int   recTriggerMode;
 extern float recTriggerLevel;
+extern int   recTriggerLookback;  // ms
+extern int   recLatency;          // round-trip, frames
+
+extern bool retroCapture;
+extern int  retroCaptureBudget;  // MB
 
 #ifdef WITH_VST
 
@@ -113,6 +113,67 @@ constexpr int   G_MAX_IO_CHANS     = 2;
 constexpr int   G_MAX_VELOCITY     = 0x7F;
 constexpr int   G_MAX_MIDI_CHANS   = 16;
 constexpr int   G_MAX_POLYPHONY    = 32;
+constexpr int   G_MAX_PLUGIN_MIDI_EVENTS = 1024;  // per channel, per block
+constexpr int   G_MAX_PLUGIN_QUEUED_PARAMS = 256; // per plug-in, per block
+constexpr int   G_MAX_PLUGIN_TAIL  = 60;    // s, longer means 'infinite'
+constexpr int   G_MAX_STATE_CHANS  = 512;
+constexpr int   G_MAX_REC_TRIGGER_LOOKBACK = 500;  // ms
+constexpr int   G_MAX_RETRO_CAPTURE_BUDGET = 4096; // MB
+
+/* G_PLUGIN_IDLE_*
+An effect is skipped when its input and output have been below the silence 
+threshold (~ -90 dB) for longer than its tail, and never before the hold time 
+(ms). Only effects reporting a finite, non-zero tail are skipped: a zero tail 
+often means 'unknown' or a self-generating effect. */
+constexpr float G_PLUGIN_IDLE_THRESHOLD = 0.00003f;
+constexpr int   G_PLUGIN_IDLE_HOLD      = 500;
+
+/* G_SMOOTHING_FRAMES
+Length of the ramp that volume changes go through, so that MIDI controllers 
+and knobs don't produce zipper noise (10 ms at 44.1 kHz). */
+constexpr int   G_SMOOTHING_FRAMES = 441;
+
+/* -- Musical time ---------------------------------------------------------- */
+/* G_PPQ
+Ticks per quarter note (i.e. per beat). Must be greater than the longest beat
+in frames (192000 Hz at G_MIN_BPM), so that frame -> tick -> frame conversions
+are lossless. */
+constexpr int   G_PPQ              = 960000;
+
+
+
+/* -- worker ---------------------------------------------------------------- */
+constexpr int G_WORKER_RATE = 10;  // worker thread polling interval, ms
+
+
+
+/* -- input recording ------------------------------------------------------- */
+constexpr int  G_TAKE_RING_SECONDS = 2;  // audio -> take writer queue length
+constexpr auto G_TAKES_DIR         = "takes";
+
+/* G_LATENCY_PROBE_*
+Round-trip latency measurement: impulse amplitude, detection threshold above
+the noise floor (dB) and how long to wait for the impulse to come back (ms). */
+constexpr float G_LATENCY_PROBE_LEVEL     = 0.5f;
+constexpr float G_LATENCY_PROBE_THRESHOLD = 20.0f;
+constexpr int   G_LATENCY_PROBE_TIMEOUT   = 2000;
+
+
+
+/* -- plug-ins ------------------------------------------------------------- */
+/* G_PLUGIN_SCAN_*
+Each plug-in file is scanned by a separate Giada process, started with 
+G_PLUGIN_SCAN_ARG. Processes taking longer than G_PLUGIN_SCAN_TIMEOUT (ms) are
+killed and the file is blacklisted. */
+constexpr auto G_PLUGIN_SCAN_ARG     = "--scan-plugin";
+constexpr int  G_PLUGIN_SCAN_TIMEOUT = 20000;
+
+/* G_PLUGIN_LOAD_*
+Plug-ins from a patch are loaded in background. The main thread creates the 
+instances every G_PLUGIN_LOAD_RATE (s), for no longer than G_PLUGIN_LOAD_BUDGET
+(ms) each time. */
+constexpr double G_PLUGIN_LOAD_RATE   = 0.02;
+constexpr int    G_PLUGIN_LOAD_BUDGET = 40;
 
 
 
@@ -127,11 +188,21 @@ constexpr int G_SYS_API_PULSE  = 0x20;  // 0010 0000
 constexpr int G_SYS_API_WASAPI = 0x40;  // 0100 0000
 constexpr int G_SYS_API_ANY    = 0x7F;  // 0111 1111
 
+/* G_JACK_RECONNECT_RATE
+How often (s) Giada tries to reconnect to a JACK server that has shut down. */
+constexpr double G_JACK_RECONNECT_RATE = 2.0;
+
 
 
 /* -- kernel midi ----------------------------------------------------------- */
 constexpr int G_MIDI_API_JACK = 0x01;  // 0000 0001
 constexpr int G_MIDI_API_ALSA = 0x02;  // 0000 0010
+constexpr int G_MIDI_OUT_QUEUE_SIZE = 1024;  // messages, power of two
+constexpr int G_MIDI_IN_QUEUE_SIZE  = 1024;  // messages, power of two (JACK MIDI)
+constexpr int G_MIDI_OUT_RATE       = 1;     // ms, sender thread polling
+constexpr int G_MIDI_LIGHTNING_RATE  = 10;   // ms, between LED updates
+constexpr int G_MIDI_LIGHTNING_BURST = 8;    // max LED messages per update (DIN MIDI: ~1000 msg/s)
+constexpr double G_MIDI_RECLAIM_RATE = 0.01;  // s, between checks for deleted channels
 
 
 
@@ -169,6 +240,8 @@ constexpr int   G_DEFAULT_MIDI_INPUT_UI_H   = 350;
 constexpr int   G_DEFAULT_ACTION_SIZE       = 8192;  // frames
 constexpr int   G_DEFAULT_ZOOM_RATIO        = 128;
 constexpr float G_DEFAULT_REC_TRIGGER_LEVEL = -10.0f;
+constexpr int   G_DEFAULT_REC_TRIGGER_LOOKBACK = 10;  // ms
+constexpr int   G_DEFAULT_RETRO_CAPTURE_BUDGET = 64;  // MB
 
 
 
@@ -259,6 +332,23 @@ constexpr int G_MIDI_CHANS[G_MAX_MIDI_CHANS] = {
 #define MIDI_SYNC_MTC_M     0x04  // master
 #define MIDI_SYNC_MTC_S     0x08  // slave
 
+/* G_MIDI_SYNC_*
+Slave mode tuning. Incoming ticks go through a delay-locked loop of the given
+bandwidth (Hz). The tempo follows the master when it stays at least BPM_STEP
+away for BPM_HOLD s: shorter deviations are just jitter. The phase is steered 
+towards the master's: PLL_GAIN is the share of the phase error corrected on 
+each audio block, MAX_SLEW the largest correction (frames per block). The 
+sequencer stops when no MTC arrives for TIMEOUT s. */
+
+constexpr int    G_MIDI_CLOCK_PPQ       = 24;
+constexpr double G_MIDI_SYNC_BANDWIDTH  = 1.0;
+constexpr float  G_MIDI_SYNC_BPM_STEP   = 0.1f;
+constexpr double G_MIDI_SYNC_BPM_HOLD   = 0.5;
+constexpr double G_MIDI_SYNC_PLL_GAIN   = 0.05;
+constexpr double G_MIDI_SYNC_MAX_SLEW   = 1.0;
+constexpr double G_MIDI_SYNC_TIMEOUT    = 0.25;
+constexpr int    G_MIDI_SYNC_QUEUE_SIZE = 256;  // events, power of two
+
 /* JSON patch keys */
 
 constexpr auto PATCH_KEY_HEADER                       = "header";
@@ -326,6 +416,7 @@ constexpr auto PATCH_KEY_ACTION_I_VALUE               = "i_value";
 constexpr auto PATCH_KEY_PLUGIN_PATH                  = "path";
 constexpr auto PATCH_KEY_PLUGIN_BYPASS                = "bypass";
 constexpr auto PATCH_KEY_PLUGIN_PARAMS                = "params";
+constexpr auto PATCH_KEY_PLUGIN_STATE                 = "state";
 constexpr auto PATCH_KEY_PLUGIN_MIDI_IN_PARAMS        = "midi_in_params";
 constexpr auto PATCH_KEY_COLUMN_INDEX                 = "index";
 constexpr auto PATCH_KEY_COLUMN_WIDTH                 = "width";
@@ -350,6 +441,7 @@ constexpr auto CONF_KEY_SAMPLERATE               = "samplerate";
 constexpr auto CONF_KEY_BUFFER_SIZE              = "buffer_size";
 constexpr auto CONF_KEY_DELAY_COMPENSATION       = "delay_compensation";
 constexpr auto CONF_KEY_LIMIT_OUTPUT             = "limit_output";
+constexpr auto CONF_KEY_JACK_DIRECT_OUTS         = "jack_direct_outs";
 constexpr auto CONF_KEY_RESAMPLE_QUALITY         = "resample_quality";
 constexpr auto CONF_KEY_MIDI_SYSTEM              = "midi_system";
 constexpr auto CONF_KEY_MIDI_PORT_OUT            = "midi_port_out";
@@ -428,6 +520,10 @@ constexpr auto CONF_KEY_MIDI_INPUT_H             = "midi_input_h";
 constexpr auto CONF_KEY_PLUGIN_SORT_METHOD       = "plugin_sort_method";
 constexpr auto CONF_KEY_REC_TRIGGER_MODE         = "rec_trigger_mode";
 constexpr auto CONF_KEY_REC_TRIGGER_LEVEL        = "rec_trigger_level";
+constexpr auto CONF_KEY_REC_TRIGGER_LOOKBACK     = "rec_trigger_lookback";
+constexpr auto CONF_KEY_RETRO_CAPTURE            = "retro_capture";
+constexpr auto CONF_KEY_RETRO_CAPTURE_BUDGET     = "retro_capture_budget";
+constexpr auto CONF_KEY_REC_LATENCY              = "rec_latency";
 
 /* JSON midimaps keys */
 
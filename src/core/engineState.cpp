@@ -0,0 +1,189 @@
+/* -----------------------------------------------------------------------------
+ *
+ * Giada - Your Hardcore Loopmachine
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2019 Giovanni A. Zuliani | Monocasual
+ *
+ * This file is part of Giada - Your Hardcore Loopmachine.
+ *
+ * Giada - Your Hardcore Loopmachine is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * Giada - Your Hardcore Loopmachine is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Giada - Your Hardcore Loopmachine. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------------- */
+
+
+#include <atomic>
+#include <vector>
+#include <algorithm>
+#include "../utils/log.h"
+#include "mixer.h"
+#include "clock.h"
+#include "channel.h"
+#include "sampleChannel.h"
+#include "pluginHost.h"
+#include "recorder.h"
+#include "engineState.h"
+
+
+namespace giada {
+namespace m {
+namespace engineState
+{
+namespace
+{
+/* Triple buffer: the audio thread owns back_, the GUI thread owns front_, and
+the two swap their buffer with middle_ when needed. DIRTY_ flags a middle
+buffer that has been published but not fetched yet. */
+
+constexpr int INDEX_MASK_ = 0x3;
+constexpr int DIRTY_      = 0x4;
+
+State states_[3];
+
+int back_  = 0;
+int front_ = 2;
+alignas(64) std::atomic<int> middle_(1);
+
+/* slots_
+Front buffer's channels as (Channel::index, position) pairs, sorted by 
+Channel::index for getChannel(). GUI thread only. */
+
+std::vector<std::pair<int, int>> slots_;
+
+/* dropped_
+Channels left out of the last fetched snapshot, to warn only on changes. GUI
+thread only. */
+
+int dropped_ = 0;
+
+
+/* -------------------------------------------------------------------------- */
+
+/* indexFront_
+Rebuilds slots_ for a new front buffer. Warns if channels have been left out
+of it, which the audio thread can't do by itself. */
+
+void indexFront_()
+{
+	const State& s = states_[front_];
+
+	slots_.clear();
+	slots_.reserve(G_MAX_STATE_CHANS);
+	for (int i=0; i<s.channelsCount; i++)
+		slots_.push_back({ s.channels[i].index, i });
+	std::sort(slots_.begin(), slots_.end());
+
+	if (s.channelsDropped > 0 && s.channelsDropped != dropped_)
+		gu_log("[engineState] too many channels, %d not shown (max %d)\n", 
+			s.channelsDropped, G_MAX_STATE_CHANS);
+	dropped_ = s.channelsDropped;
+}
+} // {anonymous}
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+
+void writeChannels()
+{
+	State& s = states_[back_];
+
+	s.channelsCount   = 0;
+	s.channelsDropped = 0;
+	for (const Channel* ch : mixer::channels) {
+		if (s.channelsCount == G_MAX_STATE_CHANS) {
+			s.channelsDropped++;
+			continue;
+		}
+		ChannelState& cs = s.channels[s.channelsCount++];
+		cs.index     = ch->index;
+		cs.status    = ch->status;
+		cs.recStatus = ch->recStatus;
+		cs.armed     = ch->armed;
+		if (ch->type == ChannelType::SAMPLE) {
+			const SampleChannel* sch = static_cast<const SampleChannel*>(ch);
+			cs.position       = sch->getPosition();
+			cs.trackerPreview = sch->trackerPreview;
+		}
+		else {
+			cs.position       = -1;
+			cs.trackerPreview = 0;
+		}
+	}
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void publish()
+{
+	State& s = states_[back_];
+
+	s.peakOut         = mixer::peakOut.load(std::memory_order_relaxed);
+	s.peakIn          = mixer::peakIn.load(std::memory_order_relaxed);
+	s.clockStatus     = clock::getStatus();
+	s.currentBeat     = clock::getCurrentBeat();
+	s.currentFrame    = clock::getCurrentFrame();
+	s.recording       = mixer::recording;
+	s.actionRecording = recorder::isActive();
+#ifdef WITH_VST
+	pluginHost::Stats stats = pluginHost::getStats();
+	s.pluginsProcessed = stats.processed;
+	s.pluginsSkipped   = stats.skipped;
+#else
+	s.pluginsProcessed = 0;
+	s.pluginsSkipped   = 0;
+#endif
+
+	back_ = middle_.exchange(back_ | DIRTY_, std::memory_order_acq_rel) & INDEX_MASK_;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void fetch()
+{
+	if ((middle_.load(std::memory_order_relaxed) & DIRTY_) == 0)
+		return;
+	front_ = middle_.exchange(front_, std::memory_order_acq_rel) & INDEX_MASK_;
+	indexFront_();
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+const State& get()
+{
+	return states_[front_];
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+const ChannelState* getChannel(const Channel* ch)
+{
+	auto it = std::lower_bound(slots_.begin(), slots_.end(), std::make_pair(ch->index, 0));
+	if (it == slots_.end() || it->first != ch->index)
+		return nullptr;
+	return &states_[front_].channels[it->second];
+}
+}}}; // giada::m::engineState::
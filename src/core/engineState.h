@@ -0,0 +1,112 @@
+/* -----------------------------------------------------------------------------
+ *
+ * Giada - Your Hardcore Loopmachine
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2019 Giovanni A. Zuliani | Monocasual
+ *
+ * This file is part of Giada - Your Hardcore Loopmachine.
+ *
+ * Giada - Your Hardcore Loopmachine is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * Giada - Your Hardcore Loopmachine is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Giada - Your Hardcore Loopmachine. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------------- */
+
+
+#ifndef G_ENGINE_STATE_H
+#define G_ENGINE_STATE_H
+
+
+#include "types.h"
+#include "const.h"
+
+
+namespace giada {
+namespace m 
+{
+class Channel;
+
+namespace engineState
+{
+struct ChannelState
+{
+	int           index;          // Channel::index (unique id)
+	ChannelStatus status;
+	ChannelStatus recStatus;
+	Frame         position;       // tracker - begin, -1 if not playing
+	Frame         trackerPreview;
+	bool          armed;
+};
+
+/* State
+Compact, read-only picture of the engine taken at the end of each audio block. 
+Channels are stored in the same order as mixer::channels, up to 
+G_MAX_STATE_CHANS: 'channelsDropped' counts those left out. */
+
+struct alignas(64) State
+{
+	float       peakOut;
+	float       peakIn;
+	ClockStatus clockStatus;
+	int         currentBeat;
+	Frame       currentFrame;
+	bool        recording;
+	bool        actionRecording;  // recorder::isActive()
+	int         pluginsProcessed; // plug-ins run in the last block
+	int         pluginsSkipped;   // plug-ins skipped in the last block (idle)
+	int         channelsCount;
+	int         channelsDropped;
+	ChannelState channels[G_MAX_STATE_CHANS];
+};
+
+/* -- Audio thread ---------------------------------------------------------- */
+
+/* writeChannels
+Copies channels data into the back buffer. Must be called while holding 
+mixer::mutex, so that the channel list can't change in the meantime. */
+
+void writeChannels();
+
+/* publish
+Fills in the remaining global data (peaks, clock) and hands the back buffer 
+over to the readers. Wait-free, call it once per block. */
+
+void publish();
+
+/* -- GUI thread ------------------------------------------------------------ */
+
+/* fetch
+Grabs the most recent state published by the audio thread, if any, and indexes
+its channels for getChannel(). Call it once per UI refresh cycle, with the 
+FLTK lock held. */
+
+void fetch();
+
+/* get
+Returns the state grabbed by the last call to fetch(). Valid until the next 
+fetch(): read it with the FLTK lock held (e.g. inside a draw() method). */
+
+const State& get();
+
+/* getChannel
+Returns the state of channel 'ch' from the last fetched snapshot, or nullptr 
+if the channel is not there (e.g. it has just been added, or it's beyond 
+G_MAX_STATE_CHANS). */
+
+const ChannelState* getChannel(const Channel* ch);
+}}} // giada::m::engineState::
+
+
+#endif
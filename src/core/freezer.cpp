@@ -0,0 +1,230 @@
+/* -----------------------------------------------------------------------------
+ *
+ * Giada - Your Hardcore Loopmachine
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2019 Giovanni A. Zuliani | Monocasual
+ *
+ * This file is part of Giada - Your Hardcore Loopmachine.
+ *
+ * Giada - Your Hardcore Loopmachine is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * Giada - Your Hardcore Loopmachine is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Giada - Your Hardcore Loopmachine. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------------- */
+
+
+#include <pthread.h>
+#include "../utils/log.h"
+#include "const.h"
+#include "conf.h"
+#include "clock.h"
+#include "mixer.h"
+#include "recorder.h"
+#include "kernelAudio.h"
+#include "channelManager.h"
+#include "channel.h"
+#include "sampleChannel.h"
+#include "midiChannel.h"
+#include "pluginHost.h"
+#include "pluginManager.h"
+#include "plugin.h"
+#include "wave.h"
+#include "waveManager.h"
+#include "freezer.h"
+
+
+namespace giada {
+namespace m {
+namespace freezer
+{
+namespace
+{
+/* makeShadow_
+Creates a detached copy of 'src' for offline rendering. It has the same index, 
+so it reads the same actions, and the same sound source. Mixer settings are 
+neutral: volume and panning are applied live to the frozen data. No MIDI 
+output nor lightning either. The render is what the channel sounds like while 
+playing: loops play all along, whatever the live status is. The live channel 
+keeps its own status and decides when frozen data is heard (see 
+Channel::parseFrozen()). Plug-ins run on an offline context, out of the audio
+thread statistics. */
+
+std::unique_ptr<Channel> makeShadow_(const Channel* src, int bufferSize)
+{
+	std::unique_ptr<Channel> ch(channelManager::create(src->type, bufferSize, false));
+
+	ch->index       = src->index;
+	ch->hasActions  = src->hasActions;
+	ch->readActions = src->hasActions;
+
+	if (src->type == ChannelType::SAMPLE) {
+		const SampleChannel* ssrc = static_cast<const SampleChannel*>(src);
+		SampleChannel*       sch  = static_cast<SampleChannel*>(ch.get());
+
+		sch->pushWave(std::make_unique<Wave>(*ssrc->wave));
+		sch->mode    = ssrc->mode;
+		sch->begin   = ssrc->begin;
+		sch->end     = ssrc->end;
+		sch->boost   = ssrc->boost;
+		sch->tracker = ssrc->begin;
+		sch->setPitch(ssrc->pitch);
+
+		/* Loops play from the first beat, samples in single mode wait for their 
+		actions. */
+
+		sch->status = sch->isAnyLoopMode() ? ChannelStatus::PLAY : ChannelStatus::OFF;
+	}
+	else
+		ch->status = ChannelStatus::PLAY;
+
+#ifdef WITH_VST
+
+	ch->pluginContext.offline = true;
+	for (const Plugin* p : src->plugins.get())
+		if (!p->isBypassed())
+			pluginHost::addPlugin(pluginManager::makePlugin(*p), 
+				pluginHost::StackType::CHANNEL, ch.get());
+
+#endif
+
+	return ch;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+/* makeFrameEvents_
+Same as mixer::parseEvents_(), for an arbitrary sequencer frame. */
+
+mixer::FrameEvents makeFrameEvents_(Frame global, Frame local)
+{
+	mixer::FrameEvents fe;
+	fe.frameLocal   = local;
+	fe.frameGlobal  = global;
+	fe.quantoPassed = clock::quantoHasPassed(global);
+	fe.doQuantize   = clock::getQuantize() == 0 || !fe.quantoPassed;
+	fe.onBar        = clock::isOnBar(global);
+	fe.onFirstBeat  = global == 0;
+	fe.actions      = recorder::getActionsOnFrame(global);
+	return fe;
+}
+} // {anonymous}
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+
+std::unique_ptr<Wave> render(const Channel* src)
+{
+	const int   bufferSize = kernelAudio::getRealBufSize();
+	const Frame loop       = clock::getFramesInLoop();
+	const Frame total      = loop * 2;
+
+#ifdef WITH_VST
+	pluginManager::finishAsync();  // Render all plug-ins, even those still loading
+#endif
+
+	std::unique_ptr<Channel> ch   = makeShadow_(src, bufferSize);
+	std::unique_ptr<Wave>    wave = waveManager::createEmpty(loop, G_MAX_IO_CHANS, 
+		conf::samplerate, src->name + "-frozen.wav");
+
+	AudioBuffer out, in;  // No input: 'in' stays unallocated
+	out.alloc(bufferSize, G_MAX_IO_CHANS);
+
+	/* Frames from the second pass overwrite those from the first one. */
+
+	for (Frame block=0; block<total; block+=bufferSize) {
+		out.clear();
+		ch->prepareBuffer(/*running=*/true);
+		for (int i=0; i<bufferSize; i++)
+			ch->parseEvents(makeFrameEvents_((block + i) % loop, i));
+		ch->process(out, in, /*audible=*/true, /*running=*/true);
+
+		for (int i=0; i<bufferSize && block + i < total; i++) {
+			float* frame = wave->getFrame((block + i) % loop);
+			for (int j=0; j<G_MAX_IO_CHANS; j++)
+				frame[j] = out[i][j];
+		}
+	}
+
+	gu_log("[freezer::render] channel %d rendered, %d frames\n", src->index, loop);
+
+	return wave;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+int freeze(Channel* ch)
+{
+	if (ch->isFrozen())
+		return G_RES_OK;
+
+	/* Nothing to render: empty Sample channel, or MIDI channel without any
+	plug-in making sound. */
+
+	if (ch->type == ChannelType::SAMPLE && !ch->hasData())
+		return G_RES_ERR_NO_DATA;
+#ifdef WITH_VST
+	if (ch->type == ChannelType::MIDI && ch->plugins.get().empty())
+		return G_RES_ERR_NO_DATA;
+#else
+	if (ch->type == ChannelType::MIDI)
+		return G_RES_ERR_NO_DATA;
+#endif
+
+	std::unique_ptr<Wave> wave = render(ch);
+
+	pthread_mutex_lock(&mixer::mutex);
+	ch->frozen = std::move(wave);
+	pthread_mutex_unlock(&mixer::mutex);
+
+	return G_RES_OK;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void unfreeze(Channel* ch)
+{
+	std::unique_ptr<Wave> wave;  // Freed outside the lock
+
+	pthread_mutex_lock(&mixer::mutex);
+	wave = std::move(ch->frozen);
+	pthread_mutex_unlock(&mixer::mutex);
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void refresh()
+{
+	for (Channel* ch : mixer::channels) {
+		if (!ch->isFrozen())
+			continue;
+
+		std::unique_ptr<Wave> wave = render(ch);  // Old one freed outside the lock
+
+		pthread_mutex_lock(&mixer::mutex);
+		ch->frozen.swap(wave);
+		pthread_mutex_unlock(&mixer::mutex);
+	}
+}
+}}}; // giada::m::freezer::
@@ -0,0 +1,74 @@
+/* -----------------------------------------------------------------------------
+ *
+ * Giada - Your Hardcore Loopmachine
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2019 Giovanni A. Zuliani | Monocasual
+ *
+ * This file is part of Giada - Your Hardcore Loopmachine.
+ *
+ * Giada - Your Hardcore Loopmachine is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * Giada - Your Hardcore Loopmachine is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Giada - Your Hardcore Loopmachine. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------------- */
+
+
+#ifndef G_FREEZER_H
+#define G_FREEZER_H
+
+
+#include <memory>
+
+
+class Wave;
+
+
+namespace giada {
+namespace m 
+{
+class Channel;
+
+namespace freezer
+{
+/* render
+Renders one loop of channel 'ch' offline, actions and plug-ins included, into 
+a new Wave. Rendering works on a private copy of the channel with its own 
+plug-in instances, so the live one keeps playing in the meantime. The loop is 
+rendered twice and the second pass is kept: this way tails (e.g. reverbs) wrap 
+around the loop start as they do when playing live. */
+
+std::unique_ptr<Wave> render(const Channel* ch);
+
+/* freeze
+Renders 'ch' and plays the result in place of the live chain: plug-ins are no 
+longer processed until unfreeze(). Returns G_RES_ERR_NO_DATA if there is 
+nothing to render. */
+
+int freeze(Channel* ch);
+
+/* unfreeze
+Goes back to the live chain. */
+
+void unfreeze(Channel* ch);
+
+/* refresh
+Renders all frozen channels again. Frozen data spans exactly one loop: call it
+whenever the loop length changes, i.e. on tempo or beats changes. */
+
+void refresh();
+}}}; // giada::m::freezer::
+
+
+#endif
@@ -54,6 +54,9 @@
 #include "pluginHost.h"
 #include "recorder.h"
 #include "recManager.h"
+#include "worker.h"
+#include "retroCapture.h"
+#include "takeWriter.h"
 #include "midiMapConf.h"
 #include "kernelMidi.h"
 #include "kernelAudio.h"
@@ -113,9 +116,11 @@ void initAudio_()
 {
 	kernelAudio::openDevice();
 	clock::init(conf::samplerate, conf::midiTCfps);
-	mixer::init(clock::getFramesInLoop(), kernelAudio::getRealBufSize());
+	mixer::init(kernelAudio::getRealBufSize());
 	recorder::init(&mixer::mutex);
 	recManager::init(&mixer::mutex);
+	retroCapture::init(conf::retroCapture ? conf::retroCaptureBudget : 0);
+	worker::init();
 
 #ifdef WITH_VST
 
@@ -181,20 +186,26 @@ void initGUI_(int argc, char** argv)
 
 void shutdownAudio_()
 {
-#ifdef WITH_VST
-
-	pluginHost::freeAllStacks(&mixer::channels, &mixer::mutex);
-	pluginHost::close();
-	gu_log("[init] PluginHost cleaned up\n");
-
-#endif
-
 	if (kernelAudio::getStatus()) {
 		kernelAudio::closeDevice();
 		gu_log("[init] KernelAudio closed\n");
 		mixer::close();
 		gu_log("[init] Mixer closed\n");
+		retroCapture::close();
+		takeWriter::close();
 	}
+
+	/* Plug-ins go last: with the audio thread gone, retired plug-ins can be 
+	freed right away. */
+
+#ifdef WITH_VST
+
+	pluginManager::close();
+	pluginHost::freeAllStacks(&mixer::channels);
+	pluginHost::close();
+	gu_log("[init] PluginHost cleaned up\n");
+
+#endif
 }
 
 
@@ -249,6 +260,7 @@ void shutdown()
 {
 	G_quit.store(true);
 
+	worker::close();
 	shutdownGUI_();
 
 	if (!conf::write())
@@ -258,6 +270,10 @@ void shutdown()
 
 	shutdownAudio_();
 
+	/* Audio is gone, nobody sends MIDI anymore: flush and stop the sender. */
+
+	kernelMidi::closeOutDevice();
+
 	gu_log("[init] Giada %s closed\n\n", G_VERSION_STR);
 	gu_logClose();
 }
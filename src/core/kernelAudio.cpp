@@ -27,12 +27,20 @@
  * -------------------------------------------------------------------------- */
 
 
+#include <algorithm>
+#include <cstdio>
+#ifdef __linux__
+	#include <jack/midiport.h>
+#endif
 #include "../deps/rtaudio-mod/RtAudio.h"
 #include "../utils/log.h"
 #include "../glue/main.h"
 #include "conf.h"
 #include "mixer.h"
 #include "const.h"
+#include "audioBuffer.h"
+#include "kernelMidi.h"
+#include "midiSync.h"
 #include "kernelAudio.h"
 
 
@@ -44,6 +52,22 @@ namespace giada {
 namespace m {
 namespace kernelAudio
 {
+/* DirectOut
+Defined here to keep JACK out of the other modules. 'index' is the channel it
+belongs to, for the port names. */
+
+struct DirectOut
+{
+#ifdef __linux__
+	jack_port_t* ports[G_MAX_IO_CHANS];
+#endif
+	int index;
+};
+
+
+/* -------------------------------------------------------------------------- */
+
+
 namespace
 {
 RtAudio* rtSystem     = nullptr;
@@ -57,9 +81,310 @@ int      api          = 0;
 
 JackState jackState;
 
+/* jack*
+Giada's own JACK client. It replaces the RtAudio stream when JACK is the sound
+system (RtAudio is still there to list devices): the mixer reads and writes
+the port buffers with a single (de)interleaving pass, with no intermediate 
+copies. jackOut and jackIn are the interleaved buffers the mixer works on. */
+
+jack_client_t* jackClient  = nullptr;
+jack_port_t*   jackMidiIn  = nullptr;
+jack_port_t*   jackMidiOut = nullptr;
+jack_port_t*   jackOutPorts[G_MAX_IO_CHANS] = {};
+jack_port_t*   jackInPorts[G_MAX_IO_CHANS]  = {};
+AudioBuffer    jackOut;
+AudioBuffer    jackIn;
+
+/* directOuts_
+All direct outputs, cleared on each block before the mixer writes them. Changed
+by the main thread while holding mixer::mutex. */
+
+vector<DirectOut*> directOuts_;
+
+
+/* -------------------------------------------------------------------------- */
+
+
 jack_client_t* jackGetHandle()
 {
-	return static_cast<jack_client_t*>(rtSystem->rtapi_->__HACK__getJackClient());
+	return jackClient;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+jack_port_t* jackRegister_(const char* name, const char* type, unsigned long flags)
+{
+	jack_port_t* port = jack_port_register(jackClient, name, type, flags, 0);
+	if (port == nullptr)
+		gu_log("[KA] unable to register JACK port '%s'\n", name);
+	return port;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+/* jackRegisterDirectOut_
+Registers the ports of 'd'. On failure none is left registered and all ports
+are nullptr. */
+
+bool jackRegisterDirectOut_(DirectOut* d)
+{
+	for (int i=0; i<G_MAX_IO_CHANS; i++) {
+		char name[32];
+		snprintf(name, sizeof(name), "chan_%d_out_%d", d->index, i + 1);
+		d->ports[i] = jackRegister_(name, JACK_DEFAULT_AUDIO_TYPE, JackPortIsOutput);
+		if (d->ports[i] != nullptr)
+			continue;
+		for (int j=0; j<i; j++)
+			jack_port_unregister(jackClient, d->ports[j]);
+		std::fill(d->ports, d->ports + G_MAX_IO_CHANS, nullptr);
+		return false;
+	}
+	return true;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+/* jackClearDirectOuts_
+JACK doesn't clear output ports: a direct output the mixer doesn't write in 
+this block (skipped block, mixer not ready, ...) would play the previous one
+over and over. */
+
+void jackClearDirectOuts_(jack_nframes_t nframes)
+{
+	pthread_mutex_lock(&mixer::mutex);
+	for (DirectOut* d : directOuts_)
+		for (jack_port_t* port : d->ports)
+			if (port != nullptr) {
+				float* out = static_cast<float*>(jack_port_get_buffer(port, nframes));
+				std::fill(out, out + nframes, 0.0f);
+			}
+	pthread_mutex_unlock(&mixer::mutex);
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+/* jackReadMidi_
+Hands incoming MIDI over to kernelMidi, each message with the exact time of 
+its frame. JACK time and midiSync::getTime() run on different clocks: both are
+sampled here, at the same time, to move from one to the other. */
+
+void jackReadMidi_(jack_nframes_t nframes)
+{
+	void*          buffer = jack_port_get_buffer(jackMidiIn, nframes);
+	jack_nframes_t start  = jack_last_frame_time(jackClient);
+	uint32_t       count  = jack_midi_get_event_count(buffer);
+
+	if (count == 0)
+		return;
+
+	double jackNow = static_cast<double>(jack_get_time());
+	double now     = midiSync::getTime();
+
+	for (uint32_t i=0; i<count; i++) {
+		jack_midi_event_t event;
+		if (jack_midi_event_get(&event, buffer, i) != 0)
+			continue;
+		double jackTime = static_cast<double>(jack_frames_to_time(jackClient, start + event.time));
+		kernelMidi::jackReceive(event.buffer, event.size, now + (jackTime - jackNow) / 1000000.0);
+	}
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+/* jackWriteMidi_
+Writes what kernelMidi has queued in this block to the MIDI out port, on the
+frame each message was sent. JACK wants events in time order: a message due 
+earlier than the previous one (e.g. an 'as soon as possible' one) goes along
+with it. What doesn't fit stays in the queue for the next block. */
+
+void jackWriteMidi_(jack_nframes_t nframes)
+{
+	void* buffer = jack_port_get_buffer(jackMidiOut, nframes);
+	jack_midi_clear_buffer(buffer);
+
+	unsigned char data[3];
+	int   size;
+	Frame delta;
+	Frame last = 0;
+	while (kernelMidi::jackPeek(data, size, delta)) {
+		Frame time = std::min(std::max(delta, last), static_cast<Frame>(nframes) - 1);
+		if (jack_midi_event_write(buffer, time, data, size) != 0)
+			break;
+		kernelMidi::jackPop();
+		last = time;
+	}
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+/* jackProcess_
+JACK process callback. The mixer works on blocks of realBufsize frames: a 
+block of a different size, if any, is skipped and left silent. See also 
+jackBufferSize_(). */
+
+int jackProcess_(jack_nframes_t nframes, void* data)
+{
+	float* out[G_MAX_IO_CHANS];
+	for (int i=0; i<G_MAX_IO_CHANS; i++)
+		out[i] = static_cast<float*>(jack_port_get_buffer(jackOutPorts[i], nframes));
+
+	jackClearDirectOuts_(nframes);
+
+	if (nframes != realBufsize) {
+		for (int i=0; i<G_MAX_IO_CHANS; i++)
+			std::fill(out[i], out[i] + nframes, 0.0f);
+	}
+	else {
+		jackReadMidi_(nframes);
+
+		if (inputEnabled) {
+			const float* in[G_MAX_IO_CHANS];
+			for (int i=0; i<G_MAX_IO_CHANS; i++)
+				in[i] = static_cast<const float*>(jack_port_get_buffer(jackInPorts[i], nframes));
+			jackIn.interleave(in);
+		}
+
+		mixer::masterPlay(jackOut[0], inputEnabled ? jackIn[0] : nullptr, nframes,
+			0.0, 0, nullptr);
+
+		jackOut.deinterleave(out);
+	}
+
+	jackWriteMidi_(nframes);
+	return 0;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+/* jackBufferSize_
+JACK buffer size callback. JACK doesn't process while it runs: reallocate the
+buffers here, for the next blocks. */
+
+int jackBufferSize_(jack_nframes_t nframes, void* data)
+{
+	if (nframes == realBufsize)
+		return 0;
+
+	gu_log("[KA] JACK buffer size changed, buffer = %d\n", nframes);
+
+	pthread_mutex_lock(&mixer::mutex);
+	jackOut.alloc(nframes, G_MAX_IO_CHANS);
+	if (inputEnabled)
+		jackIn.alloc(nframes, G_MAX_IO_CHANS);
+	mixer::setBufferSize(nframes);
+	realBufsize = nframes;
+	pthread_mutex_unlock(&mixer::mutex);
+	return 0;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+/* jackShutdown_
+The server is gone, and so are the client and its ports. No JACK calls are
+allowed here: the main thread warns the user and reconnects (see 
+jackReconnect()). */
+
+void jackShutdown_(void* data)
+{
+	gu_log("[KA] JACK server has shut down\n");
+	status = false;
+	c::main::onJackShutdown();
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+/* jackConnect_
+Connects Giada's main ports to the physical ones, starting from 'first', like
+RtAudio's 'firstChannel'. */
+
+void jackConnect_(jack_port_t** ports, bool output, int first)
+{
+	const char** physical = jack_get_ports(jackClient, nullptr, JACK_DEFAULT_AUDIO_TYPE,
+		JackPortIsPhysical | (output ? JackPortIsInput : JackPortIsOutput));
+	if (physical == nullptr)
+		return;
+
+	int count = 0;
+	while (physical[count] != nullptr)
+		count++;
+
+	for (int i=0; i<G_MAX_IO_CHANS && first + i < count; i++) {
+		const char* port = jack_port_name(ports[i]);
+		if (output)
+			jack_connect(jackClient, port, physical[first + i]);
+		else
+			jack_connect(jackClient, physical[first + i], port);
+	}
+
+	jack_free(physical);
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+int openJack_()
+{
+	jackClient = jack_client_open(G_APP_NAME, JackNoStartServer, nullptr);
+	if (jackClient == nullptr) {
+		gu_log("[KA] unable to open JACK client\n");
+		return 0;
+	}
+
+	conf::samplerate = jack_get_sample_rate(jackClient);
+	realBufsize      = jack_get_buffer_size(jackClient);
+	inputEnabled     = conf::soundDeviceIn != -1;
+
+	gu_log("[KA] JACK in use, freq = %d, buffer = %d\n", conf::samplerate, realBufsize);
+
+	char name[32];
+	for (int i=0; i<G_MAX_IO_CHANS; i++) {
+		snprintf(name, sizeof(name), "out_%d", i + 1);
+		jackOutPorts[i] = jackRegister_(name, JACK_DEFAULT_AUDIO_TYPE, JackPortIsOutput);
+		snprintf(name, sizeof(name), "in_%d", i + 1);
+		jackInPorts[i] = inputEnabled ? jackRegister_(name, JACK_DEFAULT_AUDIO_TYPE, JackPortIsInput) : nullptr;
+	}
+	jackMidiIn  = jackRegister_("midi_in",  JACK_DEFAULT_MIDI_TYPE, JackPortIsInput);
+	jackMidiOut = jackRegister_("midi_out", JACK_DEFAULT_MIDI_TYPE, JackPortIsOutput);
+
+	bool ok = jackMidiIn != nullptr && jackMidiOut != nullptr;
+	for (int i=0; i<G_MAX_IO_CHANS; i++)
+		ok = ok && jackOutPorts[i] != nullptr && (!inputEnabled || jackInPorts[i] != nullptr);
+
+	if (!ok) {
+		jack_client_close(jackClient);
+		jackClient = nullptr;
+		return 0;
+	}
+
+	jackOut.alloc(realBufsize, G_MAX_IO_CHANS);
+	if (inputEnabled)
+		jackIn.alloc(realBufsize, G_MAX_IO_CHANS);
+
+	jack_set_process_callback(jackClient, jackProcess_, nullptr);
+	jack_set_buffer_size_callback(jackClient, jackBufferSize_, nullptr);
+	jack_on_shutdown(jackClient, jackShutdown_, nullptr);
+
+	status = true;
+	return 1;
 }
 
 #endif
@@ -135,6 +460,13 @@ int openDevice()
 			gu_log("  %d) %s\n", i, getDeviceName(i).c_str());
 	}
 
+#ifdef __linux__
+
+	if (api == G_SYS_API_JACK)
+		return openJack_();
+
+#endif
+
 	RtAudio::StreamParameters outParams;
 	RtAudio::StreamParameters inParams;
 
@@ -159,15 +491,6 @@ int openDevice()
 
 	realBufsize = conf::buffersize;
 
-#if defined(__linux__) || defined(__APPLE__)
-
-	if (api == G_SYS_API_JACK) {
-		conf::samplerate = getFreq(conf::soundDeviceOut, 0);
-		gu_log("[KA] JACK in use, freq = %d\n", conf::samplerate);
-	}
-
-#endif
-
 	try {
 		rtSystem->openStream(
 			&outParams, 					              // output params
@@ -194,6 +517,21 @@ int openDevice()
 
 int startStream()
 {
+#ifdef __linux__
+
+	if (jackClient != nullptr) {
+		if (jack_activate(jackClient) != 0) {
+			gu_log("[KA] unable to activate JACK client\n");
+			return 0;
+		}
+		jackConnect_(jackOutPorts, true, conf::channelsOut * G_MAX_IO_CHANS);
+		if (inputEnabled)
+			jackConnect_(jackInPorts, false, conf::channelsIn * G_MAX_IO_CHANS);
+		return 1;
+	}
+
+#endif
+
 	try {
 		rtSystem->startStream();
 		gu_log("[KA] latency = %lu\n", rtSystem->getStreamLatency());
@@ -211,6 +549,13 @@ int startStream()
 
 int stopStream()
 {
+#ifdef __linux__
+
+	if (jackClient != nullptr)
+		return jack_deactivate(jackClient) == 0 ? 1 : 0;
+
+#endif
+
 	try {
 		rtSystem->stopStream();
 		return 1;
@@ -242,6 +587,20 @@ string getDeviceName(unsigned dev)
 
 int closeDevice()
 {
+#ifdef __linux__
+
+	/* Closing the client takes its ports away, direct outputs included. */
+
+	if (jackClient != nullptr) {
+		jack_client_close(jackClient);
+		jackClient = nullptr;
+		delete rtSystem;
+		rtSystem = nullptr;
+		return 1;
+	}
+
+#endif
+
 	if (rtSystem->isStreamOpen()) {
 #if defined(__linux__) || defined(__APPLE__)
 		rtSystem->abortStream(); // stopStream seems to lock the thread
@@ -445,6 +804,108 @@ int getAPI() { return api; }
 /* -------------------------------------------------------------------------- */
 
 
+bool isJackNative()
+{
+#ifdef __linux__
+	return jackClient != nullptr;
+#else
+	return false;
+#endif
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+DirectOut* addDirectOut(int index)
+{
+#ifdef __linux__
+
+	if (jackClient == nullptr || !conf::jackDirectOuts)
+		return nullptr;
+
+	DirectOut* d = new DirectOut();
+	d->index = index;
+	if (!jackRegisterDirectOut_(d)) {
+		delete d;
+		return nullptr;
+	}
+
+	pthread_mutex_lock(&mixer::mutex);
+	directOuts_.push_back(d);
+	pthread_mutex_unlock(&mixer::mutex);
+	return d;
+
+#else
+
+	return nullptr;
+
+#endif
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void removeDirectOut(DirectOut* d)
+{
+	if (d == nullptr)
+		return;
+#ifdef __linux__
+	pthread_mutex_lock(&mixer::mutex);
+	directOuts_.erase(std::remove(directOuts_.begin(), directOuts_.end(), d), directOuts_.end());
+	pthread_mutex_unlock(&mixer::mutex);
+
+	if (jackClient != nullptr)
+		for (jack_port_t* port : d->ports)
+			if (port != nullptr)
+				jack_port_unregister(jackClient, port);
+#endif
+	delete d;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void renameDirectOut(DirectOut* d, int index)
+{
+#ifdef __linux__
+	if (d == nullptr)
+		return;
+	d->index = index;
+	if (jackClient == nullptr)
+		return;
+	for (int i=0; i<G_MAX_IO_CHANS; i++) {
+		if (d->ports[i] == nullptr)
+			continue;
+		char name[32];
+		snprintf(name, sizeof(name), "chan_%d_out_%d", index, i + 1);
+		jack_port_rename(jackClient, d->ports[i], name);
+	}
+#endif
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void writeDirectOut(DirectOut* d, const AudioBuffer& b)
+{
+#ifdef __linux__
+	if (d->ports[0] == nullptr)  // lost on a reconnection, see jackReconnect()
+		return;
+	float* out[G_MAX_IO_CHANS];
+	for (int i=0; i<G_MAX_IO_CHANS; i++)
+		out[i] = static_cast<float*>(jack_port_get_buffer(d->ports[i], b.countFrames()));
+	b.deinterleave(out);
+#endif
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
 #ifdef __linux__
 
 
@@ -464,6 +925,60 @@ const JackState &jackTransportQuery()
 /* -------------------------------------------------------------------------- */
 
 
+int jackReconnect()
+{
+	/* The old client is dead, but still to be closed. Its ports are gone. */
+
+	if (jackClient != nullptr) {
+		jack_client_close(jackClient);
+		jackClient = nullptr;
+	}
+	for (DirectOut* d : directOuts_)
+		std::fill(d->ports, d->ports + G_MAX_IO_CHANS, nullptr);
+
+	int      samplerate = conf::samplerate;
+	unsigned bufsize    = realBufsize;
+
+	if (!openJack_())
+		return 0;
+
+	if (conf::samplerate != samplerate) {
+		gu_log("[KA] JACK is back with a different sample rate (%d), can't reconnect\n",
+			conf::samplerate);
+		conf::samplerate = samplerate;
+		jack_client_close(jackClient);
+		jackClient = nullptr;
+		status     = false;
+		return 0;
+	}
+
+	if (realBufsize != bufsize) {
+		pthread_mutex_lock(&mixer::mutex);
+		mixer::setBufferSize(realBufsize);
+		pthread_mutex_unlock(&mixer::mutex);
+	}
+
+	for (DirectOut* d : directOuts_)
+		if (!jackRegisterDirectOut_(d))
+			gu_log("[KA] unable to restore direct output for channel %d\n", d->index);
+
+	if (!startStream()) {
+		for (DirectOut* d : directOuts_)
+			std::fill(d->ports, d->ports + G_MAX_IO_CHANS, nullptr);
+		jack_client_close(jackClient);
+		jackClient = nullptr;
+		status     = false;
+		return 0;
+	}
+
+	gu_log("[KA] reconnected to JACK\n");
+	return 1;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
 void jackStart()
 {
 	if (api == G_SYS_API_JACK)
@@ -43,6 +43,8 @@ class Mixer;
 
 namespace giada {
 namespace m {
+class AudioBuffer;
+
 namespace kernelAudio
 {
 #ifdef __linux__
@@ -56,6 +58,12 @@ struct JackState
 
 #endif
 
+/* DirectOut
+A pair of JACK output ports carrying a single channel, for routing it outside
+Giada. Opaque, owned by kernelAudio. */
+
+struct DirectOut;
+
 int openDevice();
 int closeDevice();
 int startStream();
@@ -80,8 +88,43 @@ int getDefaultIn();
 bool hasAPI(int API);
 int getAPI();
 
+/* isJackNative
+True if the audio runs on Giada's own JACK client, i.e. JACK is the sound 
+system. The client also owns the JACK MIDI ports. */
+
+bool isJackNative();
+
+/* addDirectOut
+Registers a new direct output for channel 'index'. Returns nullptr if direct
+outputs are disabled or not available. Main thread only. */
+
+DirectOut* addDirectOut(int index);
+
+/* removeDirectOut
+Unregisters and deletes 'd'. Make sure the audio thread no longer uses it. 
+Main thread only. */
+
+void removeDirectOut(DirectOut* d);
+
+/* renameDirectOut
+Follows a change in the channel index, e.g. when a patch is loaded. */
+
+void renameDirectOut(DirectOut* d, int index);
+
+/* writeDirectOut
+Copies the interleaved buffer 'b' to the ports of 'd'. Audio thread only. */
+
+void writeDirectOut(DirectOut* d, const AudioBuffer& b);
+
 #ifdef __linux__
 
+/* jackReconnect
+Opens a new JACK client after the server has shut down, with the same ports. 
+Returns 0 if the server is not there yet, or if it came back with a different 
+sample rate. Main thread only. */
+
+int jackReconnect();
+
 void jackStart();
 void jackStop();
 void jackSetPosition(uint32_t frame);
@@ -25,6 +25,10 @@
  * -------------------------------------------------------------------------- */
 
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
 #include "const.h"
 #ifdef G_OS_MAC
 	#include <RtMidi.h>
@@ -32,13 +36,18 @@
 	#include <rtmidi/RtMidi.h>
 #endif
 #include "../utils/log.h"
+#include "conf.h"
+#include "queue.h"
 #include "midiDispatcher.h"
+#include "midiSync.h"
 #include "midiMapConf.h"
+#include "kernelAudio.h"
 #include "kernelMidi.h"
 
 
 using std::string;
 using std::vector;
+using std::chrono::steady_clock;
 
 
 namespace giada {
@@ -54,9 +63,245 @@ RtMidiIn*  midiIn_  = nullptr;
 unsigned numOutPorts_ = 0;
 unsigned numInPorts_  = 0;
 
+/* jack_
+Whether MIDI goes through the JACK MIDI ports of the audio client (see 
+kernelAudio::isJackNative()) instead of RtMidi. If so the audio thread takes
+outgoing messages from the queue and writes them on their frame, while the 
+sender thread only deals with lightning and incoming messages. */
+
+bool jack_ = false;
+
+
+/* Message
+An outgoing MIDI message, up to 3 bytes. 'time' is when it's due: a default 
+time_point (i.e. the epoch) means right away. 'delta' is the same thing in 
+frames within the audio block, for JACK. */
+
+struct Message
+{
+	unsigned char            data[3];
+	int                      size;
+	steady_clock::time_point time;
+	Frame                    delta;
+};
+
+Queue<Message, G_MIDI_OUT_QUEUE_SIZE> outQueue_;
+
+/* jackMessage_
+Message taken from the queue but not written to the JACK port yet. Audio 
+thread only. */
+
+Message jackMessage_;
+bool    jackPending_ = false;
+
+/* inQueue_
+Incoming messages from the JACK MIDI port, dispatched by the sender thread: 
+the audio thread can't run the dispatcher. */
+
+Queue<uint32_t, G_MIDI_IN_QUEUE_SIZE> inQueue_;
+
+std::thread       sender_;
+std::atomic<bool> senderRunning_(false);
+std::atomic<int>  lostMessages_(0);
+
+/* blockTime_
+Instant the current audio block started. Read and written by the audio thread 
+only. */
+
+steady_clock::time_point blockTime_;
+
+/* lightning*_
+LED cache for MIDI lightning, one slot for each (message type, MIDI channel, 
+first data byte) triplet, i.e. one LED on the controller: note 36 and CC 36 
+on the same channel are two different things. Slots hold the whole message as
+status byte and second data byte; note-offs are stored as note-ons with 
+velocity 0, the same thing for a controller. Producers write the wanted message and queue
+the slot, unless it's already queued: bursts of changes to the same LED 
+collapse into one message. lightningSent_ holds what the controller currently
+shows; it belongs to the sender thread. The queue is as big as the slot table,
+so it can't overflow. */
+
+constexpr int LIGHTNING_TYPES = 8;  // Status byte high nibble, minus 0x8
+constexpr int LIGHTNING_SLOTS = LIGHTNING_TYPES * G_MAX_MIDI_CHANS * 128;
+
+std::atomic<int>  lightningWanted_[LIGHTNING_SLOTS];
+std::atomic<bool> lightningQueued_[LIGHTNING_SLOTS];
+int               lightningSent_[LIGHTNING_SLOTS];
+
+Queue<int, LIGHTNING_SLOTS> lightningQueue_;
+steady_clock::time_point    lightningTime_;  // next update, sender thread only
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void enqueue_(int b1, int b2, int b3, Frame delta)
+{
+	Message msg;
+	msg.size = 0;
+	msg.data[msg.size++] = b1;
+	if (b2 != -1)
+		msg.data[msg.size++] = b2;
+	if (b3 != -1)
+		msg.data[msg.size++] = b3;
+
+	msg.delta = delta;
+	if (delta >= 0)
+		msg.time = blockTime_ + std::chrono::nanoseconds(
+			static_cast<long long>(delta * (1000000000.0 / conf::samplerate)));
+
+	if (!outQueue_.push(msg))
+		lostMessages_++;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+/* deliver_
+Writes a message to the output port. Sender thread only, or after it's been 
+stopped. With JACK the message goes back to the queue, for the audio thread. */
+
+void deliver_(const Message& msg, vector<unsigned char>& buffer)
+{
+	if (jack_) {
+		if (!outQueue_.push(msg))
+			lostMessages_++;
+		return;
+	}
+	buffer.assign(msg.data, msg.data + msg.size);
+	try {
+		midiOut_->sendMessage(&buffer);
+	}
+	catch (RtMidiError& error) {
+		gu_log("[KM] MIDI send error: %s\n", error.getMessage().c_str());
+	}
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+/* flushLightning_
+Delivers pending LED changes, no more than G_MIDI_LIGHTNING_BURST messages 
+every G_MIDI_LIGHTNING_RATE ms. What's left goes with the next update. Sender
+thread only. */
+
+void flushLightning_(vector<unsigned char>& buffer)
+{
+	steady_clock::time_point now = steady_clock::now();
+	if (now < lightningTime_)
+		return;
+	lightningTime_ = now + std::chrono::milliseconds(G_MIDI_LIGHTNING_RATE);
+
+	int sent = 0;
+	int slot;
+	while (sent < G_MIDI_LIGHTNING_BURST && lightningQueue_.pop(slot)) {
+		lightningQueued_[slot].store(false);
+		int wanted = lightningWanted_[slot].load();
+		if (wanted == lightningSent_[slot])
+			continue;
+		lightningSent_[slot] = wanted;
+
+		Message msg;
+		msg.data[0] = wanted >> 8;
+		msg.data[1] = slot & 0x7F;
+		msg.data[2] = wanted & 0x7F;
+		msg.size    = 3;
+		msg.delta   = -1;
+		deliver_(msg, buffer);
+		sent++;
+	}
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+/* runSender_
+Sender thread loop. Messages are delivered in the same order they have been 
+queued: a timestamped message holds back the ones behind it until it's due, so
+a note can't overtake its own note-off. */
+
+void runSender_()
+{
+	vector<unsigned char> buffer;
+	buffer.reserve(3);
+
+	Message msg;
+	bool    pending = false;
+
+	while (senderRunning_.load()) {
+		int lost = lostMessages_.exchange(0);
+		if (lost > 0)
+			gu_log("[KM] MIDI queue full, %d message(s) lost\n", lost);
+
+		flushLightning_(buffer);
+
+		if (jack_) {
+			uint32_t in;
+			while (inQueue_.pop(in))
+				midiDispatcher::dispatch(getB1(in), getB2(in), getB3(in));
+			std::this_thread::sleep_for(std::chrono::milliseconds(G_MIDI_OUT_RATE));
+			continue;
+		}
+
+		if (!pending)
+			pending = outQueue_.pop(msg);
+		if (!pending) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(G_MIDI_OUT_RATE));
+			continue;
+		}
+		if (msg.time > steady_clock::now()) {
+			std::this_thread::sleep_until(msg.time);
+			continue;
+		}
+		deliver_(msg, buffer);
+		pending = false;
+	}
+
+	/* Flush what's left (e.g. all notes off) before leaving. */
+
+	if (jack_)
+		return;
+	if (pending)
+		deliver_(msg, buffer);
+	while (outQueue_.pop(msg))
+		deliver_(msg, buffer);
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void startSender_()
+{
+	if (senderRunning_.load())
+		return;
+
+	/* What the controller shows is unknown: the first update of each LED 
+	always goes out. */
+
+	for (int i=0; i<LIGHTNING_SLOTS; i++)
+		lightningSent_[i] = -1;
+
+	senderRunning_.store(true);
+	sender_ = std::thread(runSender_);
+}
+
+
+/* -------------------------------------------------------------------------- */
+
 
 static void callback_(double t, vector<unsigned char>* msg, void* data)
 {
+	/* System messages (clock, timecode, ...) feed the MIDI sync. RtMidi's 't' is
+	a delta time, not good enough for tempo tracking: take a fresh timestamp. */
+
+	if (msg->size() > 0 && msg->at(0) >= MIDI_SYSEX) {
+		midiSync::receive(msg->data(), msg->size(), midiSync::getTime());
+		return;
+	}
 	if (msg->size() < 3) {
 		//gu_log("[KM] MIDI received - unknown signal - size=%d, value=0x", (int) msg->size());
 		//for (unsigned i=0; i<msg->size(); i++)
@@ -102,6 +347,18 @@ void setApi(int api)
 
 int openOutDevice(int port)
 {
+	/* JACK MIDI: the port is already there, owned by the audio client. Routing
+	is up to JACK, 'port' doesn't matter. */
+
+	jack_ = api_ == RtMidi::UNIX_JACK && kernelAudio::isJackNative();
+	if (jack_) {
+		status_ = true;
+		gu_log("[KM] MIDI out on JACK MIDI port\n");
+		startSender_();
+		sendMidiLightningInitMsgs_();
+		return 1;
+	}
+
 	try {
 		midiOut_ = new RtMidiOut((RtMidi::Api) api_, "Giada MIDI Output");
 		status_  = true;
@@ -126,6 +383,8 @@ int openOutDevice(int port)
 			midiOut_->openPort(port, getOutPortName(port));
 			gu_log("[KM] MIDI out port %d open\n", port);
 
+			startSender_();
+
 			/* TODO - it shold send midiLightning message only if there is a map loaded
 			and available in midimap:: */
 
@@ -148,6 +407,14 @@ int openOutDevice(int port)
 
 int openInDevice(int port)
 {
+	jack_ = api_ == RtMidi::UNIX_JACK && kernelAudio::isJackNative();
+	if (jack_) {
+		status_ = true;
+		gu_log("[KM] MIDI in on JACK MIDI port\n");
+		startSender_();
+		return 1;
+	}
+
 	try {
 		midiIn_ = new RtMidiIn((RtMidi::Api) api_, "Giada MIDI input");
 		status_ = true;
@@ -170,7 +437,7 @@ int openInDevice(int port)
 	if (port != -1 && numInPorts_ > 0) {
 		try {
 			midiIn_->openPort(port, getInPortName(port));
-			midiIn_->ignoreTypes(true, false, true); // ignore all system/time msgs, for now
+			midiIn_->ignoreTypes(conf::midiSync != MIDI_SYNC_MTC_S, false, true); // SysEx only for MTC full frames
 			gu_log("[KM] MIDI in port %d open\n", port);
 			midiIn_->setCallback(&callback_);
 			return 1;
@@ -219,37 +486,93 @@ string getInPortName(unsigned p)
 /* -------------------------------------------------------------------------- */
 
 
-void send(uint32_t data)
+void send(uint32_t data, Frame delta)
+{
+	if (!status_ || !senderRunning_.load())
+		return;
+	enqueue_(getB1(data), getB2(data), getB3(data), delta);
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void send(int b1, int b2, int b3, Frame delta)
 {
-	if (!status_)
+	if (!status_ || !senderRunning_.load())
 		return;
+	enqueue_(b1, b2, b3, delta);
+}
+
 
-	vector<unsigned char> msg(1, getB1(data));
-	msg.push_back(getB2(data));
-	msg.push_back(getB3(data));
+/* -------------------------------------------------------------------------- */
 
-	midiOut_->sendMessage(&msg);
-	gu_log("[KM] send msg=0x%X (%X %X %X)\n", data, msg[0], msg[1], msg[2]);
+
+void beginBlock()
+{
+	blockTime_ = steady_clock::now();
 }
 
 
 /* -------------------------------------------------------------------------- */
 
 
-void send(int b1, int b2, int b3)
+void jackReceive(const unsigned char* data, int size, double time)
 {
-	if (!status_)
+	if (!jack_ || size == 0)
 		return;
 
-	vector<unsigned char> msg(1, b1);
+	/* Same as callback_(), but with the exact timestamp from JACK. Channel 
+	messages are 2 (program change, channel pressure) or 3 bytes long. */
+
+	if (data[0] >= MIDI_SYSEX)
+		midiSync::receive(data, size, time);
+	else
+	if (size <= 3 && (data[0] & 0x80)) {
+		uint32_t value = getIValue(data[0], size > 1 ? data[1] : 0, size > 2 ? data[2] : 0);
+		if (!inQueue_.push(value))
+			lostMessages_++;
+	}
+}
+
+
+/* -------------------------------------------------------------------------- */
 
-	if (b2 != -1)
-		msg.push_back(b2);
-	if (b3 != -1)
-		msg.push_back(b3);
 
-	midiOut_->sendMessage(&msg);
-	//gu_log("[KM] send msg=(%X %X %X)\n", b1, b2, b3);
+bool jackPeek(unsigned char* data, int& size, Frame& delta)
+{
+	if (!jack_)
+		return false;
+	if (!jackPending_)
+		jackPending_ = outQueue_.pop(jackMessage_);
+	if (!jackPending_)
+		return false;
+	std::copy(jackMessage_.data, jackMessage_.data + jackMessage_.size, data);
+	size  = jackMessage_.size;
+	delta = jackMessage_.delta;
+	return true;
+}
+
+
+void jackPop()
+{
+	jackPending_ = false;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+int closeOutDevice()
+{
+	if (!senderRunning_.load())
+		return 0;
+	senderRunning_.store(false);
+	sender_.join();
+	if (midiOut_ != nullptr)
+		midiOut_->closePort();
+	gu_log("[KM] MIDI out device closed\n");
+	return 1;
 }
 
 
@@ -261,22 +584,32 @@ void sendMidiLightning(uint32_t learn, const midimap::message_t& msg)
 	// Skip lightning message if not defined in midi map
 
 	if (!midimap::isDefined(msg))
-	{
-		gu_log("[KM] message skipped (not defined in midimap)");
 		return;
-	}
-
-	gu_log("[KM] learn=%#X, chan=%d, msg=%#X, offset=%d\n", learn, msg.channel, 
-		msg.value, msg.offset);
 
 	/* Isolate 'channel' from learnt message and offset it as requested by 'nn' in 
 	the midimap configuration file. */
 	uint32_t out = ((learn & 0x00FF0000) >> 16) << msg.offset;
 
-	/* Merge the previously prepared channel into final message, and finally send 
-	it. */
+	/* Merge the previously prepared channel into final message, and finally 
+	hand it over to the LED cache. */
 	out |= msg.value | (msg.channel << 24);
-	send(out);
+
+	if (!status_ || !senderRunning_.load())
+		return;
+
+	int b1 = getB1(out);
+	int b3 = getB3(out) & 0x7F;
+	if (b1 < 0x80 || b1 >= 0xF0)  // Not a channel message, nothing to light up
+		return;
+	if ((b1 & 0xF0) == 0x80) {    // Note-off: same as note-on, velocity 0
+		b1 = 0x90 | (b1 & 0x0F);
+		b3 = 0;
+	}
+
+	int slot = (((b1 >> 4) & 0x07) << 11) | ((b1 & 0x0F) << 7) | (getB2(out) & 0x7F);
+	lightningWanted_[slot].store((b1 << 8) | b3);
+	if (!lightningQueued_[slot].exchange(true))
+		lightningQueue_.push(slot);
 }
 
 
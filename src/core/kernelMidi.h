@@ -31,6 +31,7 @@
 
 #include <cstdint>
 #include <string>
+#include "types.h"
 #include "midiMapConf.h"
 
 
@@ -51,13 +52,39 @@ channel. */
 uint32_t setChannel(uint32_t iValue, int channel);
 
 /* send
-Sends a MIDI message 's' as uint32_t or as separate bytes. */
+Sends a MIDI message 's' as uint32_t or as separate bytes. Messages are queued
+and delivered by a dedicated sender thread: no locks nor allocations, so it's 
+safe to call from the audio thread. 'delta' is the message position in frames
+within the current audio block (see beginBlock()), -1 = as soon as possible. */
 
-void send(uint32_t s);
-void send(int b1, int b2=-1, int b3=-1);
+void send(uint32_t s, Frame delta=-1);
+void send(int b1, int b2=-1, int b3=-1, Frame delta=-1);
+
+/* beginBlock
+Marks the start of a new audio block: messages sent with a 'delta' are 
+timestamped relative to this instant. Audio thread only. */
+
+void beginBlock();
+
+/* jackReceive
+Takes a message from the JACK MIDI input port. 'time' is the exact time of 
+its frame, in midiSync::getTime() units. Audio thread only. */
+
+void jackReceive(const unsigned char* data, int size, double time);
+
+/* jackPeek, jackPop
+Fetch the next message for the JACK MIDI output port: jackPeek() reads it 
+into 'data' (3 bytes at most), jackPop() removes it once written. 'delta' is
+the message position within the current block, -1 = as soon as possible. 
+Audio thread only. */
+
+bool jackPeek(unsigned char* data, int& size, Frame& delta);
+void jackPop();
 
 /* sendMidiLightning
-Sends a MIDI lightning message defined by 'msg'. */
+Sets the controller LED defined by 'msg'. LED states are cached: the sender 
+thread delivers only the ones that actually changed, at a limited rate, and
+only the latest value if an LED changes many times in between. Any thread. */
 
 void sendMidiLightning(uint32_t learn, const midimap::message_t& msg);
 
@@ -0,0 +1,175 @@
+/* -----------------------------------------------------------------------------
+ *
+ * Giada - Your Hardcore Loopmachine
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2019 Giovanni A. Zuliani | Monocasual
+ *
+ * This file is part of Giada - Your Hardcore Loopmachine.
+ *
+ * Giada - Your Hardcore Loopmachine is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * Giada - Your Hardcore Loopmachine is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Giada - Your Hardcore Loopmachine. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------------- */
+
+
+#include <atomic>
+#include <cmath>
+#include <algorithm>
+#include "../utils/log.h"
+#include "../utils/math.h"
+#include "../utils/time.h"
+#include "const.h"
+#include "audioBuffer.h"
+#include "latencyProbe.h"
+
+
+namespace giada {
+namespace m {
+namespace latencyProbe
+{
+namespace
+{
+enum class State { IDLE, NOISE, EMIT, LISTEN, DONE, FAILED };
+
+/* state_
+Measurement progress. The UI thread moves it from IDLE to NOISE and reads the
+result back once DONE or FAILED; the audio thread does the rest. */
+
+std::atomic<State> state_(State::IDLE);
+
+/* floor_, elapsed_, timeout_, result_
+Audio thread only, except for result_ which is read by the UI thread after
+state_ goes DONE. */
+
+float floor_   = 0.0f;
+Frame elapsed_ = 0;
+Frame timeout_ = 0;
+Frame result_  = -1;
+
+
+/* -------------------------------------------------------------------------- */
+
+/* advance_
+Moves to the next state, unless the UI thread has given up in the meantime. */
+
+void advance_(State from, State to)
+{
+	state_.compare_exchange_strong(from, to);
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+/* findImpulse_
+Returns the first frame in the input above the noise floor, or -1. */
+
+Frame findImpulse_(const AudioBuffer& in)
+{
+	float threshold = std::max(floor_ * u::math::dBtoLinear(G_LATENCY_PROBE_THRESHOLD),
+		u::math::dBtoLinear(-60.0f));
+	for (int i=0; i<in.countFrames(); i++)
+		for (int j=0; j<in.countChannels(); j++)
+			if (std::fabs(in[i][j]) > threshold)
+				return i;
+	return -1;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+float computeFloor_(const AudioBuffer& in)
+{
+	float peak = 0.0f;
+	for (int i=0; i<in.countFrames(); i++)
+		for (int j=0; j<in.countChannels(); j++)
+			peak = std::max(peak, std::fabs(in[i][j]));
+	return peak;
+}
+} // {anonymous}
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+
+void process(AudioBuffer& out, const AudioBuffer& in)
+{
+	State state = state_.load();
+	if (state == State::IDLE || state == State::DONE || state == State::FAILED)
+		return;
+
+	out.clear();
+
+	/* First block: measure the noise floor, so that the impulse can be told 
+	apart from hiss. Second block: send the impulse on its first frame. Input
+	and output streams run in lockstep, so the latency is just the distance 
+	between the impulse and its echo, counted in frames. */
+
+	if (state == State::NOISE) {
+		floor_ = computeFloor_(in);
+		advance_(State::NOISE, State::EMIT);
+		return;
+	}
+
+	if (state == State::EMIT) {
+		for (int j=0; j<out.countChannels(); j++)
+			out[0][j] = G_LATENCY_PROBE_LEVEL;
+		elapsed_ = 0;
+		advance_(State::EMIT, State::LISTEN);
+	}
+
+	Frame found = findImpulse_(in);
+	if (found != -1) {
+		result_ = elapsed_ + found;
+		advance_(State::LISTEN, State::DONE);
+		return;
+	}
+
+	elapsed_ += in.countFrames();
+	if (elapsed_ > timeout_)
+		advance_(State::LISTEN, State::FAILED);
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+Frame measure(int samplerate)
+{
+	result_  = -1;
+	timeout_ = (samplerate * G_LATENCY_PROBE_TIMEOUT) / 1000;
+	state_.store(State::NOISE);
+
+	/* Give the audio thread some extra time on top of the timeout: it might not
+	be running at all (e.g. stream stopped). */
+
+	for (int waited=0; waited<G_LATENCY_PROBE_TIMEOUT * 2; waited++) {
+		State state = state_.load();
+		if (state == State::DONE || state == State::FAILED)
+			break;
+		u::time::sleep(1);
+	}
+
+	Frame result = state_.load() == State::DONE ? result_ : -1;
+	state_.store(State::IDLE);
+
+	gu_log("[latencyProbe::measure] round-trip latency: %d frames\n", result);
+
+	return result;
+}
+}}}; // giada::m::latencyProbe::
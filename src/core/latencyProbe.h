@@ -0,0 +1,59 @@
+/* -----------------------------------------------------------------------------
+ *
+ * Giada - Your Hardcore Loopmachine
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2019 Giovanni A. Zuliani | Monocasual
+ *
+ * This file is part of Giada - Your Hardcore Loopmachine.
+ *
+ * Giada - Your Hardcore Loopmachine is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * Giada - Your Hardcore Loopmachine is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Giada - Your Hardcore Loopmachine. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------------- */
+
+
+#ifndef G_LATENCY_PROBE_H
+#define G_LATENCY_PROBE_H
+
+
+#include "types.h"
+
+
+namespace giada {
+namespace m 
+{
+class AudioBuffer;
+
+namespace latencyProbe
+{
+/* process
+Audio thread side: does nothing unless a measurement is in progress. If so, 
+it replaces the output with silence and a single impulse, then looks for it in
+the input. */
+
+void process(AudioBuffer& out, const AudioBuffer& in);
+
+/* measure
+Sends an impulse through the audio device and waits for it to come back from 
+the input (i.e. a physical or virtual loopback is needed). Returns the round-
+trip latency in frames, or -1 if the impulse didn't show up. Blocks the caller
+for G_LATENCY_PROBE_TIMEOUT milliseconds at most. */
+
+Frame measure(int samplerate);
+}}}; // giada::m::latencyProbe::
+
+
+#endif
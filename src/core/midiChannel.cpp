@@ -59,9 +59,9 @@ MidiChannel::MidiChannel(int bufferSize)
 /* -------------------------------------------------------------------------- */
 
 
-void MidiChannel::copy(const Channel* src_, pthread_mutex_t* pluginMutex)
+void MidiChannel::copy(const Channel* src_)
 {
-	Channel::copy(src_, pluginMutex);
+	Channel::copy(src_);
 	const MidiChannel* src = static_cast<const MidiChannel*>(src_);
 	midiOut     = src->midiOut;
 	midiOutChan = src->midiOutChan;
@@ -73,7 +73,13 @@ void MidiChannel::copy(const Channel* src_, pthread_mutex_t* pluginMutex)
 
 void MidiChannel::parseEvents(mixer::FrameEvents fe)
 {
+	/* Keep parsing events when frozen: actions still go to the MIDI output, if 
+	any, and the channel status stays in sync with the sequencer. Plug-ins are 
+	left out (see sendMidi()). */
+
 	midiChannelProc::parseEvents(this, fe);
+	if (isFrozen())
+		parseFrozen(fe, isPlaying());
 }
 
 /* -------------------------------------------------------------------------- */
@@ -82,6 +88,10 @@ void MidiChannel::parseEvents(mixer::FrameEvents fe)
 void MidiChannel::process(AudioBuffer& out, const AudioBuffer& in, bool audible, 
 	bool running)
 {
+	if (isFrozen()) {
+		processFrozen(out, audible);
+		return;
+	}
 	midiChannelProc::process(this, out, in, audible);
 }
 
@@ -167,11 +177,7 @@ void MidiChannel::writePatch(int i, bool isProject)
 
 void MidiChannel::addVstMidiEvent(uint32_t msg, int localFrame)
 {
-	juce::MidiMessage message = juce::MidiMessage(
-		kernelMidi::getB1(msg),
-		kernelMidi::getB2(msg),
-		kernelMidi::getB3(msg));
-	midiBuffer.addEvent(message, localFrame);
+	pluginContext.queue.push({ msg, localFrame });  // Dropped if queue is full
 }
 
 #endif
@@ -195,10 +201,11 @@ void MidiChannel::sendMidi(const Action* a, int localFrame)
 		if (midiOut) {
 			MidiEvent event = a->event;
 			event.setChannel(midiOutChan);
-			kernelMidi::send(event.getRaw());
+			kernelMidi::send(event.getRaw(), localFrame);
 		}
 #ifdef WITH_VST
-		addVstMidiEvent(a->event.getRaw(), localFrame);
+		if (!isFrozen())
+			addVstMidiEvent(a->event.getRaw(), localFrame);
 #endif
 	}
 }
@@ -224,9 +231,7 @@ void MidiChannel::receiveMidi(const MidiEvent& midiEvent)
 
 #ifdef WITH_VST
 
-	pthread_mutex_lock(&pluginHost::mutex);
 	addVstMidiEvent(midiEventFlat.getRaw(), 0);
-	pthread_mutex_unlock(&pluginHost::mutex);
 
 #endif
 
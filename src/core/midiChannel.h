@@ -44,7 +44,7 @@ public:
 
 	MidiChannel(int bufferSize);
 
-	void copy(const Channel* src, pthread_mutex_t* pluginMutex) override;
+	void copy(const Channel* src) override;
 	void parseEvents(mixer::FrameEvents fe) override;
 	void process(AudioBuffer& out, const AudioBuffer& in, bool audible, bool running) override;
 	void start(int frame, bool doQuantize, int velocity) override;
@@ -69,7 +69,8 @@ public:
 	/* addVstMidiEvent
 	Adds a new Midi event to the midiEvent stack fom a composite uint32_t raw
 	Midi event. LocalFrame is the offset: it tells where to put the event
-	inside the buffer. */
+	inside the buffer. Lock-free, can be called from any thread: the event is
+	delivered to plug-ins on the next block. */
 
 	void addVstMidiEvent(uint32_t msg, int localFrame);
 
@@ -56,10 +56,14 @@ void process(MidiChannel* ch, AudioBuffer& out, const AudioBuffer& in, bool audi
 	note-off while triggering a mute/solo. */
 
 	/* TODO - this is meaningful only if WITH_VST is defined */
-	if (audible)
-		for (int i=0; i<out.countFrames(); i++)
+	if (!audible)
+		ch->volumeSmooth.reset();
+	else
+		for (int i=0; i<out.countFrames(); i++) {
+			const float volume = ch->volumeSmooth.next(ch->volume);
 			for (int j=0; j<out.countChannels(); j++)
-				out[i][j] += ch->buffer[i][j] * ch->volume;	
+				out[i][j] += ch->buffer[i][j] * volume;	
+		}
 }
 
 
@@ -25,8 +25,10 @@
  * -------------------------------------------------------------------------- */
 
 
+#include <atomic>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
-#include "../glue/plugin.h"
 #include "../glue/io.h"
 #include "../glue/channel.h"
 #include "../glue/transport.h"
@@ -47,6 +49,8 @@ using std::vector;
 
 namespace giada {
 namespace m {
+class Plugin;
+
 namespace midiDispatcher
 {
 namespace
@@ -60,108 +64,255 @@ void* cb_data_ = nullptr;
 
 std::function<void()> signalCb_ = nullptr;
 
+/* Route
+What a learned MIDI message does: a master action, a channel action or a 
+plug-in parameter change. */
+
+struct Route
+{
+	enum class Type 
+	{ 
+		REWIND, START_STOP, ACTION_REC, INPUT_REC, METRONOME, VOLUME_IN, 
+		VOLUME_OUT, BEAT_DOUBLE, BEAT_HALF, KEY_PRESS, KEY_REL, MUTE, KILL, ARM, 
+		SOLO, VOLUME, PITCH, READ_ACTIONS, PLUGIN_PARAM 
+	};
+
+	Type     type;
+	Channel* ch;
+	Plugin*  plugin;
+	int      param;
+};
+
+/* routes_, receivers_
+Routing table, by 'pure' MIDI message (i.e. no velocity), and the channels 
+that get every message as it is. Owned by the MIDI thread, built from scratch 
+on the first message after invalidate(). */
+
+std::unordered_map<uint32_t, vector<Route>> routes_;
+vector<Channel*> receivers_;
+std::atomic<bool> dirty_(true);
+
+/* epoch_
+Messages dispatched so far, shifted left by one. The lowest bit is set while 
+the MIDI thread is dispatching one, i.e. while it may use the routing table.
+Written by the MIDI thread only. See getEpoch(). */
+
+std::atomic<uint64_t> epoch_(0);
+
+/* controlsChanged_
+Continuous controls (volumes, pitch, plug-in parameters) skip the glue layer: 
+the UI catches up on its next refresh, see fetchControlChanges(). */
+
+std::atomic<bool> controlsChanged_(false);
+
 
 /* -------------------------------------------------------------------------- */
 
+/* addRoute_
+Adds a route for 'pure', unless 'pure' is not set. The old dispatcher picked
+only the first master (or channel) action matching a message: 'taken' keeps 
+track of the messages already used in the current group to do the same. */
 
-#ifdef WITH_VST
+void addRoute_(uint32_t pure, Route r, std::unordered_set<uint32_t>& taken)
+{
+	if (pure == 0x0 || !taken.insert(pure).second)
+		return;
+	routes_[pure].push_back(r);
+}
+
+
+/* -------------------------------------------------------------------------- */
 
-void processPlugins_(Channel* ch, const MidiEvent& midiEvent)
+
+void buildMasterRoutes_()
 {
-	uint32_t pure = midiEvent.getRawNoVelocity();
+	std::unordered_set<uint32_t> taken;
+	addRoute_(conf::midiInRewind,     { Route::Type::REWIND,      nullptr, nullptr, 0 }, taken);
+	addRoute_(conf::midiInStartStop,  { Route::Type::START_STOP,  nullptr, nullptr, 0 }, taken);
+	addRoute_(conf::midiInActionRec,  { Route::Type::ACTION_REC,  nullptr, nullptr, 0 }, taken);
+	addRoute_(conf::midiInInputRec,   { Route::Type::INPUT_REC,   nullptr, nullptr, 0 }, taken);
+	addRoute_(conf::midiInMetronome,  { Route::Type::METRONOME,   nullptr, nullptr, 0 }, taken);
+	addRoute_(conf::midiInVolumeIn,   { Route::Type::VOLUME_IN,   nullptr, nullptr, 0 }, taken);
+	addRoute_(conf::midiInVolumeOut,  { Route::Type::VOLUME_OUT,  nullptr, nullptr, 0 }, taken);
+	addRoute_(conf::midiInBeatDouble, { Route::Type::BEAT_DOUBLE, nullptr, nullptr, 0 }, taken);
+	addRoute_(conf::midiInBeatHalf,   { Route::Type::BEAT_HALF,   nullptr, nullptr, 0 }, taken);
+}
 
-	/* Plugins' parameters layout reflects the structure of the matrix
-	Channel::midiInPlugins. It is safe to assume then that i (i.e. Plugin*) and k 
-	indexes match both the structure of Channel::midiInPlugins and 
-	vector<Plugin*>* plugins. */
 
-	std::vector<Plugin*> plugins = pluginHost::getStack(pluginHost::StackType::CHANNEL, ch);
+/* -------------------------------------------------------------------------- */
+
 
-	for (Plugin* plugin : plugins) {
+void buildChannelRoutes_(Channel* ch)
+{
+	std::unordered_set<uint32_t> taken;
+	addRoute_(ch->midiInKeyPress, { Route::Type::KEY_PRESS, ch, nullptr, 0 }, taken);
+	addRoute_(ch->midiInKeyRel,   { Route::Type::KEY_REL,   ch, nullptr, 0 }, taken);
+	addRoute_(ch->midiInMute,     { Route::Type::MUTE,      ch, nullptr, 0 }, taken);
+	addRoute_(ch->midiInKill,     { Route::Type::KILL,      ch, nullptr, 0 }, taken);
+	addRoute_(ch->midiInArm,      { Route::Type::ARM,       ch, nullptr, 0 }, taken);
+	addRoute_(ch->midiInSolo,     { Route::Type::SOLO,      ch, nullptr, 0 }, taken);
+	addRoute_(ch->midiInVolume,   { Route::Type::VOLUME,    ch, nullptr, 0 }, taken);
+
+	if (ch->type == ChannelType::SAMPLE) {
+		const SampleChannel* sch = static_cast<const SampleChannel*>(ch);
+		addRoute_(sch->midiInPitch,       { Route::Type::PITCH,        ch, nullptr, 0 }, taken);
+		addRoute_(sch->midiInReadActions, { Route::Type::READ_ACTIONS, ch, nullptr, 0 }, taken);
+	}
+	else
+		receivers_.push_back(ch);
+
+#ifdef WITH_VST
+
+	/* Learned plug-in parameters. Every parameter listening to a message is
+	changed, not just the first one. */
+
+	for (Plugin* plugin : pluginHost::getStack(pluginHost::StackType::CHANNEL, ch)) {
 		for (unsigned k=0; k<plugin->midiInParams.size(); k++) {
-			uint32_t midiInParam = plugin->midiInParams.at(k);
-			if (pure != midiInParam)
-				continue;
-			float vf = midiEvent.getVelocity() / 127.0f;
-			c::plugin::setParameter(plugin, k, vf, false); // false: not from GUI
-			gu_log("  >>> [plugin %d parameter %d] ch=%d (pure=0x%X, value=%d, float=%f)\n",
-				plugin->getId(), k, ch->index, pure, midiEvent.getVelocity(), vf);
+			uint32_t pure = plugin->midiInParams.at(k);
+			if (pure != 0x0)
+				routes_[pure].push_back({ Route::Type::PLUGIN_PARAM, ch, plugin, static_cast<int>(k) });
 		}
 	}
-}
 
 #endif
+}
 
 
 /* -------------------------------------------------------------------------- */
 
 
-void processChannels_(const MidiEvent& midiEvent)
+void buildRoutes_()
 {
-	uint32_t pure = midiEvent.getRawNoVelocity();
+	routes_.clear();
+	receivers_.clear();
 
-	for (Channel* ch : mixer::channels) {
+	/* Channels are added and removed with mixer::mutex held. Those removed 
+	are deleted only once this dispatch is over, see getEpoch(). */
 
-		/* Do nothing on this channel if MIDI in is disabled or filtered out for
-		the current MIDI channel. */
+	pthread_mutex_lock(&mixer::mutex);
+	buildMasterRoutes_();
+	for (Channel* ch : mixer::channels)
+		buildChannelRoutes_(ch);
+	pthread_mutex_unlock(&mixer::mutex);
 
-		if (!ch->midiIn || !ch->isMidiInAllowed(midiEvent.getChannel()))
-			continue;
+	gu_log("[midiDispatcher::buildRoutes_] %lu MIDI messages routed, %lu receivers\n",
+		routes_.size(), receivers_.size());
+}
 
-		if      (pure == ch->midiInKeyPress) {
-			gu_log("  >>> keyPress, ch=%d (pure=0x%X)\n", ch->index, pure);
-			c::io::keyPress(ch, false, false, midiEvent.getVelocity());
-		}
-		else if (pure == ch->midiInKeyRel) {
-			gu_log("  >>> keyRel ch=%d (pure=0x%X)\n", ch->index, pure);
-			c::io::keyRelease(ch, false, false);
-		}
-		else if (pure == ch->midiInMute) {
-			gu_log("  >>> mute ch=%d (pure=0x%X)\n", ch->index, pure);
-			c::channel::toggleMute(ch, false);
-		}		
-		else if (pure == ch->midiInKill) {
-			gu_log("  >>> kill ch=%d (pure=0x%X)\n", ch->index, pure);
-			c::channel::kill(ch);
-		}		
-		else if (pure == ch->midiInArm) {
-			gu_log("  >>> arm ch=%d (pure=0x%X)\n", ch->index, pure);
-			c::channel::toggleArm(ch, false);
+
+/* -------------------------------------------------------------------------- */
+
+
+void processRoute_(const Route& r, const MidiEvent& midiEvent)
+{
+	uint32_t pure = midiEvent.getRawNoVelocity();
+	int      velo = midiEvent.getVelocity();
+
+	/* Do nothing on this channel if MIDI in is disabled or filtered out for
+	the current MIDI channel. */
+
+	if (r.ch != nullptr && (!r.ch->midiIn || !r.ch->isMidiInAllowed(midiEvent.getChannel())))
+		return;
+
+	switch (r.type) {
+		case Route::Type::REWIND:
+			gu_log("  >>> rewind (master) (pure=0x%X)\n", pure);
+			c::transport::rewindSeq(false);
+			break;
+		case Route::Type::START_STOP:
+			gu_log("  >>> startStop (master) (pure=0x%X)\n", pure);
+			c::transport::startStopSeq(false);
+			break;
+		case Route::Type::ACTION_REC:
+			gu_log("  >>> actionRec (master) (pure=0x%X)\n", pure);
+			c::io::toggleActionRec(false);
+			break;
+		case Route::Type::INPUT_REC:
+			gu_log("  >>> inputRec (master) (pure=0x%X)\n", pure);
+			c::io::toggleInputRec(false);
+			break;
+		case Route::Type::METRONOME:
+			gu_log("  >>> metronome (master) (pure=0x%X)\n", pure);
+			c::transport::toggleMetronome(false);
+			break;
+		case Route::Type::VOLUME_IN: {
+			float vf = velo / 127.0f;
+			gu_log("  >>> input volume (master) (pure=0x%X, value=%d, float=%f)\n",
+				pure, velo, vf);
+			mixer::inVol.store(vf);
+			controlsChanged_.store(true);
+			break;
 		}
-		else if (pure == ch->midiInSolo) {
-			gu_log("  >>> solo ch=%d (pure=0x%X)\n", ch->index, pure);
-			c::channel::toggleSolo(ch, false);
+		case Route::Type::VOLUME_OUT: {
+			float vf = velo / 127.0f;
+			gu_log("  >>> output volume (master) (pure=0x%X, value=%d, float=%f)\n",
+				pure, velo, vf);
+			mixer::outVol.store(vf);
+			controlsChanged_.store(true);
+			break;
 		}
-		else if (pure == ch->midiInVolume) {
-			float vf = midiEvent.getVelocity() / 127.0f; // TODO: u::math::map
+		case Route::Type::BEAT_DOUBLE:
+			gu_log("  >>> sequencer x2 (master) (pure=0x%X)\n", pure);
+			c::main::beatsMultiply();
+			break;
+		case Route::Type::BEAT_HALF:
+			gu_log("  >>> sequencer /2 (master) (pure=0x%X)\n", pure);
+			c::main::beatsDivide();
+			break;
+		case Route::Type::KEY_PRESS:
+			gu_log("  >>> keyPress, ch=%d (pure=0x%X)\n", r.ch->index, pure);
+			c::io::keyPress(r.ch, false, false, velo);
+			break;
+		case Route::Type::KEY_REL:
+			gu_log("  >>> keyRel ch=%d (pure=0x%X)\n", r.ch->index, pure);
+			c::io::keyRelease(r.ch, false, false);
+			break;
+		case Route::Type::MUTE:
+			gu_log("  >>> mute ch=%d (pure=0x%X)\n", r.ch->index, pure);
+			c::channel::toggleMute(r.ch, false);
+			break;
+		case Route::Type::KILL:
+			gu_log("  >>> kill ch=%d (pure=0x%X)\n", r.ch->index, pure);
+			c::channel::kill(r.ch);
+			break;
+		case Route::Type::ARM:
+			gu_log("  >>> arm ch=%d (pure=0x%X)\n", r.ch->index, pure);
+			c::channel::toggleArm(r.ch, false);
+			break;
+		case Route::Type::SOLO:
+			gu_log("  >>> solo ch=%d (pure=0x%X)\n", r.ch->index, pure);
+			c::channel::toggleSolo(r.ch, false);
+			break;
+		case Route::Type::VOLUME: {
+			float vf = velo / 127.0f; // TODO: u::math::map
 			gu_log("  >>> volume ch=%d (pure=0x%X, value=%d, float=%f)\n",
-				ch->index, pure, midiEvent.getVelocity(), vf);
-			c::channel::setVolume(ch, vf, false);
+				r.ch->index, pure, velo, vf);
+			r.ch->volume = vf;
+			controlsChanged_.store(true);
+			break;
 		}
-		else {
-			SampleChannel* sch = static_cast<SampleChannel*>(ch);
-			if (pure == sch->midiInPitch) {
-				float vf = midiEvent.getVelocity() / (127/4.0f); // [0-127] ~> [0.0-4.0] TODO: u::math::map
-				gu_log("  >>> pitch ch=%d (pure=0x%X, value=%d, float=%f)\n",
-					sch->index, pure, midiEvent.getVelocity(), vf);
-				c::channel::setPitch(sch, vf);
-			}
-			else 
-			if (pure == sch->midiInReadActions) {
-				gu_log("  >>> toggle read actions ch=%d (pure=0x%X)\n", sch->index, pure);
-				c::channel::toggleReadingActions(sch, false);
-			}
+		case Route::Type::PITCH: {
+			float vf = velo / (127/4.0f); // [0-127] ~> [0.0-4.0] TODO: u::math::map
+			gu_log("  >>> pitch ch=%d (pure=0x%X, value=%d, float=%f)\n",
+				r.ch->index, pure, velo, vf);
+			static_cast<SampleChannel*>(r.ch)->setPitch(vf);
+			controlsChanged_.store(true);
+			break;
 		}
-
+		case Route::Type::READ_ACTIONS:
+			gu_log("  >>> toggle read actions ch=%d (pure=0x%X)\n", r.ch->index, pure);
+			c::channel::toggleReadingActions(static_cast<SampleChannel*>(r.ch), false);
+			break;
+		case Route::Type::PLUGIN_PARAM: {
 #ifdef WITH_VST
-
-		/* Process learned plugins parameters. */
-		processPlugins_(ch, midiEvent); 
-
+			float vf = velo / 127.0f;
+			r.plugin->queueParameter(r.param, vf);
+			controlsChanged_.store(true);
+			gu_log("  >>> [plugin %d parameter %d] ch=%d (pure=0x%X, value=%d, float=%f)\n",
+				r.plugin->getId(), r.param, r.ch->index, pure, velo, vf);
 #endif
-
-		/* Redirect full midi message (pure + velocity) to plugins. */
-		ch->receiveMidi(midiEvent.getRaw());
+			break;
+		}
 	}
 }
 
@@ -169,50 +320,21 @@ void processChannels_(const MidiEvent& midiEvent)
 /* -------------------------------------------------------------------------- */
 
 
-void processMaster_(const MidiEvent& midiEvent)
+void process_(const MidiEvent& midiEvent)
 {
-	uint32_t pure = midiEvent.getRawNoVelocity();
+	if (dirty_.exchange(false))
+		buildRoutes_();
 
-	if      (pure == conf::midiInRewind) {
-		gu_log("  >>> rewind (master) (pure=0x%X)\n", pure);
-		c::transport::rewindSeq(false);
-	}
-	else if (pure == conf::midiInStartStop) {
-		gu_log("  >>> startStop (master) (pure=0x%X)\n", pure);
-		c::transport::startStopSeq(false);
-	}
-	else if (pure == conf::midiInActionRec) {
-		gu_log("  >>> actionRec (master) (pure=0x%X)\n", pure);
-		c::io::toggleActionRec(false);
-	}
-	else if (pure == conf::midiInInputRec) {
-		gu_log("  >>> inputRec (master) (pure=0x%X)\n", pure);
-		c::io::toggleInputRec(false);
-	}
-	else if (pure == conf::midiInMetronome) {
-		gu_log("  >>> metronome (master) (pure=0x%X)\n", pure);
-		c::transport::toggleMetronome(false);
-	}
-	else if (pure == conf::midiInVolumeIn) {
-		float vf = midiEvent.getVelocity() / 127.0f;
-		gu_log("  >>> input volume (master) (pure=0x%X, value=%d, float=%f)\n",
-			pure, midiEvent.getVelocity(), vf);
-		c::main::setInVol(vf, false);
-	}
-	else if (pure == conf::midiInVolumeOut) {
-		float vf = midiEvent.getVelocity() / 127.0f;
-		gu_log("  >>> output volume (master) (pure=0x%X, value=%d, float=%f)\n",
-			pure, midiEvent.getVelocity(), vf);
-		c::main::setOutVol(vf, false);
-	}
-	else if (pure == conf::midiInBeatDouble) {
-		gu_log("  >>> sequencer x2 (master) (pure=0x%X)\n", pure);
-		c::main::beatsMultiply();
-	}
-	else if (pure == conf::midiInBeatHalf) {
-		gu_log("  >>> sequencer /2 (master) (pure=0x%X)\n", pure);
-		c::main::beatsDivide();
-	}
+	auto it = routes_.find(midiEvent.getRawNoVelocity());
+	if (it != routes_.end())
+		for (const Route& r : it->second)
+			processRoute_(r, midiEvent);
+
+	/* Redirect full midi message (pure + velocity) to plugins. */
+
+	for (Channel* ch : receivers_)
+		if (ch->midiIn && ch->isMidiInAllowed(midiEvent.getChannel()))
+			ch->receiveMidi(midiEvent.getRaw());
 }
 
 
@@ -273,11 +395,15 @@ void dispatch(int byte1, int byte2, int byte3)
 	then each channel in the stack. This way incoming signals don't get processed 
 	by glue_* when MIDI learning is on. */
 
-	if (cb_learn_)
+	if (cb_learn_) {
 		cb_learn_(midiEvent.getRawNoVelocity(), cb_data_);
+		invalidate();
+	}
 	else {
-		processMaster_(midiEvent);
-		processChannels_(midiEvent);
+		uint64_t epoch = epoch_.load(std::memory_order_relaxed) + 2;
+		epoch_.store(epoch | 1);
+		process_(midiEvent);
+		epoch_.store(epoch);
 		triggerSignalCb_();
 	}	
 }
@@ -286,6 +412,46 @@ void dispatch(int byte1, int byte2, int byte3)
 /* -------------------------------------------------------------------------- */
 
 
+void invalidate()
+{
+	dirty_.store(true);
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+uint64_t getEpoch()
+{
+	return epoch_.load();
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+bool isDone(uint64_t epoch)
+{
+	/* Not safe only if the very same dispatch is still in progress: a message 
+	that came later has seen invalidate() and rebuilt the table. */
+
+	uint64_t now = epoch_.load();
+	return (now & 1) == 0 || now != epoch;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+bool fetchControlChanges()
+{
+	return controlsChanged_.exchange(false);
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
 void setSignalCallback(std::function<void()> f)
 {
 	signalCb_ = f;
@@ -44,6 +44,30 @@ void stopMidiLearn();
 
 void dispatch(int byte1, int byte2, int byte3);
 
+/* invalidate
+Tells the dispatcher that learned MIDI messages, channels or plug-ins have 
+changed: the routing table is rebuilt on the next incoming message. Call it
+right after the change. */
+
+void invalidate();
+
+/* getEpoch, isDone
+The MIDI thread dispatches messages through the routing table with no locks. 
+A channel or a plug-in that goes away must not be deleted while a message 
+already in progress may still reach it: remove it from the engine, call 
+invalidate(), then take getEpoch(). The object can be deleted as soon as 
+isDone() returns true for that epoch. Any thread. */
+
+uint64_t getEpoch();
+bool isDone(uint64_t epoch);
+
+/* fetchControlChanges
+Returns true, once, if MIDI moved any continuous control (volumes, pitch, 
+plug-in parameters) since the last call. These changes go straight to the
+engine, leaving the UI refresh to the caller: at most once per frame. */
+
+bool fetchControlChanges();
+
 void setSignalCallback(std::function<void()> f);
 }}}; // giada::m::midiDispatcher::
 
@@ -0,0 +1,303 @@
+/* -----------------------------------------------------------------------------
+ *
+ * Giada - Your Hardcore Loopmachine
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2019 Giovanni A. Zuliani | Monocasual
+ *
+ * This file is part of Giada - Your Hardcore Loopmachine.
+ *
+ * Giada - Your Hardcore Loopmachine is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * Giada - Your Hardcore Loopmachine is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Giada - Your Hardcore Loopmachine. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------------- */
+
+
+#include <chrono>
+#include <cmath>
+#include "conf.h"
+#include "const.h"
+#include "queue.h"
+#include "midiSync.h"
+
+
+namespace giada {
+namespace m {
+namespace midiSync
+{
+namespace
+{
+constexpr double MTC_FPS[4] = { 24.0, 25.0, 29.97, 30.0 };
+
+Dll dll_(G_MIDI_SYNC_BANDWIDTH);
+Queue<Event, G_MIDI_SYNC_QUEUE_SIZE> events_;
+
+int    ticks_    = 0;      // Ticks since the loop has been (re)started, up to 2
+double prevTime_ = 0.0;    // Raw time of the previous tick
+bool   running_  = false;  // MIDI clock only: master is playing
+double position_ = 0.0;    // Of the next tick: beats (clock) or seconds (MTC)
+
+/* mtc*_
+MTC quarter frames assembly. The timecode is known only after 8 pieces in a 
+row, or after a full frame message. */
+
+int    mtcNibbles_[8] = {};
+int    mtcNext_       = 0;
+int    mtcCount_      = 0;
+double mtcFps_        = 25.0;
+bool   mtcValid_      = false;
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void push_(Event::Type type, double time, double position, double period)
+{
+	events_.push({ type, time, position, period });  // Full: nobody is reading
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+/* tick_
+A periodic message (clock tick or MTC quarter frame) arrived at 'time'. Fills 
+'filtered' and returns true, or returns false while the period is still 
+unknown. */
+
+bool tick_(double time, double& filtered)
+{
+	if (ticks_ == 0) {
+		prevTime_ = time;
+		ticks_++;
+		return false;
+	}
+
+	/* First period, or the master has jumped (tempo change, hiccup): the loop 
+	would take too long to catch up, so it starts over. */
+
+	if (ticks_ == 1 || std::abs(dll_.getError(time)) > dll_.getPeriod() * 0.5) {
+		dll_.reset(time, time - prevTime_);
+		filtered = time;
+		ticks_   = 2;
+	}
+	else
+		filtered = dll_.update(time);
+
+	prevTime_ = time;
+	return true;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void receiveClock_(const unsigned char* msg, std::size_t size, double time)
+{
+	switch (msg[0]) {
+		case MIDI_START:
+			running_  = true;
+			position_ = 0.0;
+			push_(Event::Type::START, time, position_, 0.0);
+			break;
+
+		case MIDI_CONTINUE:
+			running_ = true;
+			push_(Event::Type::START, time, position_, 0.0);
+			break;
+
+		case MIDI_STOP:
+			running_ = false;
+			push_(Event::Type::STOP, time, position_, 0.0);
+			break;
+
+		case MIDI_POSITION_PTR:  // In 16th notes, 14 bits
+			if (size < 3)
+				return;
+			position_ = ((msg[2] << 7) | msg[1]) / 4.0;
+			push_(Event::Type::POSITION, time, position_, 0.0);
+			break;
+
+		case MIDI_CLOCK: {
+			double filtered;
+			if (tick_(time, filtered))
+				push_(Event::Type::TICK, filtered, position_, dll_.getPeriod());
+			if (running_)
+				position_ += 1.0 / G_MIDI_CLOCK_PPQ;
+			break;
+		}
+
+		default:
+			break;
+	}
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void receiveMtc_(const unsigned char* msg, std::size_t size, double time)
+{
+	/* Full frame: F0 7F <device> 01 01 hh mm ss ff F7. Rate lives in bits 5-6 
+	of the hours byte. */
+
+	if (msg[0] == MIDI_SYSEX) {
+		if (size < 10 || msg[1] != 0x7F || msg[3] != 0x01 || msg[4] != 0x01)
+			return;
+		mtcFps_   = MTC_FPS[(msg[5] >> 5) & 0x03];
+		position_ = (msg[5] & 0x1F) * 3600.0 + msg[6] * 60.0 + msg[7] + msg[8] / mtcFps_;
+		mtcValid_ = true;
+		mtcCount_ = 0;
+		ticks_    = 0;  // The master has just relocated
+		push_(Event::Type::POSITION, time, position_, 0.0);
+		return;
+	}
+
+	if (msg[0] != MIDI_MTC_QUARTER || size < 2)
+		return;
+
+	int piece = msg[1] >> 4;
+	mtcNibbles_[piece] = msg[1] & 0x0F;
+	mtcCount_ = piece == mtcNext_ ? mtcCount_ + 1 : (piece == 0 ? 1 : 0);
+	mtcNext_  = (piece + 1) % 8;
+
+	if (mtcValid_)
+		position_ += 1.0 / (mtcFps_ * 4);
+
+	/* A complete timecode refers to the time piece 0 was sent: piece 7 comes 
+	7 quarter frames later. */
+
+	if (piece == 7 && mtcCount_ >= 8) {
+		mtcFps_ = MTC_FPS[(mtcNibbles_[7] >> 1) & 0x03];
+		int frames  = mtcNibbles_[0] | (mtcNibbles_[1] << 4);
+		int seconds = mtcNibbles_[2] | (mtcNibbles_[3] << 4);
+		int minutes = mtcNibbles_[4] | (mtcNibbles_[5] << 4);
+		int hours   = mtcNibbles_[6] | ((mtcNibbles_[7] & 0x01) << 4);
+		position_ = hours * 3600.0 + minutes * 60.0 + seconds + (frames + 1.75) / mtcFps_;
+		mtcValid_ = true;
+	}
+
+	double filtered;
+	if (tick_(time, filtered) && mtcValid_)
+		push_(Event::Type::TICK, filtered, position_, dll_.getPeriod());
+}
+} // {anonymous}
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+
+Dll::Dll(double bandwidth)
+: m_bandwidth(bandwidth),
+  m_b        (0.0),
+  m_c        (0.0),
+  m_t0       (0.0),
+  m_t1       (0.0),
+  m_e2       (0.0)
+{
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void Dll::reset(double time, double period)
+{
+	double omega = 2.0 * std::acos(-1.0) * m_bandwidth * period;
+	m_b  = std::sqrt(2.0) * omega;
+	m_c  = omega * omega;
+	m_e2 = period;
+	m_t0 = time;
+	m_t1 = time + period;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+double Dll::update(double time)
+{
+	double e = time - m_t1;
+	m_t0  = m_t1;
+	m_t1 += m_b * e + m_e2;
+	m_e2 += m_c * e;
+	return m_t0;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+double Dll::getPeriod() const { return m_e2; }
+double Dll::getError(double time) const { return time - m_t1; }
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+
+double getTime()
+{
+	using namespace std::chrono;
+	return duration<double>(steady_clock::now().time_since_epoch()).count();
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void receive(const unsigned char* msg, std::size_t size, double time)
+{
+	if (size == 0)
+		return;
+	if (conf::midiSync == MIDI_SYNC_CLOCK_S)
+		receiveClock_(msg, size, time);
+	else
+	if (conf::midiSync == MIDI_SYNC_MTC_S)
+		receiveMtc_(msg, size, time);
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+bool getEvent(Event& e)
+{
+	return events_.pop(e);
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void reset()
+{
+	Event e;
+	while (events_.pop(e));
+
+	dll_      = Dll(G_MIDI_SYNC_BANDWIDTH);
+	ticks_    = 0;
+	prevTime_ = 0.0;
+	running_  = false;
+	position_ = 0.0;
+	mtcNext_  = 0;
+	mtcCount_ = 0;
+	mtcFps_   = 25.0;
+	mtcValid_ = false;
+}
+}}} // giada::m::midiSync::
@@ -0,0 +1,131 @@
+/* -----------------------------------------------------------------------------
+ *
+ * Giada - Your Hardcore Loopmachine
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2019 Giovanni A. Zuliani | Monocasual
+ *
+ * This file is part of Giada - Your Hardcore Loopmachine.
+ *
+ * Giada - Your Hardcore Loopmachine is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * Giada - Your Hardcore Loopmachine is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Giada - Your Hardcore Loopmachine. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------------- */
+
+
+#ifndef G_MIDI_SYNC_H
+#define G_MIDI_SYNC_H
+
+
+#include <cstddef>
+
+
+namespace giada {
+namespace m {
+namespace midiSync
+{
+/* Dll
+Second order delay-locked loop (F. Adriaensen, "Using a DLL to filter time"). 
+Fed with the arrival times of a periodic event, it estimates the period and a
+jitter-free time for each occurrence. 'bandwidth' is in Hz: lower is smoother
+but slower to follow tempo changes. */
+
+class Dll
+{
+public:
+
+	Dll(double bandwidth);
+
+	/* reset
+	Restarts the loop from an event received at 'time', 'period' seconds after 
+	the previous one. */
+
+	void reset(double time, double period);
+
+	/* update
+	Feeds a new event received at 'time'. Returns its filtered time. */
+
+	double update(double time);
+
+	double getPeriod() const;
+
+	/* getError
+	Difference between the time of the next event and the predicted one. */
+
+	double getError(double time) const;
+
+private:
+
+	double m_bandwidth;
+	double m_b;
+	double m_c;
+	double m_t0;  // Filtered time of the last event
+	double m_t1;  // Predicted time of the next event
+	double m_e2;  // Period
+};
+
+
+/* -------------------------------------------------------------------------- */
+
+
+/* Event
+What the master has told us, for the audio thread. 'position' is in beats for
+MIDI clock, in seconds for MTC. 'time' is the filtered time of a TICK and 
+'period' the interval between two of them (a clock tick or a MTC quarter 
+frame). */
+
+struct Event
+{
+	enum class Type { START, STOP, POSITION, TICK };
+
+	Type   type;
+	double time;
+	double position;
+	double period;
+};
+
+
+/* -------------------------------------------------------------------------- */
+
+
+/* getTime
+Current time in seconds, on the same steady clock incoming messages are 
+timestamped with. */
+
+double getTime();
+
+/* receive
+Parses a system message (clock, start, continue, stop, song position pointer,
+MTC quarter frame or full frame) of 'size' bytes, received at 'time'. Does 
+nothing unless Giada is a MIDI clock or MTC slave. MIDI thread only; tests 
+call it to replay recorded streams. */
+
+void receive(const unsigned char* msg, std::size_t size, double time);
+
+/* getEvent
+Pops the next pending event, if any. Never blocks nor allocates: audio thread
+only. */
+
+bool getEvent(Event& e);
+
+/* reset
+Forgets any sync state and pending event. Not thread safe: call it when MIDI 
+input is closed or from tests. */
+
+void reset();
+}}} // giada::m::midiSync::
+
+
+#endif
@@ -25,15 +25,19 @@
  * -------------------------------------------------------------------------- */
 
 
+#include <algorithm>
 #include <cassert>
+#include <cmath>
 #include <cstring>
 #include "../deps/rtaudio-mod/RtAudio.h"
 #include "../utils/log.h"
 #include "../utils/math.h"
 #include "wave.h"
 #include "kernelAudio.h"
+#include "kernelMidi.h"
 #include "recorder.h"
 #include "pluginHost.h"
+#include "pluginManager.h"
 #include "conf.h"
 #include "mixerHandler.h"
 #include "clock.h"
@@ -43,6 +47,11 @@
 #include "midiChannel.h"
 #include "audioBuffer.h"
 #include "action.h"
+#include "engineState.h"
+#include "takeWriter.h"
+#include "retroCapture.h"
+#include "latencyProbe.h"
+#include "smoothedValue.h"
 #include "mixer.h"
 
 
@@ -93,22 +102,33 @@ struct Metronome
 	}
 } metronome_;
 
-/* vChanInput
-Virtual channel for input recording. */
-
-AudioBuffer vChanInput_;
-
 /* vChanInToOut
 Virtual channel in->out bridge (hear what you're playin). */
 
 AudioBuffer vChanInToOut_;
 
-/* inputTracker
-Frame position while recording. */
+/* vChanDirectOut_
+Work buffer for channels with a direct output: they are rendered here on 
+their own first, then mixed into the main output. */
+
+AudioBuffer vChanDirectOut_;
+
+/* inVolSmooth_, outVolSmooth_
+Master volumes, smoothed frame by frame. Audio thread only. */
+
+SmoothedValue inVolSmooth_;
+SmoothedValue outVolSmooth_;
 
-Frame inputTracker_ = 0;
+/* preRoll_, preRollTracker_
+Input pre-roll: a circular buffer holding the most recent input frames. Lets a
+signal-triggered take include a short lookback before the threshold crossing.
+Audio thread only. */
+
+AudioBuffer preRoll_;
+Frame       preRollTracker_ = 0;
 
 std::function<void()> signalCb_ = nullptr;
+Frame signalLookback_ = 0;
 
 
 /* -------------------------------------------------------------------------- */
@@ -126,46 +146,110 @@ void computePeak_(const AudioBuffer& buf, std::atomic<float>& peak)
 /* -------------------------------------------------------------------------- */
 
 /* lineInRec
-Records from line in. */
+Records from line in. Input is just queued here: the take writer thread does
+the overdub and the disk streaming. */
 
-void lineInRec_(const AudioBuffer& inBuf)
+void lineInRec_(const AudioBuffer& inBuf, Frame from)
 {
 	if (!mh::hasArmedSampleChannels() || !kernelAudio::isInputEnabled() || !recording)
 		return;
+	takeWriter::push(inBuf, inVol.load(), from, -1, clock::getWrapFrame());
+}
 
-	for (int i=0; i<inBuf.countFrames(); i++, inputTracker_++)
-		for (int j=0; j<inBuf.countChannels(); j++) {
-			if (inputTracker_ >= clock::getFramesInLoop())
-				inputTracker_ = 0;
-			vChanInput_[inputTracker_][j] += inBuf[i][j] * inVol.load();  // adding: overdub!
-		}
+
+/* -------------------------------------------------------------------------- */
+
+/* writePreRoll_
+Appends the input block to the pre-roll circular buffer. */
+
+void writePreRoll_(const AudioBuffer& inBuf)
+{
+	for (int i=0; i<inBuf.countFrames(); i++) {
+		preRoll_.copyFrame(preRollTracker_, inBuf[i]);
+		if (++preRollTracker_ >= preRoll_.countFrames())
+			preRollTracker_ = 0;
+	}
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+/* findSignal_
+Returns the first frame in 'inBuf' above the rec trigger threshold, or -1 if 
+the input is below it. */
+
+Frame findSignal_(const AudioBuffer& inBuf)
+{
+	float threshold = u::math::dBtoLinear(conf::recTriggerLevel);
+	for (int i=0; i<inBuf.countFrames(); i++)
+		for (int j=0; j<inBuf.countChannels(); j++)
+			if (std::fabs(inBuf[i][j]) > threshold)
+				return i;
+	return -1;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+/* startOnSignal_
+Starts the armed input recording from frame 'frame' of the current block. The
+crossing frame becomes frame 0 of the take; the lookback frames before it, taken
+from the pre-roll and the current block, are queued first and land at the end 
+of the take (see mh::startInputRec()). */
+
+void startOnSignal_(const AudioBuffer& inBuf, Frame frame)
+{
+	signalCb_();
+	signalCb_ = nullptr;
+
+	startInputRec();
+
+	Frame fromPreRoll = std::max(0, signalLookback_ - frame);
+	Frame begin       = preRollTracker_ - fromPreRoll;
+	if (begin < 0) {
+		takeWriter::push(preRoll_, inVol.load(), preRoll_.countFrames() + begin);
+		begin = 0;
+	}
+	takeWriter::push(preRoll_, inVol.load(), begin, preRollTracker_);
+	takeWriter::push(inBuf, inVol.load(), std::max(0, frame - signalLookback_), frame);
 }
 
 
 /* -------------------------------------------------------------------------- */
 
 /* processLineIn
-Computes line in peaks, plus handles "hear what you're playin'" thing. */
+Computes line in peaks, plus handles "hear what you're playin'" thing. Returns
+the frame where the rec trigger signal fired in this block, 0 otherwise. */
 
-void processLineIn_(const AudioBuffer& inBuf)
+Frame processLineIn_(const AudioBuffer& inBuf)
 {
 	if (!kernelAudio::isInputEnabled())
-		return;
+		return 0;
 
 	computePeak_(inBuf, peakIn);
 
-	if (signalCb_ != nullptr && u::math::linearToDB(peakIn) > conf::recTriggerLevel) {
-		signalCb_();
-		signalCb_ = nullptr;
+	Frame signalFrame = 0;
+	if (signalCb_ != nullptr) {
+		Frame f = findSignal_(inBuf);
+		if (f != -1) {
+			startOnSignal_(inBuf, f);
+			signalFrame = f;
+		}
 	}
 
+	writePreRoll_(inBuf);
+
 	/* "hear what you're playing" - process, copy and paste the input buffer onto 
 	the output buffer. */
 
 	if (inToOut)
-		for (int i=0; i<vChanInToOut_.countFrames(); i++)
+		for (int i=0; i<vChanInToOut_.countFrames(); i++) {
+			const float vol = inVolSmooth_.next(inVol.load());
 			for (int j=0; j<vChanInToOut_.countChannels(); j++)
-				vChanInToOut_[i][j] = inBuf[i][j] * inVol.load();
+				vChanInToOut_[i][j] = inBuf[i][j] * vol;
+		}
+
+	return signalFrame;
 }
 
 
@@ -210,8 +294,18 @@ content to the output buffer). Process plugins too, if any. */
 
 void renderIO_(AudioBuffer& outBuf, const AudioBuffer& inBuf)
 {
-	for (Channel* channel : channels)
-		channel->process(outBuf, inBuf, isChannelAudible(channel), clock::isRunning());
+	for (Channel* channel : channels) {
+		if (channel->directOut == nullptr) {
+			channel->process(outBuf, inBuf, isChannelAudible(channel), clock::isRunning());
+			continue;
+		}
+		vChanDirectOut_.clear();
+		channel->process(vChanDirectOut_, inBuf, isChannelAudible(channel), clock::isRunning());
+		kernelAudio::writeDirectOut(channel->directOut, vChanDirectOut_);
+		for (int i=0; i<outBuf.countFrames(); i++)
+			for (int j=0; j<outBuf.countChannels(); j++)
+				outBuf[i][j] += vChanDirectOut_[i][j];
+	}
 
 #ifdef WITH_VST
 	pluginHost::processStack(outBuf, pluginHost::StackType::MASTER_OUT);
@@ -244,12 +338,14 @@ output volume. */
 
 void finalizeOutput_(AudioBuffer& outBuf)
 {
-	for (int i=0; i<outBuf.countFrames(); i++)
+	for (int i=0; i<outBuf.countFrames(); i++) {
+		const float vol = outVolSmooth_.next(outVol.load());
 		for (int j=0; j<outBuf.countChannels(); j++) {
 			if (inToOut) // Merge vChanInToOut_, if enabled
 				outBuf[i][j] += vChanInToOut_[i][j];
-			outBuf[i][j] *= outVol.load(); 
+			outBuf[i][j] *= vol; 
 		}
+	}
 }
 
 
@@ -314,16 +410,14 @@ pthread_mutex_t mutex;
 /* -------------------------------------------------------------------------- */
 
 
-void init(Frame framesInSeq, Frame framesInBuffer)
+void init(Frame framesInBuffer)
 {
-	/* Allocate virtual input channels. vChanInput_ has variable size: it depends
-	on how many frames there are in sequencer. */
-	
-	vChanInput_.alloc(framesInSeq, G_MAX_IO_CHANS);
 	vChanInToOut_.alloc(framesInBuffer, G_MAX_IO_CHANS);
+	vChanDirectOut_.alloc(framesInBuffer, G_MAX_IO_CHANS);
+	preRoll_.alloc(conf::samplerate * G_MAX_REC_TRIGGER_LOOKBACK / 1000, G_MAX_IO_CHANS);
+	preRollTracker_ = 0;
 
-	gu_log("[Mixer::init] buffers ready - framesInSeq=%d, framesInBuffer=%d\n", 
-		framesInSeq, framesInBuffer);	
+	gu_log("[Mixer::init] buffers ready - framesInBuffer=%d\n", framesInBuffer);	
 
 	hasSolos = false;
 
@@ -336,9 +430,19 @@ void init(Frame framesInSeq, Frame framesInBuffer)
 /* -------------------------------------------------------------------------- */
 
 
-void allocVirtualInput(Frame frames)
+void setBufferSize(Frame framesInBuffer)
 {
-	vChanInput_.alloc(frames, G_MAX_IO_CHANS);
+	vChanInToOut_.alloc(framesInBuffer, G_MAX_IO_CHANS);
+	vChanDirectOut_.alloc(framesInBuffer, G_MAX_IO_CHANS);
+	for (Channel* ch : channels)
+		ch->setBufferSize(framesInBuffer);
+
+#ifdef WITH_VST
+	pluginHost::setBufferSize(framesInBuffer, &channels);
+	pluginManager::setBufferSize(framesInBuffer);
+#endif
+
+	gu_log("[Mixer::setBufferSize] buffers ready - framesInBuffer=%d\n", framesInBuffer);
 }
 
 
@@ -351,9 +455,17 @@ int masterPlay(void* outBuf, void* inBuf, unsigned bufferSize,
 	if (!ready)
 		return 0;
 
+#ifdef WITH_VST
+	pluginHost::beginBlock();
+#endif
+
+	kernelMidi::beginBlock();
+
 #ifdef __linux__
 	clock::recvJackSync();
 #endif
+	if (clock::recvMidiSync())
+		rewind();
 
 	AudioBuffer out, in;
 	out.setData((float*) outBuf, bufferSize, G_MAX_IO_CHANS);
@@ -364,24 +476,33 @@ int masterPlay(void* outBuf, void* inBuf, unsigned bufferSize,
 	peakIn.store(0.0);   // reset peak calculator
 
 	prepareBuffers_(out);
-	processLineIn_(in);
+
+	/* If the rec trigger fires in this block, the sequencer starts right on the
+	signal frame, not at the beginning of the block. */
+
+	Frame signalFrame = processLineIn_(in);
+	if (kernelAudio::isInputEnabled())
+		retroCapture::write(in, inVol.load(), signalFrame);
 
 	pthread_mutex_lock(&mutex);
 
+	clock::beginBlock(signalFrame);
+
 	if (clock::isActive()) {
-		for (unsigned j=0; j<bufferSize; j++) {
+		for (unsigned j=signalFrame; j<bufferSize; j++) {
 			if (clock::isRunning()) {
 				parseEvents_(j);
 				doQuantize_(j);
 			}
-			clock::sendMIDIsync();
+			clock::sendMIDIsync(j);
 			clock::incrCurrentFrame();
 			renderMetronome_(out, j);
 		}
-		lineInRec_(in);
+		lineInRec_(in, signalFrame);
 	}
 
 	renderIO_(out, in);
+	engineState::writeChannels();
 
 	pthread_mutex_unlock(&mutex);
 
@@ -389,8 +510,18 @@ int masterPlay(void* outBuf, void* inBuf, unsigned bufferSize,
 
 	finalizeOutput_(out);
 	limitOutput_(out);
+	if (kernelAudio::isInputEnabled())
+		latencyProbe::process(out, in);
 	computePeak_(out, peakOut);
 
+	/* Let the UI know what happened in this block. */
+
+	engineState::publish();
+
+#ifdef WITH_VST
+	pluginHost::endBlock();
+#endif
+
 	/* Unset data in buffers. If you don't do this, buffers go out of scope and
 	destroy memory allocated by RtAudio ---> havoc. */
 	out.setData(nullptr, 0, 0);
@@ -452,9 +583,7 @@ void rewind()
 
 void startInputRec()
 {
-	/* Start inputTracker_ from the current frame, not the beginning. */
-	recording     = true;
-	inputTracker_ = clock::getCurrentFrame();
+	recording = true;
 }
 
 /* -------------------------------------------------------------------------- */
@@ -477,23 +606,17 @@ void setMetronome(bool v)
 
 void setSignalCallback(std::function<void()> f)
 {
-	signalCb_ = f;
+	signalLookback_ = getRecTriggerLookback();
+	signalCb_       = f;
 }
 
 
 /* -------------------------------------------------------------------------- */
 
 
-void mergeVirtualInput()
+Frame getRecTriggerLookback()
 {
-	for (Channel* ch : channels) {
-		/* TODO - move this to audioProc::*/
-		if (ch->type == ChannelType::MIDI)
-			continue;
-		SampleChannel* sch = static_cast<SampleChannel*>(ch);
-		if (sch->armed)
-			sch->wave->copyData(vChanInput_[0], vChanInput_.countFrames());
-	}
-	vChanInput_.clear();
+	Frame frames = conf::recTriggerLookback * conf::samplerate / 1000;
+	return std::min({ frames, preRoll_.countFrames(), clock::getFramesInLoop() });
 }
 }}}; // giada::m::mixer::
@@ -76,13 +76,14 @@ extern bool inToOut;
 
 extern pthread_mutex_t mutex;
 
-void init(Frame framesInSeq, Frame framesInBuffer);
+void init(Frame framesInBuffer);
 
-/* allocVirtualInput
-Allocates new memory for the virtual input channel. Call this whenever you 
-shrink or resize the sequencer. */
+/* setBufferSize
+Follows a change in the audio block size: reallocates the mixer, channel and 
+plug-in buffers. Call it while holding mixer::mutex, when the audio thread is 
+not processing. */
 
-void allocVirtualInput(Frame frames);
+void setBufferSize(Frame framesInBuffer);
 
 void close();
 
@@ -105,21 +106,25 @@ Rewinds sequencer to frame 0. */
 void rewind();
 
 /* startInputRec
-Starts input recording on frame clock::getCurrentFrame(). */
+Starts feeding the input to the take writer. Call takeWriter::start() first. */
 
 void startInputRec();
 
-/* mergeVirtualInput
-Copies the virtual channel input in the channels designed for input recording. 
-Called by mixerHandler on stopInputRec(). */
-
-void mergeVirtualInput();
-
 void toggleMetronome();
 bool isMetronomeOn();
 void setMetronome(bool v);
 
+/* setSignalCallback
+Arms the rec trigger: 'f' is called from the audio thread as soon as the input
+crosses conf::recTriggerLevel. Armed input recording, if any, starts on that 
+very frame. */
+
 void setSignalCallback(std::function<void()> f);
+
+/* getRecTriggerLookback
+Returns how many frames before the rec trigger signal go into the take. */
+
+Frame getRecTriggerLookback();
 }}} // giada::m::mixer::;
 
 
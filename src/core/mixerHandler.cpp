@@ -28,6 +28,7 @@
 #include <cassert>
 #include <vector>
 #include <algorithm>
+#include <FL/Fl.H>
 #include "../utils/fs.h"
 #include "../utils/string.h"
 #include "../utils/log.h"
@@ -49,11 +50,14 @@
 #include "channel.h"
 #include "kernelAudio.h"
 #include "midiMapConf.h"
+#include "midiDispatcher.h"
 #include "sampleChannel.h"
 #include "midiChannel.h"
 #include "wave.h"
 #include "waveManager.h"
 #include "channelManager.h"
+#include "takeWriter.h"
+#include "audioBuffer.h"
 #include "mixerHandler.h"
 
 
@@ -67,24 +71,58 @@ namespace mh
 {
 namespace
 {
+/* garbage_
+Removed channels the MIDI thread might still be dispatching a message to, 
+with the midiDispatcher epoch they were removed at. Main thread only. */
+
+vector<std::pair<Channel*, uint64_t>> garbage_;
+
+
+/* -------------------------------------------------------------------------- */
+
+/* collectGarbage_
+Deletes the removed channels the MIDI thread is done with. Returns true if 
+some are still pending. */
+
+bool collectGarbage_()
+{
+	auto it = std::partition(garbage_.begin(), garbage_.end(), 
+		[](const std::pair<Channel*, uint64_t>& g) { return !midiDispatcher::isDone(g.second); });
+	for (auto i = it; i != garbage_.end(); ++i)
+		delete i->first;
+	garbage_.erase(it, garbage_.end());
+	return !garbage_.empty();
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+/* garbageTick_
+Main thread timer, running as long as there are channels to delete. */
+
+void garbageTick_(void*)
+{
+	if (collectGarbage_())
+		Fl::repeat_timeout(G_MIDI_RECLAIM_RATE, garbageTick_);
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
 #ifdef WITH_VST
 
-int readPatchPlugins_(const vector<patch::plugin_t>& list, pluginHost::StackType t)
+void readPatchPlugins_(const vector<patch::plugin_t>& list, pluginHost::StackType t)
 {
-	int ret = 1;
 	for (const patch::plugin_t& ppl : list) {
-		std::unique_ptr<Plugin> p = pluginManager::makePlugin(ppl.path);
-		if (p != nullptr) {
-			p->setBypass(ppl.bypass);
-			for (unsigned j=0; j<ppl.params.size(); j++)
-				p->setParameter(j, ppl.params.at(j));
-			pluginHost::addPlugin(std::move(p), t, &mixer::mutex, nullptr);
-			ret &= 1;
-		}
-		else
-			ret &= 0;
+		pluginManager::makePluginAsync(ppl.path, t, nullptr, [ppl] (Plugin& p)
+		{
+			p.setBypass(ppl.bypass);
+			if (ppl.state.empty() || !p.setState(ppl.state))
+				for (unsigned j=0; j<ppl.params.size(); j++)
+					p.setParameter(j, ppl.params.at(j));
+		});
 	}
-	return ret;
 }
 
 #endif
@@ -110,6 +148,30 @@ int getNewChanIndex()
 }
 
 
+/* -------------------------------------------------------------------------- */
+
+/* takePlaceholder_
+Silent stand-in for the take while recording, shared by all the recording 
+channels: the writer thread fills the real take on its own, which is handed
+over on stop. */
+
+std::shared_ptr<AudioBuffer> takePlaceholder_;
+
+
+/* -------------------------------------------------------------------------- */
+
+/* isRecordingTake_
+Whether the current take is being recorded into channel 'ch'. */
+
+bool isRecordingTake_(const Channel* ch)
+{
+	if (ch->type != ChannelType::SAMPLE || takePlaceholder_ == nullptr)
+		return false;
+	const SampleChannel* sch = static_cast<const SampleChannel*>(ch);
+	return sch->wave != nullptr && sch->wave->getFrame(0) == (*takePlaceholder_)[0];
+}
+
+
 }; // {anonymous}
 
 
@@ -144,6 +206,16 @@ Channel* addChannel(ChannelType type)
 	pthread_mutex_unlock(&mixer::mutex);
 
 	ch->index = getNewChanIndex();
+
+	/* Ports are registered outside the lock, then attached: from now on the 
+	mixer renders the channel to its direct output too. */
+
+	kernelAudio::DirectOut* directOut = kernelAudio::addDirectOut(ch->index);
+	pthread_mutex_lock(&mixer::mutex);
+	ch->directOut = directOut;
+	pthread_mutex_unlock(&mixer::mutex);
+
+	midiDispatcher::invalidate();
 	gu_log("[addChannel] channel index=%d added, type=%d, total=%d\n",
 		ch->index, ch->type, mixer::channels.size());
 	return ch;
@@ -158,10 +230,32 @@ void deleteChannel(Channel* target)
 	int index = u::vector::indexOf(mixer::channels, target);
 	assert(index != -1);
 	
+	kernelAudio::DirectOut* directOut = target->directOut;
+
+#ifdef WITH_VST
+
+	/* Editors are GUI stuff: close them now, not whenever the plug-ins are 
+	destroyed. */
+
+	for (Plugin* p : pluginHost::getStack(pluginHost::StackType::CHANNEL, target))
+		p->closeEditor();
+
+#endif
+
 	pthread_mutex_lock(&mixer::mutex);
-	delete mixer::channels.at(index);
 	mixer::channels.erase(mixer::channels.begin() + index);
 	pthread_mutex_unlock(&mixer::mutex);
+
+	kernelAudio::removeDirectOut(directOut);
+
+	/* The audio thread is done with the channel, the MIDI thread maybe not: it
+	could be dispatching a message through an old routing table. Delete the 
+	channel once it has moved on, right away in most cases. */
+
+	midiDispatcher::invalidate();
+	garbage_.push_back({ target, midiDispatcher::getEpoch() });
+	if (collectGarbage_() && !Fl::has_timeout(garbageTick_))
+		Fl::add_timeout(G_MIDI_RECLAIM_RATE, garbageTick_);
 }
 
 
@@ -226,12 +320,16 @@ void readPatch()
 
 #endif
 
-	/* Rewind and update frames in Mixer. Also alloc new space in the virtual
-	input buffer, in case the patch has a sequencer size != default one (which is
-	very likely). */
+	/* Channels have been read by now, along with their learned MIDI messages. 
+	Their indexes come from the patch: direct outputs follow. */
+
+	midiDispatcher::invalidate();
+	for (Channel* ch : mixer::channels)
+		kernelAudio::renameDirectOut(ch->directOut, ch->index);
+
+	/* Rewind and update frames in Mixer. */
 
 	mixer::rewind();
-	mixer::allocVirtualInput(clock::getFramesInLoop());
 	mixer::ready = true;
 }
 
@@ -251,11 +349,38 @@ void rewindSequencer()
 /* -------------------------------------------------------------------------- */
 
 
-bool startInputRec()
+bool startInputRec(bool onSignal)
 {
 	if (!hasRecordableSampleChannels())
 		return false;
 
+	/* One take for all recording channels, streamed to disk in the takes 
+	directory and named after the first channel. */
+
+	string takesDir = gu_getHomePath() + G_SLASH + G_TAKES_DIR;
+	if (!gu_dirExists(takesDir) && !gu_mkdir(takesDir))
+		gu_log("[startInputRec] unable to create takes directory %s\n", takesDir.c_str());
+
+	/* When triggered by signal, the take starts on the very signal frame, while
+	the lookback frames before it are queued first: they belong to the end of
+	the loop. Otherwise the input is late by the round-trip latency with 
+	respect to what's being played: move it back by that amount, on each loop
+	wrap too. No need to compensate in the former case, the sequencer starts 
+	on the input itself: the lookback only shifts the first pass. */
+
+	Frame loop    = clock::getFramesInLoop();
+	Frame latency = onSignal ? 0 : conf::recLatency;
+	Frame offset  = onSignal 
+		? (loop - mixer::getRecTriggerLookback()) % loop 
+		: ((clock::getCurrentFrame() - latency) % loop + loop) % loop;
+
+	takeWriter::start(loop, offset, latency, conf::samplerate, 
+		kernelAudio::getRealBufSize(), takesDir + G_SLASH + "TAKE-" + 
+		u::string::iToString(patch::lastTakeId) + ".wav");
+
+	takePlaceholder_ = std::make_shared<AudioBuffer>();
+	takePlaceholder_->alloc(loop, G_MAX_IO_CHANS);
+
 	for (Channel* ch : mixer::channels) {
 
 		if (!ch->canInputRec())
@@ -263,20 +388,22 @@ bool startInputRec()
 
 		SampleChannel* sch = static_cast<SampleChannel*>(ch);
 
-		/* Allocate empty sample for the current channel. */
+		/* Reference the shared placeholder from the current channel: no 
+		copies. */
 
 		string name    = string("TAKE-" + u::string::iToString(patch::lastTakeId++));
 		string nameExt = name + ".wav";
 
-		sch->pushWave(waveManager::createEmpty(clock::getFramesInLoop(), 
-			G_MAX_IO_CHANS, conf::samplerate, nameExt));
+		sch->pushWave(waveManager::createFromBuffer(takePlaceholder_, 
+			conf::samplerate, nameExt));
 		sch->name = name; 
 
 		gu_log("[startInputRec] start input recs using Channel %d with size %d "
 			"on frame=%d\n", sch->index, clock::getFramesInLoop(), clock::getCurrentFrame());
 	}
 
-	mixer::startInputRec();
+	if (!onSignal)
+		mixer::startInputRec();
 	return true;
 }
 
@@ -286,8 +413,19 @@ bool startInputRec()
 
 void stopInputRec()
 {
-	mixer::mergeVirtualInput();
 	mixer::recording = false;
+	takeWriter::stop();
+
+	/* The take is complete: swap it in place of the placeholder, between two
+	audio blocks. The placeholder is freed outside the lock. */
+
+	std::shared_ptr<AudioBuffer> take = takeWriter::getTake();
+	pthread_mutex_lock(&mixer::mutex);
+	for (Channel* ch : mixer::channels)
+		if (isRecordingTake_(ch))
+			static_cast<SampleChannel*>(ch)->wave->shareData(take);
+	pthread_mutex_unlock(&mixer::mutex);
+	takePlaceholder_.reset();
 
 	for (Channel* ch : mixer::channels)
 		ch->stopInputRec(clock::getCurrentFrame());
@@ -299,6 +437,27 @@ void stopInputRec()
 /* -------------------------------------------------------------------------- */
 
 
+void cancelInputRec()
+{
+	mixer::setSignalCallback(nullptr);
+	takeWriter::discard();
+
+	for (Channel* ch : mixer::channels) {
+		if (!isRecordingTake_(ch))
+			continue;
+		SampleChannel* sch = static_cast<SampleChannel*>(ch);
+		sch->empty();
+		sch->name = "";
+	}
+	takePlaceholder_.reset();
+
+	gu_log("[mh] input recs cancelled\n");
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
 bool hasArmedSampleChannels()
 {
 	return std::any_of(mixer::channels.begin(), mixer::channels.end(), [](const Channel* ch)
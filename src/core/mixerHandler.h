@@ -78,12 +78,19 @@ void readPatch();
 
 /* startInputRec - record from line in
 Creates a new empty wave in the first available channels. Returns false if
-there are no available channels. */
+there are no available channels. If 'onSignal' is true recording is just armed:
+mixer starts it when the input crosses the rec trigger level. */
 
-bool startInputRec();
+bool startInputRec(bool onSignal=false);
 
 void stopInputRec();
 
+/* cancelInputRec
+Disarms an input recording that never started, i.e. still waiting for a 
+signal. Empties the channels prepared by startInputRec(). */
+
+void cancelInputRec();
+
 /* uniqueSamplePath
 Returns true if path 'p' is unique. Requires SampleChannel 'skip' in order
 to skip check against itself. */
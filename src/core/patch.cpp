@@ -175,6 +175,12 @@ bool readPlugins(json_t* jContainer, vector<plugin_t>* container, const char* ke
 		json_array_foreach(jParams, paramIndex, jParam)
 			plugin.params.push_back(json_real_value(jParam));
 
+		/* read plugin state chunk, optional */
+
+		json_t* jState = json_object_get(jPlugin, PATCH_KEY_PLUGIN_STATE);
+		if (json_is_string(jState))
+			plugin.state = json_string_value(jState);
+
 		/* read midiIn params (midi learning on plugins' parameters) */
 
 		json_t* jMidiInParams = json_object_get(jPlugin, PATCH_KEY_PLUGIN_MIDI_IN_PARAMS);
@@ -362,6 +368,11 @@ void writePlugins(json_t* jContainer, vector<plugin_t>* plugins, const char* key
 			json_array_append_new(jPluginParams, json_real(plugin.params.at(z)));
 		json_object_set_new(jPlugin, PATCH_KEY_PLUGIN_PARAMS, jPluginParams);
 
+		/* plugin state chunk */
+
+		if (!plugin.state.empty())
+			json_object_set_new(jPlugin, PATCH_KEY_PLUGIN_STATE, json_string(plugin.state.c_str()));
+
 		/* midiIn params (midi learning on plugins' parameters) */
 
 		json_t* jPluginMidiInParams = json_array();
@@ -55,6 +55,13 @@ struct plugin_t
 	bool                  bypass;
 	std::vector<float>    params;
 	std::vector<uint32_t> midiInParams;
+
+	/* state
+	State chunk from the plug-in, in standard base64 (RFC 4648). When present 
+	it supersedes 'params', still written for older versions; old patches have 
+	params only. */
+
+	std::string           state;
 };
 #endif
 
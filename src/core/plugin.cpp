@@ -29,6 +29,8 @@
 
 
 #include <cassert>
+#include <cmath>
+#include <algorithm>
 #include <FL/Fl.H>
 #include "../utils/log.h"
 #include "../utils/time.h"
@@ -42,7 +44,7 @@ using std::string;
 namespace giada {
 namespace m 
 {
-int Plugin::m_idGenerator = 1;
+std::atomic<int> Plugin::m_idGenerator(1);
 
 
 /* -------------------------------------------------------------------------- */
@@ -52,7 +54,10 @@ Plugin::Plugin(juce::AudioPluginInstance* plugin, double samplerate, int buffers
 : m_ui    (nullptr),
   m_plugin(plugin),
   m_id    (m_idGenerator++),
-  m_bypass(false)
+  m_bypass(false),
+  m_tailFrames  (0),
+  m_silentFrames(0),
+  m_idle        (false)
 {
 	using namespace juce;
 	
@@ -62,6 +67,13 @@ Plugin::Plugin(juce::AudioPluginInstance* plugin, double samplerate, int buffers
 	const OwnedArray<AudioProcessorParameter>& params = m_plugin->getParameters();
 	for (int i=0; i<params.size(); i++)
 		midiInParams.push_back(0x0);
+
+	m_queuedValues.reset(new std::atomic<float>[params.size()]);
+	m_queuedFlags.reset(new std::atomic<bool>[params.size()]);
+	for (int i=0; i<params.size(); i++) {
+		m_queuedValues[i].store(0.0f);
+		m_queuedFlags[i].store(false);
+	}
 	
 	m_buffer.setSize(G_MAX_IO_CHANS, buffersize);
 
@@ -75,6 +87,15 @@ Plugin::Plugin(juce::AudioPluginInstance* plugin, double samplerate, int buffers
 
 	m_plugin->prepareToPlay(samplerate, buffersize);
 
+	/* The tail length is known only once the sample rate is set. Instruments
+	and effects with an unknown (zero) or endless tail are never skipped. */
+
+	double tail = m_plugin->getTailLengthSeconds();
+	if (m_plugin->acceptsMidi() || !std::isfinite(tail) || tail <= 0.0 || tail >= G_MAX_PLUGIN_TAIL)
+		m_tailFrames = -1;
+	else
+		m_tailFrames = std::max(tail, G_PLUGIN_IDLE_HOLD / 1000.0) * samplerate;
+
 	gu_log("[Plugin] plugin initialized and ready. MIDI input params: %lu\n", 
 		midiInParams.size());
 }
@@ -175,6 +196,67 @@ void Plugin::setParameter(int paramIndex, float value) const
 /* -------------------------------------------------------------------------- */
 
 
+void Plugin::queueParameter(int paramIndex, float value)
+{
+	m_queuedValues[paramIndex].store(value);
+	if (m_queuedFlags[paramIndex].exchange(true))
+		return; // Already queued: the new value will be picked up
+	if (!m_queuedParams.push(paramIndex)) {
+		m_queuedFlags[paramIndex].store(false);
+		setParameter(paramIndex, value); // Queue full: apply right away
+	}
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void Plugin::applyQueuedParameters()
+{
+	/* Clear the flag before reading the value: a change coming in between is 
+	queued again, not lost. */
+
+	int paramIndex;
+	while (m_queuedParams.pop(paramIndex)) {
+		m_queuedFlags[paramIndex].store(false);
+		setParameter(paramIndex, m_queuedValues[paramIndex].load());
+	}
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+string Plugin::getState() const
+{
+	juce::MemoryBlock data;
+	m_plugin->getStateInformation(data);
+	if (data.getSize() == 0)
+		return "";
+	return juce::Base64::toBase64(data.getData(), data.getSize()).toStdString();
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+bool Plugin::setState(const string& state) const
+{
+	juce::MemoryBlock data;
+	juce::MemoryOutputStream stream(data, /*appendToExistingBlockContent=*/false);
+	if (!juce::Base64::convertFromBase64(stream, juce::String(state))) {
+		gu_log("[Plugin::setState] malformed state chunk, plugin id=%d\n", m_id);
+		return false;
+	}
+	stream.flush();
+	m_plugin->setStateInformation(data.getData(), static_cast<int>(data.getSize()));
+	return true;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
 string Plugin::getName() const
 {
 	return m_plugin->getName().toStdString();
@@ -203,6 +285,7 @@ bool Plugin::acceptsMidi() const
 
 
 bool Plugin::isBypassed() const { return m_bypass; }
+bool Plugin::isIdle() const { return m_idle.load(); }
 void Plugin::toggleBypass() { m_bypass = !m_bypass; }
 void Plugin::setBypass(bool b) { m_bypass = b; }
 
@@ -210,6 +293,17 @@ void Plugin::setBypass(bool b) { m_bypass = b; }
 /* -------------------------------------------------------------------------- */
 
 
+void Plugin::setBufferSize(int buffersize)
+{
+	m_buffer.setSize(G_MAX_IO_CHANS, buffersize);
+	m_plugin->releaseResources();
+	m_plugin->prepareToPlay(m_plugin->getSampleRate(), buffersize);
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
 int Plugin::getId() const { return m_id; }
 
 
@@ -223,34 +317,56 @@ int Plugin::getEditorH() const { assert(m_ui != nullptr); return m_ui->getHeight
 /* -------------------------------------------------------------------------- */
 
 
-void Plugin::process(juce::AudioBuffer<float>& out, juce::MidiBuffer m)
+void Plugin::process(juce::AudioBuffer<float>& out, juce::MidiBuffer& m)
 {
-	/* If this is not an instrument (i.e. doesn't accept MIDI), copy the 
-	incoming buffer data into the temporary one. This way FXes will process
-	existing audio data. Conversely, if the plug-in is an instrument, it 
-	generates its own audio data inside a clean m_buffer and we can play more 
-	than one plug-in instrument in the same stack, driven by the same set of 
-	MIDI events. */
+	/* If this is not an instrument (i.e. doesn't accept MIDI), process the 
+	incoming buffer in place. This way FXes will process existing audio data. 
+	Conversely, if the plug-in is an instrument, it generates its own audio data
+	inside a clean m_buffer and we can play more than one plug-in instrument in 
+	the same stack, driven by the same set of MIDI events. */
 
 	const bool isInstrument = m_plugin->acceptsMidi();
+	const int  numSamples   = out.getNumSamples();
 
-	if (!isInstrument)
-		m_buffer = out;
-	else
+	/* Skip the effect altogether if it's been silent for a while and nothing 
+	new comes in, MIDI included. Instruments are never skipped (m_tailFrames
+	is -1 for them, see the constructor): they may play on their own. */
+
+	const bool hasInput = !m.isEmpty() || 
+		(!isInstrument && out.getMagnitude(0, numSamples) > G_PLUGIN_IDLE_THRESHOLD);
+
+	if (!isInstrument && !hasInput && m_tailFrames != -1 && m_silentFrames > m_tailFrames) {
+		m_idle.store(true);
+		return;
+	}
+	m_idle.store(false);
+
+	if (isInstrument) {
 		m_buffer.clear();
+		m_plugin->processBlock(m_buffer, m);
+	}
+	else
+		m_plugin->processBlock(out, m);
+
+	const juce::AudioBuffer<float>& result = isInstrument ? m_buffer : out;
+	if (hasInput || result.getMagnitude(0, numSamples) > G_PLUGIN_IDLE_THRESHOLD)
+		m_silentFrames = 0;
+	else
+		m_silentFrames += numSamples;
 
-	m_plugin->processBlock(m_buffer, m);
+	/* The buffer is now filled. Let's try to fill the 'out' one as well by 
+	taking into account the bus layout - many plug-ins might have mono output
+	and we have a stereo buffer to fill: the last output channel is spread over
+	the remaining ones. */
 
-	/* The local buffer is now filled. Let's try to fill the 'out' one as well
-	by taking into account the bus layout - many plug-ins might have mono output
-	and we have a stereo buffer to fill. */
+	const int outChannels = countMainOutChannels();
 
 	for (int i=0, j=0; i<out.getNumChannels(); i++) {
 		if (isInstrument)
-			out.addFrom(i, 0, m_buffer, j, 0, m_buffer.getNumSamples());
-		else
-			out.copyFrom(i, 0, m_buffer, j, 0, m_buffer.getNumSamples());
-		if (i < countMainOutChannels() - 1)
+			out.addFrom(i, 0, m_buffer, j, 0, numSamples);
+		else if (i != j)
+			out.copyFrom(i, 0, out, j, 0, numSamples);
+		if (i < outChannels - 1)
 			j++;
 	}
 }
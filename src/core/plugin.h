@@ -31,8 +31,11 @@
 #define G_PLUGIN_H
 
 
+#include <atomic>
 #include "../deps/juce-config.h"
+#include "types.h"
 #include "const.h"
+#include "queue.h"
 
 
 namespace giada {
@@ -68,16 +71,44 @@ public:
 	int getEditorH() const;
 	void setParameter(int index, float value) const;
 	void setCurrentProgram(int index) const;
+
+	/* queueParameter
+	Sets parameter 'index' right before the next block, from the audio thread.
+	Changes coming in faster than that are merged: only the latest value per
+	block is applied. Any thread. */
+
+	void queueParameter(int index, float value);
+
+	/* applyQueuedParameters
+	Applies what queueParameter() left. Audio thread only. */
+
+	void applyQueuedParameters();
+
+	/* getState, setState
+	Save and restore the whole plug-in state as a chunk, encoded in standard 
+	base64 (RFC 4648). 
+	getState() returns an empty string if the plug-in has nothing to save; 
+	setState() returns false on malformed chunks. */
+
+	std::string getState() const;
+	bool setState(const std::string& state) const;
 	bool acceptsMidi() const;
 
 	/* process
 	Process the plug-in with audio and MIDI data. The audio buffer is a reference:
-	it has to be altered by the plug-in itself. Conversely, the MIDI buffer must
-	be passed by copy: each plug-in must receive its own copy of the event set, so
-	that any attempt to change/clear the MIDI buffer will only modify the local 
-	copy. */
+	it has to be altered by the plug-in itself. The MIDI buffer is altered as 
+	well, if the plug-in wants to: each plug-in must receive its own copy of the
+	event set, that's up to the caller. */
+
+	void process(juce::AudioBuffer<float>& b, juce::MidiBuffer& m);
+
+	/* isIdle
+	True if the last call to process() skipped the plug-in: an effect with a 
+	known tail whose input and output have been silent for longer than that. The
+	plug-in wakes up as soon as audio or MIDI events come in. Instruments are 
+	never idle. */
 
-	void process(juce::AudioBuffer<float>& b, juce::MidiBuffer m);
+	bool isIdle() const;
 
 	void showEditor(void* parent);
 
@@ -89,6 +120,12 @@ public:
 	void toggleBypass();
 	void setBypass(bool b);
 
+	/* setBufferSize
+	Prepares the plug-in for blocks of a different size. It must not be 
+	processing in the meantime. */
+
+	void setBufferSize(int buffersize);
+
 	/* midiInParams
 	A list of midiIn hex values for parameter automation. */
 
@@ -105,7 +142,10 @@ private:
 
 	static const int MAX_LABEL_SIZE = 64;
 	
-	static int m_idGenerator;
+	/* m_idGenerator
+	Atomic: plug-ins are also built by pluginManager's loader threads. */
+
+	static std::atomic<int> m_idGenerator;
 
 	juce::AudioProcessorEditor* m_ui;     // gui
 	juce::AudioPluginInstance*  m_plugin; // core
@@ -114,6 +154,22 @@ private:
 	int m_id;
 	bool m_bypass;
 
+	/* m_tailFrames, m_silentFrames, m_idle
+	Idle detection. m_tailFrames is -1 for instruments and for effects with an
+	unknown or endless tail: never idle. */
+
+	Frame             m_tailFrames;
+	Frame             m_silentFrames;
+	std::atomic<bool> m_idle;
+
+	/* m_queuedValues, m_queuedFlags, m_queuedParams
+	Parameter changes waiting for the next block: latest value and whether it's
+	already in m_queuedParams, per parameter. */
+
+	std::unique_ptr<std::atomic<float>[]>   m_queuedValues;
+	std::unique_ptr<std::atomic<bool>[]>    m_queuedFlags;
+	Queue<int, G_MAX_PLUGIN_QUEUED_PARAMS> m_queuedParams;
+
 	juce::AudioProcessor::Bus* getMainBus(BusType b) const;
 
 	/* countMainOutChannels
@@ -28,11 +28,17 @@
 #ifdef WITH_VST
 
 
+#include <algorithm>
 #include <cassert>
+#include <iterator>
+#include <mutex>
 #include "../utils/log.h"
 #include "../utils/vector.h"
 #include "const.h"
 #include "channel.h"
+#include "kernelMidi.h"
+#include "midiDispatcher.h"
+#include "audioBuffer.h"
 #include "plugin.h"
 #include "pluginHost.h"
 
@@ -43,36 +49,208 @@ namespace pluginHost
 {
 namespace
 {
+/* MIDI_EVENT_SIZE, MIDI_BUFFER_SIZE
+Bytes taken by a channel message in a juce::MidiBuffer: a header (timestamp 
+plus size) followed by the message data. Buffers are sized to hold a full 
+block of events without reallocating on the audio thread. */
+
+constexpr int MIDI_EVENT_SIZE  = sizeof(int32_t) + sizeof(uint16_t) + 3;
+constexpr int MIDI_BUFFER_SIZE = G_MAX_PLUGIN_MIDI_EVENTS * MIDI_EVENT_SIZE;
+
 juce::MessageManager* messageManager_;
-juce::AudioBuffer<float> audioBuffer_;
 
-std::vector<std::unique_ptr<Plugin>> masterOut_;
-std::vector<std::unique_ptr<Plugin>> masterIn_;
+/* Garbage
+Stuff no longer in use by the UI thread, to be destroyed as soon as the audio 
+thread is done with it, i.e. when the block in progress at 'epoch', if any, is
+over, and so is the MIDI thread (see midiDispatcher::getEpoch()). */
+
+struct Garbage
+{
+	const std::vector<Plugin*>* snapshot;
+	std::vector<Plugin*>        plugins;
+	uint64_t                    epoch;
+	uint64_t                    midiEpoch;
+};
+
+/* epoch_
+Blocks processed so far, times two. The lowest bit is set while a block is in
+progress (see beginBlock(), endBlock()). Written by the audio thread only. */
+
+std::atomic<uint64_t> epoch_(0);
+
+/* processedCount_, skippedCount_, processed_, skipped_
+Plug-ins run and skipped because idle. The counters are for the block in 
+progress, written by the audio thread only; processed_ and skipped_ hold the 
+last complete block for the UI. */
+
+std::atomic<int> processedCount_(0);
+std::atomic<int> skippedCount_(0);
+std::atomic<int> processed_(0);
+std::atomic<int> skipped_(0);
+
+/* garbage_, garbageMutex_
+Pending garbage. Shared between the UI thread and the reclamation one: the 
+audio thread never touches it. */
+
+std::vector<Garbage> garbage_;
+std::mutex           garbageMutex_;
+
+/* masterOut_, masterIn_
+Master stacks. Defined after the garbage: their destructors need it. */
+
+Stack masterOut_;
+Stack masterIn_;
+
+Context masterOutContext_;
+Context masterInContext_;
+
+
+/* -------------------------------------------------------------------------- */
+
+/* retire_
+Schedules an old snapshot and some plug-ins for destruction. Editors are GUI
+stuff: they are closed right away, in the calling thread. */
+
+void retire_(const std::vector<Plugin*>* snapshot, std::vector<Plugin*> plugins={})
+{
+	for (Plugin* p : plugins)
+		p->closeEditor();
+
+	std::lock_guard<std::mutex> lock(garbageMutex_);
+	garbage_.push_back({ snapshot, std::move(plugins), epoch_.load(), 
+		midiDispatcher::getEpoch() });
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+/* blockDone_
+Tells whether the audio block in progress at 'then', if any, is over 'now'. 
+With no block in progress, e.g. audio stream stopped, a retired snapshot can't 
+be reached anymore: the next block will pick up the current one. */
+
+bool blockDone_(uint64_t then, uint64_t now)
+{
+	return (then & 1) == 0 || now != then;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+/* collectGarbage_
+Frees garbage the audio thread has moved past. Everything, if 'all'. */
+
+void collectGarbage_(bool all)
+{
+	std::vector<Garbage> ready;
+	{
+		std::lock_guard<std::mutex> lock(garbageMutex_);
+		uint64_t epoch = epoch_.load();
+		auto it = std::partition(garbage_.begin(), garbage_.end(), 
+			[=](const Garbage& g) 
+			{ 
+				return !all && (!blockDone_(g.epoch, epoch) || !midiDispatcher::isDone(g.midiEpoch)); 
+			});
+		std::move(it, garbage_.end(), std::back_inserter(ready));
+		garbage_.erase(it, garbage_.end());
+	}
+
+	for (Garbage& g : ready) {
+		for (Plugin* p : g.plugins) {
+			gu_log("[pluginHost::reclaim] deleting plugin id=%d\n", p->getId());
+			delete p;
+		}
+		delete g.snapshot;
+	}
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+/* publish_
+Replaces the current snapshot of 'stack' with 's'. Plug-ins in 'removed' are
+no longer part of the stack and are retired along with the old snapshot. 
+Learned parameters may have come or gone: MIDI routes must be rebuilt, before
+the removed plug-ins are handed over for deletion. */
+
+void publish_(Stack& stack, const std::vector<Plugin*>* s, std::vector<Plugin*> removed={})
+{
+	const std::vector<Plugin*>* old = stack.exchange(s);
+	midiDispatcher::invalidate();
+	retire_(old, std::move(removed));
+}
 
 
 /* -------------------------------------------------------------------------- */
 
 
-void processPlugin_(Plugin& p, Channel* ch)
+void processPlugin_(Plugin& p, Context& c)
 {
+	p.applyQueuedParameters();
+
 	if (p.isSuspended() || p.isBypassed())
 		return;
 
-	juce::MidiBuffer events;
-	if (ch != nullptr)
-		events = ch->getPluginMidiEvents();
+	/* Each plug-in gets its own copy of the MIDI events, as it might alter 
+	them. The copy goes into preallocated memory: no allocations here. */
+
+	c.scratch.clear();
+	if (!c.events.isEmpty())
+		c.scratch.addEvents(c.events, 0, -1, 0);
 
-	p.process(audioBuffer_, events);
+	p.process(c.audio, c.scratch);
+
+	if (c.offline)
+		return;
+	if (p.isIdle())
+		skippedCount_.fetch_add(1, std::memory_order_relaxed);
+	else
+		processedCount_.fetch_add(1, std::memory_order_relaxed);
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+/* collectMidi_
+Moves MIDI events posted by other threads into the events for this block. No
+more than G_MAX_PLUGIN_MIDI_EVENTS, the capacity of the buffer: late events 
+stay in the queue for the next block. */
+
+void collectMidi_(Context& c)
+{
+	Context::Event e;
+	int count = 0;
+	while (count++ < G_MAX_PLUGIN_MIDI_EVENTS && c.queue.pop(e))
+		c.events.addEvent(juce::MidiMessage(kernelMidi::getB1(e.msg), 
+			kernelMidi::getB2(e.msg), kernelMidi::getB3(e.msg)), e.frame);
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+Context& getContext_(StackType t, Channel* ch=nullptr)
+{
+	switch(t) {
+		case StackType::MASTER_OUT:
+			return masterOutContext_;
+		case StackType::MASTER_IN:
+			return masterInContext_;
+		case StackType::CHANNEL:
+			return ch->pluginContext;
+		default:
+			assert(false);
+	}
 }
 
 
 /* -------------------------------------------------------------------------- */
 
 /* getStack_
-Returns a vector of unique_ptr's given the stackType. If stackType == CHANNEL
-a pointer to Channel is also required. */
+Returns the Stack given the stackType. If stackType == CHANNEL a pointer to 
+Channel is also required. */
 
-std::vector<std::unique_ptr<Plugin>>& getStack_(StackType t, Channel* ch=nullptr)
+Stack& getStack_(StackType t, Channel* ch=nullptr)
 {
 	switch(t) {
 		case StackType::MASTER_OUT:
@@ -94,7 +272,52 @@ std::vector<std::unique_ptr<Plugin>>& getStack_(StackType t, Channel* ch=nullptr
 /* -------------------------------------------------------------------------- */
 
 
-pthread_mutex_t mutex;
+Stack::Stack()
+: m_snapshot(new std::vector<Plugin*>())
+{
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+Stack::~Stack()
+{
+	const std::vector<Plugin*>* s = m_snapshot.load();
+	retire_(s, *s);
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+const std::vector<Plugin*>& Stack::get() const
+{
+	return *m_snapshot.load();
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+const std::vector<Plugin*>* Stack::exchange(const std::vector<Plugin*>* s)
+{
+	return m_snapshot.exchange(s);
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void Context::alloc(int bufferSize)
+{
+	for (int i=0; i<G_MAX_IO_CHANS; i++) {
+		planar[i].assign(bufferSize, 0.0f);
+		channels[i] = planar[i].data();
+	}
+	events.ensureSize(MIDI_BUFFER_SIZE);
+	scratch.ensureSize(MIDI_BUFFER_SIZE);
+}
 
 
 /* -------------------------------------------------------------------------- */
@@ -102,8 +325,47 @@ pthread_mutex_t mutex;
 
 void close()
 {
+	collectGarbage_(/*all=*/true);
 	messageManager_->deleteInstance();
-	pthread_mutex_destroy(&mutex);
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void beginBlock()
+{
+	epoch_.store(epoch_.load(std::memory_order_relaxed) + 1);
+
+	processed_.store(processedCount_.exchange(0));
+	skipped_.store(skippedCount_.exchange(0));
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void endBlock()
+{
+	epoch_.store(epoch_.load(std::memory_order_relaxed) + 1);
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+Stats getStats()
+{
+	return { processed_.load(), skipped_.load() };
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void reclaim()
+{
+	collectGarbage_(/*all=*/false);
 }
 
 
@@ -113,26 +375,41 @@ void close()
 void init(int buffersize)
 {
 	messageManager_ = juce::MessageManager::getInstance();
-	audioBuffer_.setSize(G_MAX_IO_CHANS, buffersize);
+	masterOutContext_.alloc(buffersize);
+	masterInContext_.alloc(buffersize);
+}
 
-	pthread_mutex_init(&mutex, nullptr);
+
+/* -------------------------------------------------------------------------- */
+
+
+void setBufferSize(int buffersize, std::vector<Channel*>* channels)
+{
+	masterOutContext_.alloc(buffersize);
+	masterInContext_.alloc(buffersize);
+	for (Plugin* p : masterOut_.get())
+		p->setBufferSize(buffersize);
+	for (Plugin* p : masterIn_.get())
+		p->setBufferSize(buffersize);
+	for (Channel* c : *channels)
+		for (Plugin* p : c->plugins.get())
+			p->setBufferSize(buffersize);
 }
 
 
 /* -------------------------------------------------------------------------- */
 
 
-void addPlugin(std::unique_ptr<Plugin> p, StackType t, pthread_mutex_t* mixerMutex, 
-	Channel* ch)
+void addPlugin(std::unique_ptr<Plugin> p, StackType t, Channel* ch)
 {
-	std::vector<std::unique_ptr<Plugin>>& stack = getStack_(t, ch);
+	Stack& stack = getStack_(t, ch);
 
 	gu_log("[pluginHost::addPlugin] load plugin (%s), stack type=%d, stack size=%d\n",
-		p->getName().c_str(), t, stack.size());
+		p->getName().c_str(), t, stack.get().size());
 
-	pthread_mutex_lock(mixerMutex);
-	stack.push_back(std::move(p));
-	pthread_mutex_unlock(mixerMutex);
+	std::vector<Plugin*>* s = new std::vector<Plugin*>(stack.get());
+	s->push_back(p.release());
+	publish_(stack, s);
 }
 
 
@@ -141,13 +418,7 @@ void addPlugin(std::unique_ptr<Plugin> p, StackType t, pthread_mutex_t* mixerMut
 
 std::vector<Plugin*> getStack(StackType t, Channel* ch)
 {
-	std::vector<std::unique_ptr<Plugin>>& stack = getStack_(t, ch);
-
-	std::vector<Plugin*> out;
-	for (const std::unique_ptr<Plugin>& p : stack)
-		out.push_back(p.get());
-
-	return out;
+	return getStack_(t, ch).get();
 }
 
 
@@ -156,23 +427,21 @@ std::vector<Plugin*> getStack(StackType t, Channel* ch)
 
 int countPlugins(StackType t, Channel* ch)
 {
-	return getStack_(t, ch).size();
+	return getStack_(t, ch).get().size();
 }
 
 
 /* -------------------------------------------------------------------------- */
 
 
-void freeStack(StackType t, pthread_mutex_t* mixerMutex, Channel* ch)
+void freeStack(StackType t, Channel* ch)
 {
-	std::vector<std::unique_ptr<Plugin>>& stack = getStack_(t, ch);
+	Stack& stack = getStack_(t, ch);
 
-	if (stack.size() == 0)
+	if (stack.get().size() == 0)
 		return;
 
-	pthread_mutex_lock(mixerMutex);
-	stack.clear();
-	pthread_mutex_unlock(mixerMutex);
+	publish_(stack, new std::vector<Plugin*>(), stack.get());
 
 	gu_log("[pluginHost::freeStack] stack type=%d freed\n", t);
 }
@@ -183,51 +452,45 @@ void freeStack(StackType t, pthread_mutex_t* mixerMutex, Channel* ch)
 
 void processStack(AudioBuffer& outBuf, StackType t, Channel* ch)
 {
-	std::vector<std::unique_ptr<Plugin>>& stack = getStack_(t, ch);
+	const std::vector<Plugin*>& stack = getStack_(t, ch).get();
+	Context& c = getContext_(t, ch);
+
+	/* Collect new MIDI events in any case, so that the queue doesn't fill up
+	with stale events while the stack is empty. */
 
-	if (stack.size() == 0)
+	collectMidi_(c);
+
+	if (stack.size() == 0) {
+		c.events.clear();
 		return;
+	}
 
-	assert(outBuf.countFrames() == audioBuffer_.getNumSamples());
+	assert(outBuf.countFrames() <= (int) c.planar[0].size());
+	assert(outBuf.countChannels() == G_MAX_IO_CHANS);
 
 	/* MIDI channels must not process the current buffer: give them an empty one. 
 	Sample channels and Master in/out want audio data instead: let's convert the 
-	internal buffer from Giada to Juce. */
+	internal buffer from Giada to Juce. Referring to the planar memory again 
+	on each call costs nothing (no allocations) and resets any stale 'is clear'
+	flag left by the previous block. */
 
 	if (ch != nullptr && ch->type == ChannelType::MIDI) 
-		audioBuffer_.clear();
+		for (int j=0; j<G_MAX_IO_CHANS; j++)
+			std::fill_n(c.channels[j], outBuf.countFrames(), 0.0f);
 	else
-		for (int i=0; i<outBuf.countFrames(); i++)
-			for (int j=0; j<outBuf.countChannels(); j++)
-				audioBuffer_.setSample(j, i, outBuf[i][j]);
-
-	/* Hardcore processing. Part of this loop must be guarded by mutexes, i.e. 
-	the MIDI process part. You definitely don't want a situation like the 
-	following one:
-		1. this::processStack()
-		2. [a new midi event comes in from kernelMidi thread]
-		3. channel::clearMidiBuffer()
-	The midi event in between would be surely lost, deleted by the last call to
-	channel::clearMidiBuffer()! 
-	TODO - that's why we need a proper queue for MIDI events in input... */
-
-	if (ch != nullptr)
-		pthread_mutex_lock(&mutex);
-
-	for (std::unique_ptr<Plugin>& plugin : stack)
-		processPlugin_(*plugin.get(), ch);
-
-	if (ch != nullptr) {
-		ch->clearMidiBuffer();
-		pthread_mutex_unlock(&mutex);
-	}
+		outBuf.deinterleave(c.channels);
+
+	c.audio.setDataToReferTo(c.channels, G_MAX_IO_CHANS, outBuf.countFrames());
+
+	for (Plugin* plugin : stack)
+		processPlugin_(*plugin, c);
+
+	c.events.clear();
 
 	/* Converting buffer from Juce to Giada. A note for the future: if we 
 	overwrite (=) (as we do now) it's SEND, if we add (+) it's INSERT. */
 
-	for (int i=0; i<outBuf.countFrames(); i++)
-		for (int j=0; j<outBuf.countChannels(); j++)	
-			outBuf[i][j] = audioBuffer_.getSample(j, i);
+	outBuf.interleave(c.channels);
 }
 
 
@@ -236,9 +499,9 @@ void processStack(AudioBuffer& outBuf, StackType t, Channel* ch)
 
 Plugin* getPluginByIndex(int index, StackType t, Channel* ch)
 {
-	std::vector<std::unique_ptr<Plugin>>& stack = getStack_(t, ch);
+	const std::vector<Plugin*>& stack = getStack_(t, ch).get();
 	assert((size_t) index < stack.size());
-	return stack.at(index).get();
+	return stack.at(index);
 }
 
 
@@ -247,8 +510,8 @@ Plugin* getPluginByIndex(int index, StackType t, Channel* ch)
 
 int getPluginIndex(int id, StackType t, Channel* ch)
 {
-	std::vector<std::unique_ptr<Plugin>>& stack = getStack_(t, ch);
-	return u::vector::indexOf(stack, [&](const std::unique_ptr<Plugin>& p) 
+	std::vector<Plugin*> stack = getStack_(t, ch).get();
+	return u::vector::indexOf(stack, [&](const Plugin* p) 
 	{ 
 		return p->getId() == id;
 	});
@@ -258,14 +521,13 @@ int getPluginIndex(int id, StackType t, Channel* ch)
 /* -------------------------------------------------------------------------- */
 
 
-void swapPlugin(int indexA, int indexB, StackType t, pthread_mutex_t* mixerMutex, 
-	Channel* ch)
+void swapPlugin(int indexA, int indexB, StackType t, Channel* ch)
 {
-	std::vector<std::unique_ptr<Plugin>>& stack = getStack_(t, ch);
+	Stack& stack = getStack_(t, ch);
 
-	pthread_mutex_lock(mixerMutex);
-	std::swap(stack.at(indexA), stack.at(indexB));
-	pthread_mutex_unlock(mixerMutex);
+	std::vector<Plugin*>* s = new std::vector<Plugin*>(stack.get());
+	std::swap(s->at(indexA), s->at(indexB));
+	publish_(stack, s);
 
 	gu_log("[pluginHost::swapPlugin] plugin at index %d and %d swapped\n", indexA, indexB);
 }
@@ -274,19 +536,20 @@ void swapPlugin(int indexA, int indexB, StackType t, pthread_mutex_t* mixerMutex
 /* -------------------------------------------------------------------------- */
 
 
-int freePlugin(int id, StackType t, pthread_mutex_t* mixerMutex, Channel* ch)
+int freePlugin(int id, StackType t, Channel* ch)
 {
-	std::vector<std::unique_ptr<Plugin>>& stack = getStack_(t, ch);
+	Stack& stack = getStack_(t, ch);
 
-	int index = u::vector::indexOf(stack, [&](const std::unique_ptr<Plugin>& p) 
+	std::vector<Plugin*>* s = new std::vector<Plugin*>(stack.get());
+	int index = u::vector::indexOf(*s, [&](const Plugin* p) 
 	{ 
 		return p->getId() == id; 
 	});
 	assert(index != -1);
 
-	pthread_mutex_lock(mixerMutex);
-	stack.erase(stack.begin() + index);
-	pthread_mutex_unlock(mixerMutex);	
+	Plugin* removed = s->at(index);
+	s->erase(s->begin() + index);
+	publish_(stack, s, { removed });
 
 	gu_log("[pluginHost::freePlugin] plugin id=%d removed\n", id);
 	return index;
@@ -305,12 +568,12 @@ void runDispatchLoop()
 /* -------------------------------------------------------------------------- */
 
 
-void freeAllStacks(std::vector<Channel*>* channels, pthread_mutex_t* mixerMutex)
+void freeAllStacks(std::vector<Channel*>* channels)
 {
-	freeStack(StackType::MASTER_OUT, mixerMutex);
-	freeStack(StackType::MASTER_IN, mixerMutex);
+	freeStack(StackType::MASTER_OUT);
+	freeStack(StackType::MASTER_IN);
 	for (Channel* c : *channels)
-		freeStack(StackType::CHANNEL, mixerMutex, c);
+		freeStack(StackType::CHANNEL, c);
 }
 
 
@@ -319,9 +582,8 @@ void freeAllStacks(std::vector<Channel*>* channels, pthread_mutex_t* mixerMutex)
 
 void forEachPlugin(StackType t, const Channel* ch, std::function<void(const Plugin* p)> f)
 {
-	std::vector<std::unique_ptr<Plugin>>& stack = getStack_(t, const_cast<Channel*>(ch));
-	for (const std::unique_ptr<Plugin>& p : stack)
-		f(p.get());
+	for (const Plugin* p : getStack_(t, const_cast<Channel*>(ch)).get())
+		f(p);
 }
 
 }}}; // giada::m::pluginHost::
@@ -32,9 +32,13 @@
 #define G_PLUGIN_HOST_H
 
 
+#include <atomic>
+#include <cstdint>
 #include <functional>
-#include <pthread.h>
+#include <vector>
 #include "../deps/juce-config.h"
+#include "const.h"
+#include "queue.h"
 
 
 namespace giada {
@@ -48,16 +52,118 @@ namespace pluginHost
 {
 enum class StackType { MASTER_OUT, MASTER_IN, CHANNEL };
 
-extern pthread_mutex_t mutex;
+/* Context
+Everything a plug-in stack needs while being processed: planar audio memory 
+with a JUCE buffer referring to it, and the MIDI events for the current block.
+Each stack owns its context, so that stacks share nothing and can be processed
+independently. New MIDI events go through 'queue', which any thread can fill 
+without locking: the audio thread collects them on the next block. */
+
+struct Context
+{
+	struct Event
+	{
+		uint32_t msg;
+		int      frame;
+	};
+
+	void alloc(int bufferSize);
+
+	std::vector<float>       planar[G_MAX_IO_CHANS];
+	float*                   channels[G_MAX_IO_CHANS];
+	juce::AudioBuffer<float> audio;
+	juce::MidiBuffer         events;   // events for the current block
+	juce::MidiBuffer         scratch;  // per-plugin copy of 'events'
+
+	/* offline
+	True for stacks rendered outside the audio thread (see freezer): they stay
+	out of the audio thread statistics. */
+
+	bool offline = false;
+
+	Queue<Event, G_MAX_PLUGIN_MIDI_EVENTS> queue;
+};
+
+/* Stack
+A plug-in stack that can be edited while the audio thread is processing it. 
+Readers get an immutable snapshot, i.e. a plain vector of plug-ins. Edits (UI
+thread only) build a new snapshot and publish it atomically: no locks. The old
+snapshot and the removed plug-ins, if any, are destroyed later by reclaim(),
+once the audio thread is done with them. */
+
+class Stack
+{
+public:
+
+	Stack();
+	Stack(const Stack&) = delete;
+	Stack& operator=(const Stack&) = delete;
+
+	/* ~Stack
+	Hands the current snapshot and its plug-ins over to reclaim(). */
+
+	~Stack();
+
+	/* get
+	Returns the current snapshot. It stays valid until the end of the current 
+	block for the audio thread, until the next edit for the UI thread. */
+
+	const std::vector<Plugin*>& get() const;
+
+	/* exchange
+	Publishes a new snapshot, returns the previous one. */
+
+	const std::vector<Plugin*>* exchange(const std::vector<Plugin*>* s);
+
+private:
+
+	std::atomic<const std::vector<Plugin*>*> m_snapshot;
+};
 
 void init(int buffersize);
+
+/* setBufferSize
+Reallocates the master contexts and prepares every plug-in, master and channel
+ones, for blocks of 'buffersize' frames. Call it while holding mixer::mutex, 
+when the audio thread is not processing. */
+
+void setBufferSize(int buffersize, std::vector<Channel*>* channels);
+
+/* close
+Frees any pending garbage right away. Call it when the audio thread is gone. */
+
 void close();
 
+/* beginBlock, endBlock
+Audio thread only, around each block: snapshots retired while no block is in
+progress can be destroyed right away, the others once the block is over. */
+
+void beginBlock();
+void endBlock();
+
+/* Stats
+Plug-ins processed and skipped (idle, see Plugin::isIdle) during the last 
+audio block. */
+
+struct Stats
+{
+	int processed;
+	int skipped;
+};
+
+Stats getStats();
+
+/* reclaim
+Destroys removed plug-ins and old snapshots the audio thread has moved past, 
+or never saw, e.g. if the audio stream is stopped. Plug-in destructors can be
+slow: call it from a background thread. */
+
+void reclaim();
+
 /* addPlugin
 Adds a new plugin to 'stackType'. */
 
-void addPlugin(std::unique_ptr<Plugin> p, StackType t, pthread_mutex_t* mutex, 
-    Channel* ch=nullptr);
+void addPlugin(std::unique_ptr<Plugin> p, StackType t, Channel* ch=nullptr);
 
 /* countPlugins
 Returns the size of 'stackType'. */
@@ -67,10 +173,11 @@ int countPlugins(StackType t, Channel* ch=nullptr);
 /* freeStack
 Frees plugin stack of type 'stackType'. */
 
-void freeStack(StackType t, pthread_mutex_t* mutex, Channel* ch=nullptr);
+void freeStack(StackType t, Channel* ch=nullptr);
 
 /* processStack
-Applies the fx list to the buffer. */
+Applies the fx list to the buffer. Only touches the stack and its own context:
+different stacks can be processed concurrently. */
 
 void processStack(AudioBuffer& outBuf, StackType t, Channel* ch=nullptr);
 
@@ -90,13 +197,12 @@ int getPluginIndex(int id, StackType t, Channel* ch=nullptr);
 
 /* swapPlugin */
 
-void swapPlugin(int indexA, int indexB, StackType t, pthread_mutex_t* mutex, 
-    Channel* ch=nullptr);
+void swapPlugin(int indexA, int indexB, StackType t, Channel* ch=nullptr);
 
 /* freePlugin.
 Returns the internal stack index of the deleted plugin. */
 
-int freePlugin(int id, StackType t, pthread_mutex_t* mutex, Channel* ch=nullptr);
+int freePlugin(int id, StackType t, Channel* ch=nullptr);
 
 /* runDispatchLoop
 Wakes up plugins' GUI manager for N milliseconds. */
@@ -106,7 +212,7 @@ void runDispatchLoop();
 /* freeAllStacks
 Frees everything. */
 
-void freeAllStacks(std::vector<Channel*>* channels, pthread_mutex_t* mutex);
+void freeAllStacks(std::vector<Channel*>* channels);
 
 void forEachPlugin(StackType t, const Channel* ch, std::function<void(const Plugin* p)> f);
 
@@ -29,11 +29,26 @@
 
 
 #include <cassert>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <FL/Fl.H>
+#include "../utils/gui.h"
 #include "../utils/log.h"
 #include "../utils/fs.h"
 #include "../utils/string.h"
+#include "../utils/time.h"
 #include "const.h"
 #include "plugin.h"
+#include "pluginHost.h"
 #include "pluginManager.h"
 
 
@@ -48,7 +63,7 @@ namespace pluginManager
 namespace
 {
 int samplerate_;
-int buffersize_;
+std::atomic<int> buffersize_;
 
 /* pluginFormat
 Plugin format manager. */
@@ -70,50 +85,423 @@ If some plugins from any stack are missing. */
 
 bool missingPlugins_;
 
-vector<string> splitPluginDescription_(const string& descr)
+/* index_
+Known plug-ins by identifier, minus the file location hash. See makeKey_(). 
+Points into knownPluginList_: rebuild it whenever the list changes. */
+
+std::unordered_map<string, const juce::PluginDescription*> index_;
+
+/* ScanJob
+A plug-in file being scanned by a child process. The process writes what it 
+finds to 'out'. */
+
+struct ScanJob
 {
-	// input:  VST-mda-Ambience-18fae2d2-6d646141  string
-	// output: [2-------------] [1-----] [0-----]  vector.size() == 3
-	
-	vector<string> out;
-
-	string chunk = "";
-	int count = 2;
-	for (int i=descr.length()-1; i >= 0; i--) {
-		if (descr[i] == '-' && count != 0) {
-			out.push_back(chunk);
-			count--;
-			chunk = "";
-		}
-		else
-			chunk += descr[i];
-	}
-	out.push_back(chunk);
+	std::unique_ptr<juce::ChildProcess> process;
+	juce::String file;
+	juce::File   out;
+	juce::uint32 start;
+};
 
-	return out;
-}
+constexpr int SCAN_POLL_RATE_ = 10;  // ms
+
+/* LoadJob
+A plug-in requested by makePluginAsync(). The instance is created on the main
+thread (CREATE), then set up on a loader thread (PREPARE, PREPARING) and 
+finally added to its stack on the main thread again (READY). */
+
+struct LoadJob
+{
+	enum class Stage { CREATE, PREPARE, PREPARING, READY, FAILED };
+
+	Stage                   stage;
+	bool                    cancelled;
+	juce::PluginDescription desc;
+	std::string             fid;
+	pluginHost::StackType   stackType;
+	Channel*                ch;
+	int                     samplerate;
+	int                     buffersize;
+	std::function<void(Plugin&)>                setup;
+	std::unique_ptr<juce::AudioPluginInstance> instance;
+	std::unique_ptr<Plugin>                    plugin;
+};
 
+/* loadJobs_, loadQueue_
+All pending jobs in request order, and the ones waiting for a loader thread. 
+Only the main thread adds or removes jobs; stages are changed with loadMutex_ 
+held. */
 
-/* findPluginDescription
-Browses the list of known plug-ins until plug-in with id == 'id' is found.
+std::list<LoadJob>       loadJobs_;
+std::deque<LoadJob*>     loadQueue_;
+std::mutex               loadMutex_;
+std::condition_variable  loadCond_;
+std::vector<std::thread> loadThreads_;
+bool                     loadRunning_ = false;
+
+
+/* makeKey_
 Unfortunately knownPluginList_.getTypeForIdentifierString(id) doesn't work for
 VSTs: their ID is based on the plug-in file location. E.g.:
 
 	/home/vst/mdaAmbience.so      -> VST-mdaAmbience-18fae2d2-6d646141
 	/home/vst-test/mdaAmbience.so -> VST-mdaAmbience-b328b2f6-6d646141
 
-The following function simply drops the first hash code during comparison. */
+The index key drops the location hash: VST-mdaAmbience-6d646141. */
+
+string makeKey_(const string& id)
+{
+	size_t uid = id.rfind('-');
+	if (uid == string::npos || uid == 0)
+		return id;
+	size_t hash = id.rfind('-', uid - 1);
+	if (hash == string::npos)
+		return id;
+	return id.substr(0, hash) + id.substr(uid);
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void rebuildIndex_()
+{
+	/* The first plug-in wins in case of duplicates, as the old linear search 
+	did. */
+
+	index_.clear();
+	for (const juce::PluginDescription* pd : knownPluginList_)
+		index_.emplace(makeKey_(pd->createIdentifierString().toStdString()), pd);
+}
+
+
+/* -------------------------------------------------------------------------- */
+
 
 const juce::PluginDescription* findPluginDescription_(const string& id)
 {
-	vector<string> idParts = splitPluginDescription_(id);
+	auto it = index_.find(makeKey_(id));
+	return it != index_.end() ? it->second : nullptr;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+/* makeBlacklistKey_
+Files that crashed, hung or contain no plug-ins at all are blacklisted along 
+with their modification time: they are scanned again only if they change. */
+
+juce::String makeBlacklistKey_(const juce::String& file)
+{
+	return file + "|" + juce::String(juce::File(file).getLastModificationTime().toMilliseconds());
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+/* dropStale_
+Forgets plug-ins and blacklisted files no longer in 'files' or changed on disk
+since the last scan. What's left is up to date and doesn't need scanning. */
+
+void dropStale_(const juce::StringArray& files)
+{
+	std::unordered_set<string> current;
+	for (const juce::String& f : files)
+		current.insert(f.toStdString());
+
+	for (int i=knownPluginList_.getNumTypes()-1; i>=0; i--) {
+		const juce::PluginDescription* pd = knownPluginList_.getType(i);
+		if (current.count(pd->fileOrIdentifier.toStdString()) == 0 || 
+		    juce::File(pd->fileOrIdentifier).getLastModificationTime() != pd->lastFileModTime)
+			knownPluginList_.removeType(i);
+	}
+
+	juce::StringArray keys;
+	for (const juce::String& f : files)
+		keys.add(makeBlacklistKey_(f));
+
+	juce::StringArray blacklist = knownPluginList_.getBlacklistedFiles();
+	for (const juce::String& b : blacklist)
+		if (!keys.contains(b))
+			knownPluginList_.removeFromBlacklist(b);
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+bool isCached_(const juce::String& file, const std::unordered_set<string>& known)
+{
+	return known.count(file.toStdString()) > 0 || 
+	       knownPluginList_.getBlacklistedFiles().contains(makeBlacklistKey_(file));
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+ScanJob startScanJob_(const juce::File& exe, const juce::String& file)
+{
+	ScanJob job;
+	job.file  = file;
+	job.out   = juce::File::createTempFile(".xml");
+	job.start = juce::Time::getMillisecondCounter();
+	job.process = std::make_unique<juce::ChildProcess>();
+
+	juce::StringArray args;
+	args.add(exe.getFullPathName());
+	args.add(G_PLUGIN_SCAN_ARG);
+	args.add(file);
+	args.add(job.out.getFullPathName());
+
+	if (!job.process->start(args, /*streamFlags=*/0))
+		job.process.reset();
+	return job;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+/* finishScanJob_
+Adds what the child process found to the list, or blacklists the file if it 
+timed out, crashed or found nothing. */
+
+void finishScanJob_(ScanJob& job)
+{
+	const bool timedOut = job.process->isRunning();
+	if (timedOut)
+		job.process->kill();
+
+	int found = 0;
+	std::unique_ptr<juce::XmlElement> xml(timedOut ? nullptr : juce::XmlDocument::parse(job.out));
+	if (xml != nullptr) {
+		for (juce::XmlElement* e = xml->getFirstChildElement(); e != nullptr; e = e->getNextElement()) {
+			juce::PluginDescription pd;
+			if (!pd.loadFromXml(*e))
+				continue;
+			pd.lastFileModTime = juce::File(job.file).getLastModificationTime();
+			knownPluginList_.addType(pd);
+			found++;
+		}
+	}
+	job.out.deleteFile();
+
+	if (found == 0) {
+		gu_log("[pluginManager::scanDir]   '%s' %s, blacklisted\n", job.file.toRawUTF8(),
+			timedOut ? "timed out" : "failed or has no plug-ins");
+		knownPluginList_.addToBlacklist(makeBlacklistKey_(job.file));
+	}
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+/* scanInProcess_
+Fallback for when child processes can't be started: scans 'file' right here, 
+with no protection against crashes. */
+
+void scanInProcess_(const juce::String& file)
+{
+	juce::OwnedArray<juce::PluginDescription> found;
+	knownPluginList_.scanAndAddFile(file, /*dontRescanIfAlreadyInList=*/false, 
+		found, pluginFormat_);
+	if (found.size() == 0)
+		knownPluginList_.addToBlacklist(makeBlacklistKey_(file));
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void runScanJobs_(const std::vector<juce::String>& files, 
+	const std::function<void(float)>& cb)
+{
+	const juce::File exe     = juce::File::getSpecialLocation(juce::File::currentExecutableFile);
+	const size_t     maxJobs = std::max(1u, std::thread::hardware_concurrency());
+
+	std::vector<ScanJob> jobs;
+	size_t next = 0;
+	size_t done = 0;
+
+	while (done < files.size()) {
+		while (jobs.size() < maxJobs && next < files.size()) {
+			gu_log("[pluginManager::scanDir]   scanning '%s'\n", files[next].toRawUTF8());
+			ScanJob job = startScanJob_(exe, files[next++]);
+			if (job.process != nullptr)
+				jobs.push_back(std::move(job));
+			else {
+				scanInProcess_(job.file);
+				done++;
+			}
+		}
+
+		for (auto it = jobs.begin(); it != jobs.end(); ) {
+			if (it->process->isRunning() && 
+			    juce::Time::getMillisecondCounter() - it->start < G_PLUGIN_SCAN_TIMEOUT) {
+				++it;
+				continue;
+			}
+			finishScanJob_(*it);
+			it = jobs.erase(it);
+			done++;
+		}
+
+		cb(done / static_cast<float>(files.size()));
+		juce::Thread::sleep(SCAN_POLL_RATE_);
+	}
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+/* getDescription_
+Looks for plug-in 'fid'. The default mode uses the index, falling back to 
+getTypeForFile (deprecated) for old patches (< 0.14.4). Unknown plug-ins are
+remembered for the missing plug-ins report. */
+
+const juce::PluginDescription* getDescription_(const string& fid)
+{
+	const juce::PluginDescription* pd = findPluginDescription_(fid);
+	if (pd == nullptr) {
+		gu_log("[pluginManager::getDescription_] no plugin found with fid=%s! Trying with "
+			"deprecated mode...\n", fid.c_str());
+		pd = knownPluginList_.getTypeForFile(fid);
+		if (pd == nullptr) {
+			gu_log("[pluginManager::getDescription_] still nothing to do, returning unknown plugin\n");
+			missingPlugins_ = true;
+			unknownPluginList_.push_back(fid);
+		}
+	}
+	return pd;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+/* runLoader_
+Loader thread: wraps the instances created by the main thread into Plugin 
+objects and restores their state. The expensive bits (bus setup, 
+prepareToPlay, parameters) run here, several plug-ins at a time. */
+
+void runLoader_()
+{
+	while (true) {
+		LoadJob* job;
+		{
+			std::unique_lock<std::mutex> lock(loadMutex_);
+			loadCond_.wait(lock, [] { return !loadRunning_ || !loadQueue_.empty(); });
+			if (!loadRunning_)
+				return;
+			job = loadQueue_.front();
+			loadQueue_.pop_front();
+			if (job->cancelled) {
+				job->stage = LoadJob::Stage::READY;
+				continue;
+			}
+			job->stage = LoadJob::Stage::PREPARING;
+		}
+
+		job->plugin = std::make_unique<Plugin>(job->instance.release(), 
+			job->samplerate, job->buffersize);
+		if (job->setup)
+			job->setup(*job->plugin);
+
+		std::lock_guard<std::mutex> lock(loadMutex_);
+		job->stage = LoadJob::Stage::READY;
+	}
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+/* createInstances_
+JUCE creates plug-in instances on the message thread only, i.e. the main one.
+Create as many as fit in G_PLUGIN_LOAD_BUDGET, so that the UI stays 
+responsive, and pass them on to the loader threads. */
+
+void createInstances_()
+{
+	const juce::uint32 start = juce::Time::getMillisecondCounter();
+
+	for (LoadJob& job : loadJobs_) {
+		if (juce::Time::getMillisecondCounter() - start > G_PLUGIN_LOAD_BUDGET)
+			return;
+		{
+			std::lock_guard<std::mutex> lock(loadMutex_);
+			if (job.stage != LoadJob::Stage::CREATE)
+				continue;
+		}
+
+		job.instance.reset(pluginFormat_.createInstanceFromDescription(job.desc, 
+			job.samplerate, job.buffersize));
+
+		std::lock_guard<std::mutex> lock(loadMutex_);
+		if (job.instance == nullptr) {
+			gu_log("[pluginManager::createInstances_] unable to create instance with fid=%s!\n", 
+				job.fid.c_str());
+			missingPlugins_ = true;
+			job.stage = LoadJob::Stage::FAILED;
+			continue;
+		}
+		job.stage = LoadJob::Stage::PREPARE;
+		loadQueue_.push_back(&job);
+		loadCond_.notify_one();
+	}
+}
 
-	for (const juce::PluginDescription* pd : knownPluginList_) {
-		vector<string> tmpIdParts = splitPluginDescription_(pd->createIdentifierString().toStdString());
-		if (idParts[0] == tmpIdParts[0] && idParts[2] == tmpIdParts[2])
-			return pd;
+
+/* -------------------------------------------------------------------------- */
+
+/* addReadyPlugins_
+Moves ready plug-ins into their stacks, all in one go. A plug-in waits for the 
+ones requested before it for the same stack, so that the patch order is 
+preserved. Returns whether something has been added. */
+
+bool addReadyPlugins_()
+{
+	std::lock_guard<std::mutex> lock(loadMutex_);
+
+	std::set<std::pair<pluginHost::StackType, Channel*>> busy;
+	bool added = false;
+
+	for (auto it = loadJobs_.begin(); it != loadJobs_.end(); ) {
+		const auto key = std::make_pair(it->stackType, it->ch);
+		
+		if (it->stage == LoadJob::Stage::FAILED || 
+		   (it->stage == LoadJob::Stage::READY && it->cancelled)) {
+			it = loadJobs_.erase(it);
+			continue;
+		}
+		if (it->stage != LoadJob::Stage::READY || busy.count(key) > 0) {
+			if (!it->cancelled)
+				busy.insert(key);
+			++it;
+			continue;
+		}
+		gu_log("[pluginManager::addReadyPlugins_] plugin instance with fid=%s ready\n", 
+			it->fid.c_str());
+		if (it->buffersize != buffersize_.load())  // block size changed meanwhile
+			it->plugin->setBufferSize(buffersize_.load());
+		pluginHost::addPlugin(std::move(it->plugin), it->stackType, it->ch);
+		it = loadJobs_.erase(it);
+		added = true;
 	}
-	return nullptr;
+	return added;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+/* loadTick_
+Main thread timer, running as long as there are plug-ins to load. */
+
+void loadTick_(void*)
+{
+	createInstances_();
+	if (addReadyPlugins_())
+		u::gui::updateControls();
+	if (!loadJobs_.empty())
+		Fl::repeat_timeout(G_PLUGIN_LOAD_RATE, loadTick_);
 }
 }; // {anonymous}
 
@@ -130,6 +518,41 @@ void init(int samplerate, int buffersize)
 	missingPlugins_ = false;
 	unknownPluginList_.clear();
 	loadList(gu_getHomePath() + G_SLASH + "plugins.xml");
+
+	if (loadRunning_)
+		return;
+	loadRunning_ = true;
+	for (unsigned i=0; i<std::max(1u, std::thread::hardware_concurrency()); i++)
+		loadThreads_.emplace_back(runLoader_);
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void setBufferSize(int buffersize)
+{
+	buffersize_.store(buffersize);
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void close()
+{
+	{
+		std::lock_guard<std::mutex> lock(loadMutex_);
+		loadRunning_ = false;
+	}
+	loadCond_.notify_all();
+	for (std::thread& t : loadThreads_)
+		t.join();
+	loadThreads_.clear();
+
+	Fl::remove_timeout(loadTick_);
+	loadQueue_.clear();
+	loadJobs_.clear();
 }
 
 
@@ -141,23 +564,32 @@ int scanDirs(const string& dirs, const std::function<void(float)>& cb)
 	gu_log("[pluginManager::scanDir] requested directories: '%s'\n", dirs.c_str());
 	gu_log("[pluginManager::scanDir] current plugins: %d\n", knownPluginList_.getNumTypes());
 
-	knownPluginList_.clear();   // clear up previous plugins
-
-	vector<string> dirVec = u::string::split(dirs, ";");
-
-	juce::VSTPluginFormat format;
 	juce::FileSearchPath searchPath;
-	for (const string& dir : dirVec)
+	for (const string& dir : u::string::split(dirs, ";"))
 		searchPath.add(juce::File(dir));
 
-	juce::PluginDirectoryScanner scanner(knownPluginList_, format, searchPath, 
-		/*recursive=*/true, juce::File());
+	juce::StringArray files = pluginFormat_.searchPathsForPlugins(searchPath, 
+		/*recursive=*/true);
 
-	juce::String name;
-	while (scanner.scanNextFile(false, name)) {
-		gu_log("[pluginManager::scanDir]   scanning '%s'\n", name.toRawUTF8());
-		cb(scanner.getProgress());
-	}
+	/* Only new or changed files are scanned: plug-ins from the previous scans 
+	still on disk and unchanged are kept as they are. */
+
+	dropStale_(files);
+
+	std::unordered_set<string> known;
+	for (const juce::PluginDescription* pd : knownPluginList_)
+		known.insert(pd->fileOrIdentifier.toStdString());
+
+	std::vector<juce::String> queue;
+	for (const juce::String& f : files)
+		if (!isCached_(f, known))
+			queue.push_back(f);
+
+	gu_log("[pluginManager::scanDir] %d file(s) found, %d new or changed\n", 
+		files.size(), queue.size());
+
+	runScanJobs_(queue, cb);
+	rebuildIndex_();
 
 	gu_log("[pluginManager::scanDir] %d plugin(s) found\n", knownPluginList_.getNumTypes());
 	return knownPluginList_.getNumTypes();
@@ -167,6 +599,24 @@ int scanDirs(const string& dirs, const std::function<void(float)>& cb)
 /* -------------------------------------------------------------------------- */
 
 
+int scanFile(const string& path, const string& outPath)
+{
+	juce::ScopedJuceInitialiser_GUI juceInit;
+
+	juce::OwnedArray<juce::PluginDescription> found;
+	pluginFormat_.findAllTypesForFile(found, juce::String(path));
+
+	juce::XmlElement xml("PLUGINS");
+	for (const juce::PluginDescription* pd : found)
+		xml.addChildElement(pd->createXml());
+
+	return xml.writeToFile(juce::File(outPath), "") ? 0 : 1;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
 int saveList(const string& filepath)
 {
 	int out = knownPluginList_.createXml()->writeToFile(juce::File(filepath), "");
@@ -185,6 +635,7 @@ int loadList(const string& filepath)
 	if (elem != nullptr) {
 		knownPluginList_.recreateFromXml(*elem);
 		delete elem;
+		rebuildIndex_();
 		return 1;
 	}
 	return 0;
@@ -196,23 +647,11 @@ int loadList(const string& filepath)
 
 std::unique_ptr<Plugin> makePlugin(const string& fid)
 {
-	/* Initialize plugin. The default mode uses getTypeForIdentifierString, 
-	falling back to  getTypeForFile (deprecated) for old patches (< 0.14.4). */
-
-	const juce::PluginDescription* pd = findPluginDescription_(fid);
-	if (pd == nullptr) {
-		gu_log("[pluginManager::makePlugin] no plugin found with fid=%s! Trying with "
-			"deprecated mode...\n", fid.c_str());
-		pd = knownPluginList_.getTypeForFile(fid);
-		if (pd == nullptr) {
-			gu_log("[pluginManager::makePlugin] still nothing to do, returning unknown plugin\n");
-			missingPlugins_ = true;
-			unknownPluginList_.push_back(fid);
-			return {};
-		}
-	}
+	const juce::PluginDescription* pd = getDescription_(fid);
+	if (pd == nullptr)
+		return {};
 
-	juce::AudioPluginInstance* pi = pluginFormat_.createInstanceFromDescription(*pd, samplerate_, buffersize_);
+	juce::AudioPluginInstance* pi = pluginFormat_.createInstanceFromDescription(*pd, samplerate_, buffersize_.load());
 	if (!pi) {
 		gu_log("[pluginManager::makePlugin] unable to create instance with fid=%s!\n", fid.c_str());
 		missingPlugins_ = true;
@@ -220,7 +659,79 @@ std::unique_ptr<Plugin> makePlugin(const string& fid)
 	}
 	gu_log("[pluginManager::makePlugin] plugin instance with fid=%s created\n", fid.c_str());
 
-	return std::make_unique<Plugin>(pi, samplerate_, buffersize_);
+	return std::make_unique<Plugin>(pi, samplerate_, buffersize_.load());
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void makePluginAsync(const string& fid, pluginHost::StackType t, Channel* ch, 
+	std::function<void(Plugin&)> setup)
+{
+	const juce::PluginDescription* pd = getDescription_(fid);
+	if (pd == nullptr)
+		return;
+
+	LoadJob job;
+	job.stage      = LoadJob::Stage::CREATE;
+	job.cancelled  = false;
+	job.desc       = *pd;
+	job.fid        = fid;
+	job.stackType  = t;
+	job.ch         = ch;
+	job.samplerate = samplerate_;
+	job.buffersize = buffersize_.load();
+	job.setup      = setup;
+
+	{
+		std::lock_guard<std::mutex> lock(loadMutex_);
+		loadJobs_.push_back(std::move(job));
+	}
+
+	if (!Fl::has_timeout(loadTick_))
+		Fl::add_timeout(0, loadTick_);
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void finishAsync()
+{
+	if (loadJobs_.empty())
+		return;
+
+	gu_log("[pluginManager::finishAsync] waiting for %d plug-in(s)\n", loadJobs_.size());
+
+	while (true) {
+		createInstances_();
+		addReadyPlugins_();
+		if (loadJobs_.empty())
+			break;
+		u::time::sleep(G_PLUGIN_LOAD_RATE * 1000);
+	}
+	u::gui::updateControls();
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void cancelAsync(const Channel* ch)
+{
+	std::lock_guard<std::mutex> lock(loadMutex_);
+	for (auto it = loadJobs_.begin(); it != loadJobs_.end(); ) {
+		if (ch != nullptr && it->ch != ch)
+			++it;
+		else
+		if (it->stage == LoadJob::Stage::CREATE || it->stage == LoadJob::Stage::FAILED)
+			it = loadJobs_.erase(it);
+		else {
+			it->cancelled = true; // Owned by a loader thread: drop it later
+			++it;
+		}
+	}
 }
 
 
@@ -248,9 +759,13 @@ std::unique_ptr<Plugin> makePlugin(int index)
 std::unique_ptr<Plugin> makePlugin(const Plugin& src)
 {
 	std::unique_ptr<Plugin> p = makePlugin(src.getUniqueId());
-	
-	for (int i=0; i<src.getNumParameters(); i++)
-		p->setParameter(i, src.getParameter(i));	
+	if (p == nullptr)
+		return p;
+
+	const string state = src.getState();
+	if (state.empty() || !p->setState(state))
+		for (int i=0; i<src.getNumParameters(); i++)
+			p->setParameter(i, src.getParameter(i));	
 
 	return p;
 }
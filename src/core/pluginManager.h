@@ -31,7 +31,9 @@
 #define G_PLUGIN_MANAGER_H
 
 
+#include <functional>
 #include "../deps/juce-config.h"
+#include "pluginHost.h"
 #include "plugin.h"
 
 
@@ -57,13 +59,32 @@ struct PluginInfo
 
 void init(int samplerate, int buffersize);
 
+/* setBufferSize
+Block size for the plug-ins loaded from now on, when the audio device changes
+it. Any thread. */
+
+void setBufferSize(int buffersize);
+
+/* close
+Stops the loader threads and drops any plug-in still being loaded. */
+
+void close();
+
 /* scanDirs
 Parses plugin directories (semicolon-separated) and store list in 
-knownPluginList. The callback is called on each plugin found. Used to update the 
-main window from the GUI thread. */
+knownPluginList. Only files added or changed since the last scan are loaded, 
+each one in a separate process (see scanFile), several at a time. The callback
+is called periodically with the progress. Used to update the main window from 
+the GUI thread. */
 
 int scanDirs(const std::string& paths, const std::function<void(float)>& cb);
 
+/* scanFile
+Entry point for the scanner process: loads plug-in file 'path' and writes its
+descriptions to 'outPath' as XML. Returns the process exit code. */
+
+int scanFile(const std::string& path, const std::string& outPath);
+
 /* (save|load)List
 (Save|Load) knownPluginList (in|from) an XML file. */
 
@@ -84,6 +105,28 @@ std::unique_ptr<Plugin> makePlugin(const std::string& fid);
 std::unique_ptr<Plugin> makePlugin(int index);
 std::unique_ptr<Plugin> makePlugin(const Plugin& other);
 
+/* makePluginAsync
+Loads plug-in 'fid' in background and adds it to stack 't' (of channel 'ch')
+once ready, so that channels can play in the meantime. 'setup' runs on a loader
+thread right after creation: use it to restore the plug-in state. Plug-ins end 
+up in each stack in the same order they were requested. Main thread only. */
+
+void makePluginAsync(const std::string& fid, pluginHost::StackType t, Channel* ch, 
+	std::function<void(Plugin&)> setup);
+
+/* finishAsync
+Waits until all plug-ins requested by makePluginAsync() are in their stacks.
+Call it before reading whole stacks, e.g. when saving a patch or copying a
+channel: plug-ins still loading would be lost otherwise. Main thread only. */
+
+void finishAsync();
+
+/* cancelAsync
+Forgets plug-ins still being loaded for channel 'ch', or for all stacks if 'ch'
+is nullptr. Call it before deleting channels. */
+
+void cancelAsync(const Channel* ch=nullptr);
+
 /* getAvailablePluginInfo
 Returns the available plugin information (name, type, ...) given a plug-in
 index. */
@@ -0,0 +1,122 @@
+/* -----------------------------------------------------------------------------
+ *
+ * Giada - Your Hardcore Loopmachine
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2019 Giovanni A. Zuliani | Monocasual
+ *
+ * This file is part of Giada - Your Hardcore Loopmachine.
+ *
+ * Giada - Your Hardcore Loopmachine is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * Giada - Your Hardcore Loopmachine is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Giada - Your Hardcore Loopmachine. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------------- */
+#ifndef G_QUEUE_H
+#define G_QUEUE_H
+
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+
+namespace giada {
+namespace m
+{
+/* Queue
+Bounded lock-free queue, multiple producers and a single consumer. Storage is
+a fixed array, so push() and pop() never allocate nor block: safe to use 
+between the audio thread and any other thread. 'size' must be a power of two.
+Each slot carries a sequence number telling whether it's ready to be written
+or read (D. Vyukov's bounded queue). */
+
+template<typename T, std::size_t size>
+class Queue
+{
+	static_assert(size >= 2 && (size & (size - 1)) == 0, "Queue size must be a power of two");
+
+public:
+
+	Queue() : m_head(0), m_tail(0)
+	{
+		for (std::size_t i=0; i<size; i++)
+			m_slots[i].seq.store(i, std::memory_order_relaxed);
+	}
+
+	Queue(const Queue&) = delete;
+	Queue& operator=(const Queue&) = delete;
+
+	/* push
+	Returns false if the queue is full. Any thread. */
+
+	bool push(const T& value)
+	{
+		std::size_t pos = m_tail.load(std::memory_order_relaxed);
+		Slot* slot;
+		while (true) {
+			slot = &m_slots[pos & (size - 1)];
+			std::size_t seq = slot->seq.load(std::memory_order_acquire);
+			std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+			if (diff == 0) {
+				if (m_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					break;
+			}
+			else if (diff < 0)
+				return false;
+			else
+				pos = m_tail.load(std::memory_order_relaxed);
+		}
+		slot->value = value;
+		slot->seq.store(pos + 1, std::memory_order_release);
+		return true;
+	}
+
+	/* pop
+	Returns false if the queue is empty. Consumer thread only. */
+
+	bool pop(T& value)
+	{
+		std::size_t pos = m_head.load(std::memory_order_relaxed);
+		Slot& slot = m_slots[pos & (size - 1)];
+		if (slot.seq.load(std::memory_order_acquire) != pos + 1)
+			return false;
+		value = slot.value;
+		slot.seq.store(pos + size, std::memory_order_release);
+		m_head.store(pos + 1, std::memory_order_relaxed);
+		return true;
+	}
+
+private:
+
+	struct Slot
+	{
+		std::atomic<std::size_t> seq;
+		T value;
+	};
+
+	std::array<Slot, size> m_slots;
+
+	/* Padding keeps head and tail on different cache lines. No alignas here: 
+	queues live inside heap-allocated objects, and C++14 operator new doesn't 
+	honor extended alignment. */
+
+	std::atomic<std::size_t> m_head;
+	char                     m_pad[64];
+	std::atomic<std::size_t> m_tail;
+};
+}} // giada::m::
+
+
+#endif
@@ -74,6 +74,18 @@ bool startInputRec_()
 	c::transport::startSeq(/*gui=*/false);
 	return true;
 }
+
+
+/* -------------------------------------------------------------------------- */
+
+/* startInputRecOnSignal_
+Audio thread: the take has been already prepared, mixer starts recording on 
+its own. Just start the sequencer. */
+
+void startInputRecOnSignal_()
+{
+	c::transport::startSeq(/*gui=*/false);
+}
 } // {anonymous}
 
 
@@ -150,11 +162,11 @@ bool startInputRec(RecTriggerMode mode)
 	if (mode == RecTriggerMode::NORMAL)
 		isActive_ = startInputRec_();
 	if (mode == RecTriggerMode::SIGNAL) {
-		if (!mh::hasRecordableSampleChannels())
+		if (!kernelAudio::getStatus() || !mh::startInputRec(/*onSignal=*/true))
 			return false;
 		clock::setStatus(ClockStatus::WAITING);
 		clock::rewind();
-		mixer::setSignalCallback(startInputRec_);
+		mixer::setSignalCallback(startInputRecOnSignal_);
 		isActive_ = true;
 	}
 	return isActive_;
@@ -170,6 +182,7 @@ void stopInputRec()
 
 	if (clock::getStatus() == ClockStatus::WAITING)	{
 		clock::setStatus(ClockStatus::STOPPED);
+		mh::cancelInputRec();
 	}
 	else {
 		clock::setStatus(ClockStatus::RUNNING);
@@ -26,10 +26,15 @@
 
 
 #include <memory>
+#include <mutex>
 #include <algorithm>
+#include <unordered_map>
 #include <cassert>
 #include "../utils/log.h"
 #include "action.h"
+#include "actionPool.h"
+#include "conf.h"
+#include "clock.h"
 #include "channel.h"
 #include "recorder.h"
 
@@ -52,6 +57,56 @@ lock-free solution will be implemented. */
 
 ActionMap actions;
 
+/* ChannelIndex_
+Actions of a single channel sorted by tick, both all together and split by 
+event type (i.e. MidiEvent::getStatus()). Ticks don't depend on tempo, so these
+indexes stay valid across tempo and samplerate changes. Actions on the same 
+tick keep the same order they have in the ActionMap. */
+
+using SortedActions_ = std::multimap<Tick, const Action*>;
+
+struct ChannelIndex_
+{
+	SortedActions_                          all;
+	std::unordered_map<int, SortedActions_> byType;
+};
+
+/* byChannel_, byId_
+Secondary indexes, kept in sync with the ActionMap above. They are never read
+by Mixer, so they are written under the same lock just for consistency. */
+
+std::unordered_map<int, ChannelIndex_> byChannel_;
+std::unordered_map<int, const Action*> byId_;
+
+/* editMutex_
+Serializes writers, which may run on different threads (UI, MIDI, worker). 
+Writers take it first, then the mixer mutex only for the short time needed to
+publish their changes. Holding it is enough to read the map outside the mixer
+lock, as nobody else can change it in the meantime. */
+
+std::mutex editMutex_;
+
+/* Remap_
+New position of each action, computed for the clock settings in 'bpm' and 
+'samplerate' on top of the edit number 'edit' (see edits_ below). */
+
+struct Remap_
+{
+	ActionMap                               actions;
+	vector<std::pair<const Action*, Frame>> frames;
+	float                                   bpm;
+	int                                     samplerate;
+	int                                     edit;
+};
+
+/* remap_, edits_
+Remap prepared in advance by prepareFrames(), waiting for updateFrames() to
+swap it in. It's thrown away if the actions have been edited since, which is
+detected by counting the changes published through lock_(). */
+
+std::unique_ptr<Remap_> remap_;
+int                     edits_ = 0;
+
 pthread_mutex_t* mixerMutex_ = nullptr;
 bool             active_     = false;
 int              actionId_   = 0;
@@ -66,47 +121,162 @@ void lock_(std::function<void()> f)
 	pthread_mutex_lock(mixerMutex_);
 	f();
 	pthread_mutex_unlock(mixerMutex_);
+	edits_++;
 }
 
 
 /* -------------------------------------------------------------------------- */
 
-/* optimize
-Removes frames without actions. */
 
-void optimize_(ActionMap& map)
+void eraseSorted_(SortedActions_& sorted, const Action* a)
 {
-	for (auto it = map.cbegin(); it != map.cend();)
-		it->second.size() == 0 ? it = map.erase(it) : ++it;
+	auto range = sorted.equal_range(a->tick);
+	for (auto it = range.first; it != range.second; ++it)
+		if (it->second == a) {
+			sorted.erase(it);
+			return;
+		}
 }
 
 
 /* -------------------------------------------------------------------------- */
 
 
-void removeIf_(std::function<bool(const Action*)> f)
+void index_(const Action* a)
 {
-	ActionMap temp = actions;
+	ChannelIndex_& ci = byChannel_[a->channel];
+	ci.all.emplace(a->tick, a);
+	ci.byType[a->event.getStatus()].emplace(a->tick, a);
+	byId_[a->id] = a;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
 
-	/*
-	for (auto& kv : temp) {
-		vector<Action*>& as = kv.second;
-		as.erase(std::remove_if(as.begin(), as.end(), f), as.end());
-	}*/
-	for (auto& kv : temp) {
-		auto i = std::begin(kv.second);
-		while (i != std::end(kv.second)) {
-			if (f(*i)) {
-				delete *i;
-				i = kv.second.erase(i);
-			}
-			else
-				++i;
+void unindex_(const Action* a)
+{
+	auto it = byChannel_.find(a->channel);
+	if (it != byChannel_.end()) {
+		ChannelIndex_& ci = it->second;
+		eraseSorted_(ci.all, a);
+		auto t = ci.byType.find(a->event.getStatus());
+		if (t != ci.byType.end()) {
+			eraseSorted_(t->second, a);
+			if (t->second.empty())
+				ci.byType.erase(t);
 		}
+		if (ci.all.empty())
+			byChannel_.erase(it);
 	}
-	optimize_(temp);
+	auto id = byId_.find(a->id);
+	if (id != byId_.end() && id->second == a)
+		byId_.erase(id);
+}
+
 
-	lock_([&](){ actions = std::move(temp); });
+/* -------------------------------------------------------------------------- */
+
+
+void reindex_()
+{
+	byChannel_.clear();
+	byId_.clear();
+	for (auto& kv : actions)
+		for (const Action* a : kv.second)
+			index_(a);
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+/* insert_, erase_, link_
+In-place edits on the ActionMap and its indexes. Call them with the lock 
+held. */
+
+void insert_(const Action* a)
+{
+	actions[a->frame].push_back(a);
+	index_(a);
+}
+
+
+void erase_(const Action* a)
+{
+	auto it = actions.find(a->frame);
+	if (it == actions.end())
+		return;
+	vector<const Action*>& as = it->second;
+	as.erase(std::remove(as.begin(), as.end(), a), as.end());
+	if (as.empty())
+		actions.erase(it);
+	unindex_(a);
+}
+
+
+void link_(const Action* a, const Action* prev, const Action* next)
+{
+	const_cast<Action*>(a)->prev = prev != nullptr ? prev->handle : NO_ACTION;
+	const_cast<Action*>(a)->next = next != nullptr ? next->handle : NO_ACTION;
+	if (prev != nullptr) const_cast<Action*>(prev)->next = a->handle;		
+	if (next != nullptr) const_cast<Action*>(next)->prev = a->handle;	
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+/* makeRemap_
+Computes the new position of each action from its tick, according to the 
+current clock. Indexes are sorted by tick, so they don't need any remap. Ticks
+to frames is monotonic, so the new map is mostly filled in order. Requires 
+editMutex_ to be held. */
+
+std::unique_ptr<Remap_> makeRemap_()
+{
+	std::unique_ptr<Remap_> remap = std::make_unique<Remap_>();
+	remap->bpm        = clock::getBpm();
+	remap->samplerate = conf::samplerate;
+	remap->edit       = edits_;
+	remap->frames.reserve(byId_.size());
+
+	for (auto& kv : actions)
+		for (const Action* a : kv.second) {
+			Frame f = clock::tickToFrame(a->tick);
+			remap->frames.push_back({ a, f });
+			auto it = remap->actions.empty() || remap->actions.rbegin()->first < f ? 
+				remap->actions.emplace_hint(remap->actions.end(), f, vector<const Action*>()) : 
+				remap->actions.emplace(f, vector<const Action*>()).first;
+			it->second.push_back(a);
+		}
+	return remap;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+/* removeFromChannel_
+Removes the actions of channel 'channel' that satisfy 'f'. Visits only those
+actions, found through the channel index, and erases them in place. */
+
+void removeFromChannel_(int channel, std::function<bool(const Action*)> f)
+{
+	auto it = byChannel_.find(channel);
+	if (it == byChannel_.end())
+		return;
+
+	vector<const Action*> removed;
+	for (auto& kv : it->second.all)
+		if (f(kv.second))
+			removed.push_back(kv.second);
+
+	lock_([&]()
+	{ 
+		for (const Action* a : removed)
+			erase_(a);
+	});
+
+	actionPool::free(removed);
 }
 } // {anonymous}
 
@@ -137,7 +307,7 @@ void debug()
 		for (const Action* a : kv.second) {
 			total++;
 			printf(" this=%p - id=%d, frame=%d, channel=%d, value=0x%X, prev=%p, next=%p\n", 
-				(void*) a, a->id, a->frame, a->channel, a->event.getRaw(), (void*) a->prev, (void*) a->next);	
+				(void*) a, a->id, a->frame, a->channel, a->event.getRaw(), (void*) a->getPrev(), (void*) a->getNext());	
 		}
 	}
 	printf("TOTAL: %d\n", total);
@@ -150,7 +320,26 @@ void debug()
 
 void clearAll()
 {
-	removeIf_([=](const Action* a) { return true; }); // TODO optimize this
+	std::lock_guard<std::mutex> lock(editMutex_);
+	vector<const Action*> removed;
+	for (auto& kv : actions)
+		removed.insert(removed.end(), kv.second.begin(), kv.second.end());
+
+	/* Swap the containers with empty ones while Mixer is locked out, then let
+	the old ones go away outside the lock. */
+
+	ActionMap                              tempActions;
+	std::unordered_map<int, ChannelIndex_> tempByChannel;
+	std::unordered_map<int, const Action*> tempById;
+
+	lock_([&]()
+	{ 
+		actions.swap(tempActions);
+		byChannel_.swap(tempByChannel);
+		byId_.swap(tempById);
+	});
+
+	actionPool::free(removed);
 }
 
 
@@ -159,7 +348,8 @@ void clearAll()
 
 void clearChannel(int channel)
 {
-	removeIf_([=](const Action* a) { return a->channel == channel; });
+	std::lock_guard<std::mutex> lock(editMutex_);
+	removeFromChannel_(channel, [](const Action* a) { return true; });
 }
 
 
@@ -168,9 +358,10 @@ void clearChannel(int channel)
 
 void clearActions(int channel, int type)
 {
-	removeIf_([=](const Action* a)
+	std::lock_guard<std::mutex> lock(editMutex_);
+	removeFromChannel_(channel, [=](const Action* a)
 	{ 
-		return a->channel == channel && a->event.getStatus() == type;
+		return a->event.getStatus() == type;
 	});
 }
 
@@ -180,30 +371,48 @@ void clearActions(int channel, int type)
 
 void deleteAction(const Action* target)
 {
-	removeIf_([=](const Action* a) { return a == target; });
+	if (target == nullptr)
+		return;
+	std::lock_guard<std::mutex> lock(editMutex_);
+	lock_([&]() { erase_(target); });
+	actionPool::free(target);
 }
 
 
 /* -------------------------------------------------------------------------- */
 
 
-void updateKeyFrames(std::function<Frame(Frame old)> f)
+void prepareFrames()
 {
-	/* This stuff must be performed in a lock, because we are moving the vector
-	of actions from the real ActionMap to the temporary one. */
-	
-	ActionMap temp;
+	std::lock_guard<std::mutex> lock(editMutex_);
+	remap_ = makeRemap_();
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void updateFrames()
+{
+	std::lock_guard<std::mutex> lock(editMutex_);
+
+	/* Take the remap prepared by prepareFrames(), if still good for the current
+	clock and actions. Build a new one otherwise. Either way it is built outside
+	the mixer lock: Mixer keeps playing the old map in the meantime. */
+
+	std::unique_ptr<Remap_> remap = std::move(remap_);
+	if (remap == nullptr || remap->edit != edits_ || 
+	    remap->bpm != clock::getBpm() || remap->samplerate != conf::samplerate)
+		remap = makeRemap_();
+
+	/* Then only swap maps and store the new frames while Mixer is locked out: 
+	no allocations in there. The old map is destroyed outside the lock. */
 
 	lock_([&]()
-	{ 
-		for (auto& kv : actions) {
-			Frame frame = f(kv.first);
-			temp[frame] = std::move(kv.second);  // Move std::vector<Action*>
-			for (const Action* action : temp[frame])
-				const_cast<Action*>(action)->frame = frame;
-			gu_log("[recorder::updateKeyFrames] %d -> %d\n", kv.first, frame);
-		}
-		actions = std::move(temp); 
+	{
+		actions.swap(remap->actions);
+		for (const auto& p : remap->frames)
+			const_cast<Action*>(p.first)->frame = p.second;
 	});
 }
 
@@ -213,8 +422,14 @@ void updateKeyFrames(std::function<Frame(Frame old)> f)
 
 void updateEvent(const Action* a, MidiEvent e)
 {
+	std::lock_guard<std::mutex> lock(editMutex_);
 	assert(a != nullptr);
-	lock_([&] { const_cast<Action*>(a)->event = e; });
+	lock_([&] 
+	{ 
+		unindex_(a);
+		const_cast<Action*>(a)->event = e; 
+		index_(a);
+	});
 }
 
 
@@ -223,14 +438,9 @@ void updateEvent(const Action* a, MidiEvent e)
 
 void updateSiblings(const Action* a, const Action* prev, const Action* next)
 {
+	std::lock_guard<std::mutex> lock(editMutex_);
 	assert(a != nullptr);
-	lock_([&] 
-	{ 
-		const_cast<Action*>(a)->prev = prev;
-		const_cast<Action*>(a)->next = next;
-		if (prev != nullptr) const_cast<Action*>(prev)->next = a;		
-		if (next != nullptr) const_cast<Action*>(next)->prev = a;	
-	});
+	lock_([&] { link_(a, prev, next); });
 }
 
 
@@ -239,7 +449,12 @@ void updateSiblings(const Action* a, const Action* prev, const Action* next)
 
 void updateActionMap(ActionMap&& am)
 {
-	lock_([&](){ actions = am; });
+	std::lock_guard<std::mutex> lock(editMutex_);
+	lock_([&]()
+	{ 
+		actions = std::move(am); 
+		reindex_();
+	});
 }
 
 
@@ -258,11 +473,10 @@ void updateActionId(int id)
 
 bool hasActions(int channel, int type)
 {
-	for (auto& kv : actions)
-		for (const Action* action : kv.second)
-			if (action->channel == channel && (type == 0 || type == action->event.getStatus()))
-				return true;
-	return false;
+	auto it = byChannel_.find(channel);
+	if (it == byChannel_.end())
+		return false;
+	return type == 0 || it->second.byType.count(type) > 0;
 }
 
 
@@ -279,7 +493,15 @@ void disable()  { active_ = false; }
 
 const Action* makeAction(int id, int channel, Frame frame, MidiEvent e)
 {
-	return new Action{ id, channel, frame, e, -1, -1, nullptr, nullptr };
+	Action* a = actionPool::alloc();
+	if (a == nullptr)
+		return nullptr;
+	a->id      = id;
+	a->channel = channel;
+	a->tick    = clock::frameToTick(frame);
+	a->frame   = frame;
+	a->event   = e;
+	return a;
 }
 
 
@@ -291,27 +513,167 @@ const Action* rec(int channel, Frame frame, MidiEvent event)
 	/* If key frame doesn't exist yet, the [] operator in std::map is smart 
 	enough to insert a new item first. No plug-in data for now. */
 
-	lock_([&]
+	const Action* a = makeAction(actionId_++, channel, frame, event);
+	if (a == nullptr)
+		return nullptr;
+
+	std::lock_guard<std::mutex> lock(editMutex_);
+	lock_([&] { insert_(a); });
+	return a;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void rec(const std::vector<const Action*>& as)
+{
+	std::lock_guard<std::mutex> lock(editMutex_);
+	for (const Action* a : as)
+		if (a->id == -1)
+			const_cast<Action*>(a)->id = actionId_++;
+
+	/* Memory is already allocated by recorderHandler. */
+
+	lock_([&]()
 	{ 
-		actions[frame].push_back(makeAction(actionId_++, channel, frame, event));
+		for (const Action* a : as)
+			insert_(a);
 	});
-	return actions[frame].back();
 }
 
 
 /* -------------------------------------------------------------------------- */
 
 
-void rec(const std::vector<const Action*>& as)
+Transaction::~Transaction()
+{
+	actionPool::free(m_inserted);
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void Transaction::clear()
+{
+	m_inserted.clear();
+	m_deleted.clear();
+	m_moved.clear();
+	m_siblings.clear();
+	m_failed = false;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+const Action* Transaction::rec(int channel, Frame frame, MidiEvent e)
+{
+	const Action* a = makeAction(actionId_++, channel, frame, e);
+	if (a == nullptr)
+		m_failed = true;
+	else
+		m_inserted.push_back(a);
+	return a;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void Transaction::deleteAction(const Action* a)
+{
+	if (a == nullptr)
+		return;
+
+	/* Deleting something recorded in this very transaction: just forget about
+	it, Mixer has never seen it. */
+
+	auto it = std::find(m_inserted.begin(), m_inserted.end(), a);
+	if (it != m_inserted.end()) {
+		m_inserted.erase(it);
+		actionPool::free(a);
+		return;
+	}
+	m_moved.erase(std::remove_if(m_moved.begin(), m_moved.end(), 
+		[=](const Move& m) { return m.a == a; }), m_moved.end());
+	if (std::find(m_deleted.begin(), m_deleted.end(), a) == m_deleted.end())
+		m_deleted.push_back(a);
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void Transaction::moveAction(const Action* a, Frame f)
 {
-	ActionMap temp = actions;
+	assert(a != nullptr);
+	if (std::find(m_inserted.begin(), m_inserted.end(), a) != m_inserted.end()) {
+		const_cast<Action*>(a)->frame = f;
+		const_cast<Action*>(a)->tick  = clock::frameToTick(f);
+	}
+	else
+		m_moved.push_back({ a, f });
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void Transaction::updateSiblings(const Action* a, const Action* prev, const Action* next)
+{
+	if (m_failed)  // 'a' or its siblings might be missing, nothing to link
+		return;
+	assert(a != nullptr);
+	m_siblings.push_back({ a, prev, next });
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+bool Transaction::isEmpty() const
+{
+	return m_inserted.empty() && m_deleted.empty() && m_moved.empty() && 
+	       m_siblings.empty() && !m_failed;
+}
 
-	for (const Action* a : as) {
-		const_cast<Action*>(a)->id = actionId_++;
-		temp[a->frame].push_back(a); // Memory is already allocated by recorderHandler
+
+/* -------------------------------------------------------------------------- */
+
+
+bool commit(Transaction& t)
+{
+	if (t.m_failed) {
+		gu_log("[recorder::commit] action pool is full, edits discarded\n");
+		actionPool::free(t.m_inserted);
+		t.clear();
+		return false;
 	}
+	if (t.isEmpty())
+		return true;
+
+	std::lock_guard<std::mutex> lock(editMutex_);
+	lock_([&]()
+	{
+		for (const Action* a : t.m_deleted)
+			erase_(a);
+		for (const Transaction::Move& m : t.m_moved) {
+			erase_(m.a);
+			const_cast<Action*>(m.a)->frame = m.frame;
+			const_cast<Action*>(m.a)->tick  = clock::frameToTick(m.frame);
+			insert_(m.a);
+		}
+		for (const Action* a : t.m_inserted)
+			insert_(a);
+		for (const Transaction::Siblings& s : t.m_siblings)
+			link_(s.a, s.prev, s.next);
+	});
 
-	lock_([&](){ actions = std::move(temp); });
+	actionPool::free(t.m_deleted);
+	t.clear();
+	return true;
 }
 
 
@@ -329,15 +691,32 @@ vector<const Action*> getActionsOnFrame(Frame frame)
 
 const Action* getClosestAction(int channel, Frame f, int type)
 {
-	const Action* out = nullptr;
-	forEachAction([&](const Action* a)
-	{
-		if (a->event.getStatus() != type || a->channel != channel)
-			return;
-		if (out == nullptr || (a->frame <= f && a->frame > out->frame))
-			out = a;
-	});
-	return out;
+	auto ch = byChannel_.find(channel);
+	if (ch == byChannel_.end())
+		return nullptr;
+	auto t = ch->second.byType.find(type);
+	if (t == ch->second.byType.end())
+		return nullptr;
+
+	/* Latest action on or before 'f', i.e. the first one found on the greatest
+	frame <= f. Falls back to the very first action if there's nothing before 
+	'f'. Frame 'f' spans ticks [frameToTick(f), frameToTick(f+1)). */
+
+	const SortedActions_& sorted = t->second;
+	auto it = sorted.lower_bound(clock::frameToTick(f + 1));
+	if (it == sorted.begin())
+		return it->second;
+	return sorted.lower_bound(clock::frameToTick(std::prev(it)->second->frame))->second;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+const Action* getActionById(int id)
+{
+	auto it = byId_.find(id);
+	return it != byId_.end() ? it->second : nullptr;
 }
 
 
@@ -355,11 +734,12 @@ int getLatestActionId() { return actionId_; }
 vector<const Action*> getActionsOnChannel(int channel)
 {
 	vector<const Action*> out;
-	forEachAction([&](const Action* a)
-	{
-		if (a->channel == channel)
-			out.push_back(a);
-	});
+	auto it = byChannel_.find(channel);
+	if (it == byChannel_.end())
+		return out;
+	out.reserve(it->second.all.size());
+	for (auto& kv : it->second.all)
+		out.push_back(kv.second);
 	return out;
 }
 
@@ -72,11 +72,22 @@ Deletes a specific action. */
 
 void deleteAction(const Action* a);
 
-/* updateKeyFrames
-Update all the key frames in the internal map of actions, according to a lambda 
-function 'f'. */
+/* updateFrames
+Recomputes the frame of each action from its tick, according to the current 
+clock (e.g. after a tempo or samplerate change). Ticks are left untouched, so
+repeated tempo changes don't accumulate rounding errors. The new map is built
+outside the mixer lock, which is held only to swap it in. If prepareFrames()
+has already computed it for the current clock and nothing has been edited
+since, that one is used. */
 
-void updateKeyFrames(std::function<Frame(Frame old)> f);
+void updateFrames();
+
+/* prepareFrames
+Computes in advance the work of the next updateFrames() call, without 
+touching the actions Mixer plays. Meant for the worker thread, so that the UI 
+thread is left with the swap only. */
+
+void prepareFrames();
 
 /* updateActionMap
 Replaces the current map of actions with a new one. Warning: 'am' will be moved
@@ -110,19 +121,71 @@ bool isActive();
 void enable();
 void disable();
 
+/* makeAction
+Allocates a new action. Its tick is computed from 'frame' according to the 
+current clock. Returns nullptr if the action pool is full. */
+
 const Action* makeAction(int id, int channel, Frame frame, MidiEvent e);
 
 /* rec (1)
-Records an action and returns it. */
+Records an action and returns it, or nullptr if the action pool is full. */
 
 const Action* rec(int channel, Frame frame, MidiEvent e);
 
 /* rec (2)
 Transfer a vector of actions into the current ActionMap. This is called by 
-recordHandler when a live session is over and consolidation is required. */
+recordHandler when a live session is over and consolidation is required, or 
+when actions are loaded from a patch. Actions with id == -1 get a new id. */
 
 void rec(const std::vector<const Action*>& actions);
 
+/* Transaction
+A batch of edits to the ActionMap, applied all together by commit() in a single
+lock. Actions recorded through a transaction are returned right away, so that 
+they can be chained with updateSiblings() before committing. If the action pool
+runs out along the way rec() returns nullptr and the whole transaction fails on
+commit(). Actions recorded by a transaction that is never committed are freed 
+along with it. */
+
+class Transaction
+{
+public:
+
+	Transaction() = default;
+	Transaction(const Transaction&) = delete;
+	Transaction& operator=(const Transaction&) = delete;
+	~Transaction();
+
+	const Action* rec(int channel, Frame frame, MidiEvent e);
+	void deleteAction(const Action* a);
+	void moveAction(const Action* a, Frame f);
+	void updateSiblings(const Action* a, const Action* prev, const Action* next);
+
+	bool isEmpty() const;
+
+private:
+
+	friend bool commit(Transaction& t);
+
+	struct Move     { const Action* a; Frame frame; };
+	struct Siblings { const Action* a; const Action* prev; const Action* next; };
+
+	std::vector<const Action*> m_inserted;
+	std::vector<const Action*> m_deleted;
+	std::vector<Move>          m_moved;
+	std::vector<Siblings>      m_siblings;
+	bool                       m_failed = false;
+
+	void clear();
+};
+
+/* commit
+Applies all the edits queued in transaction 't', then empties it. Deleted
+actions are freed. Returns false and applies nothing if the transaction has 
+failed (see Transaction). */
+
+bool commit(Transaction& t);
+
 /* forEachAction
 Applies a read-only callback on each action recorded. NEVER do anything inside 
 the callback that might alter the ActionMap. */
@@ -144,6 +207,11 @@ Given a frame 'f' returns the closest action. */
 
 const Action* getClosestAction(int channel, Frame f, int type);
 
+/* getActionById
+Returns the action with id 'id', or nullptr if not found. */
+
+const Action* getActionById(int id);
+
 
 int getLatestActionId();
 
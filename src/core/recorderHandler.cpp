@@ -26,7 +26,7 @@
 
 
 #include <algorithm>
-#include <cmath>
+#include <unordered_map>
 #include <cassert>
 #include "../utils/log.h"
 #include "../utils/ver.h"
@@ -49,19 +49,6 @@ std::vector<const Action*> recs_;
 /* -------------------------------------------------------------------------- */
 
 
-const Action* getActionById_(int id, const recorder::ActionMap& source)
-{
-	for (auto& kv : source)
-		for (const Action* action : kv.second)
-			if (action->id == id)
-				return action;
-	return nullptr;
-}
-
-
-/* -------------------------------------------------------------------------- */
-
-
 /* areComposite_
 Composite: NOTE_ON + NOTE_OFF on the same note. */
 
@@ -93,8 +80,8 @@ void consolidate_(const Action* a1, size_t i)
 		if (!areComposite_(a1, a2))
 			continue;
 
-		const_cast<Action*>(a1)->next = a2;
-		const_cast<Action*>(a2)->prev = a1;
+		const_cast<Action*>(a1)->next = a2->handle;
+		const_cast<Action*>(a2)->prev = a1->handle;
 
 		break;
 	}		
@@ -113,62 +100,63 @@ void consolidate_()
 /* -------------------------------------------------------------------------- */
 
 
-void readPatch_DEPR_(const std::vector<patch::action_t>& pactions)
+/* getPatchFramesInBeat_
+Returns the length of a beat in frames at the time the patch was saved. Same
+math as in clock::updateFrameBars(). */
+
+double getPatchFramesInBeat_()
 {
-	for (const patch::action_t paction : pactions)
-		recs_.push_back(recorder::makeAction(-1, paction.channel, paction.frame, MidiEvent(paction.event)));
-	
-	consolidate();
+	return patch::samplerate * (60.0 / patch::bpm);
 }
-} // {anonymous}
 
 
-/* -------------------------------------------------------------------------- */
-/* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
 
-bool isBoundaryEnvelopeAction(const Action* a)
+/* makeActionFromPatch_
+Actions are stored in frames in patches: convert them to ticks according to the
+patch tempo and samplerate. Actual frames will be recomputed once the clock has
+been set up (see recorder::updateFrames()). Returns nullptr if the action pool
+is full. */
+
+const Action* makeActionFromPatch_(int id, const patch::action_t& paction)
 {
-	assert(a->prev != nullptr);
-	assert(a->next != nullptr);
-	return a->prev->frame > a->frame || a->next->frame < a->frame;
+	const Action* a = recorder::makeAction(id, paction.channel, paction.frame, 
+		MidiEvent(paction.event));
+	if (a == nullptr)
+		return nullptr;
+	const_cast<Action*>(a)->tick = clock::frameToTick(paction.frame, 
+		getPatchFramesInBeat_());
+	return a;
 }
 
 
 /* -------------------------------------------------------------------------- */
 
 
-void updateBpm(float oldval, float newval, int oldquanto)
+void readPatch_DEPR_(const std::vector<patch::action_t>& pactions)
 {
-	recorder::updateKeyFrames([=](Frame old) 
-	{
-		/* The division here cannot be precise. A new frame can be 44099 and the 
-		quantizer set to 44100. That would mean two recs completely useless. So we 
-		compute a reject value ('scarto'): if it's lower than 6 frames the new frame 
-		is collapsed with a quantized frame. FIXME - maybe 6 frames are too low. */
-		Frame frame = (old / newval) * oldval;
-		if (frame != 0) {
-			Frame delta = oldquanto % frame;
-			if (delta > 0 && delta <= 6)
-				frame = frame + delta;
-		}
-		return frame;
-	});
+	for (const patch::action_t& paction : pactions) {
+		const Action* a = makeActionFromPatch_(-1, paction);
+		if (a != nullptr)
+			recs_.push_back(a);
+	}
+	
+	consolidate();
 }
+} // {anonymous}
 
 
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
 
-void updateSamplerate(int systemRate, int patchRate)
+bool isBoundaryEnvelopeAction(const Action* a)
 {
-	if (systemRate == patchRate)
-		return;
-
-	float ratio = systemRate / (float) patchRate;
-
-	recorder::updateKeyFrames([=](Frame old) { return floorf(old * ratio); });
+	assert(a->getPrev() != nullptr);
+	assert(a->getNext() != nullptr);
+	return a->getPrev()->frame > a->frame || a->getNext()->frame < a->frame;
 }
 
 
@@ -177,26 +165,46 @@ void updateSamplerate(int systemRate, int patchRate)
 
 bool cloneActions(int chanIndex, int newChanIndex)
 {
-	recorder::ActionMap temp = recorder::getActionMap();
+	std::vector<const Action*> clones;
+	std::unordered_map<ActionHandle, ActionHandle> handles; // original -> clone
 
-	bool cloned   = false;
-	int  actionId = recorder::getLatestActionId(); 
+	int actionId = recorder::getLatestActionId(); 
 
-	recorder::forEachAction([&](const Action* a) 
-	{
-		if (a->channel == chanIndex) {
-			Action* clone = new Action(*a);
-			clone->id      = ++actionId;
-			clone->channel = newChanIndex;
-			temp[clone->frame].push_back(clone);
-			cloned = true;
+	for (const Action* a : recorder::getActionsOnChannel(chanIndex)) {
+		Action* clone = const_cast<Action*>(recorder::makeAction(actionId++, 
+			newChanIndex, a->frame, a->event));
+		if (clone == nullptr) {
+			gu_log("[recorderHandler::cloneActions] action pool is full, clone incomplete\n");
+			break;
 		}
-	});
+		clone->tick        = a->tick;
+		clone->pluginIndex = a->pluginIndex;
+		clone->pluginParam = a->pluginParam;
+		clone->prev        = a->prev;
+		clone->next        = a->next;
+		handles[a->handle] = clone->handle;
+		clones.push_back(clone);
+	}
+
+	/* Chained actions must point to their cloned siblings, not to the original
+	ones. Siblings left out of an incomplete clone are unlinked. */
+
+	auto cloned = [&](ActionHandle h)
+	{
+		auto it = handles.find(h);
+		return it != handles.end() ? it->second : NO_ACTION;
+	};
+
+	for (const Action* c : clones) {
+		Action* clone = const_cast<Action*>(c);
+		if (clone->prev != NO_ACTION) clone->prev = cloned(clone->prev);
+		if (clone->next != NO_ACTION) clone->next = cloned(clone->next);
+	}
 
 	recorder::updateActionId(actionId);
-	recorder::updateActionMap(std::move(temp));
+	recorder::rec(clones);
 
-	return cloned;
+	return clones.size() > 0;
 }
 
 
@@ -206,7 +214,9 @@ bool cloneActions(int chanIndex, int newChanIndex)
 void liveRec(int channel, MidiEvent e)
 {
 	assert(e.isNoteOnOff()); // Can't record any other kind of events for now
-	recs_.push_back(recorder::makeAction(-1, channel, clock::getCurrentFrame(), e));
+	const Action* a = recorder::makeAction(-1, channel, clock::getCurrentFrame(), e);
+	if (a != nullptr)
+		recs_.push_back(a);
 }
 
 
@@ -241,8 +251,8 @@ void writePatch(int chanIndex, std::vector<patch::action_t>& pactions)
 			a->channel, 
 			a->frame, 
 			a->event.getRaw(), 
-			a->prev != nullptr ? a->prev->id : -1,
-			a->next != nullptr ? a->next->id : -1
+			a->getPrev() != nullptr ? a->getPrev()->id : -1,
+			a->getNext() != nullptr ? a->getNext()->id : -1
 		});
 	});
 }
@@ -259,37 +269,53 @@ void readPatch(const std::vector<patch::action_t>& pactions)
 		return;
 	}
 
-	recorder::ActionMap temp = recorder::getActionMap();
+	std::vector<const Action*> actions;
+	std::unordered_map<int, Action*> byId;
+
+	actions.reserve(pactions.size());
+	byId.reserve(pactions.size());
 
 	/* First pass: add actions with no relationship (no prev/next). */
 
-	for (const patch::action_t paction : pactions) {
-		temp[paction.frame].push_back(recorder::makeAction(
-			paction.id, 
-			paction.channel, 
-			paction.frame, 
-			MidiEvent(paction.event)));
+	for (const patch::action_t& paction : pactions) {
+		const Action* a = makeActionFromPatch_(paction.id, paction);
+		if (a == nullptr) {
+			gu_log("[recorderHandler::readPatch] action pool is full, action %d skipped\n",
+				paction.id);
+			continue;
+		}
+		actions.push_back(a);
+		byId[paction.id] = const_cast<Action*>(a);
 		recorder::updateActionId(paction.id + 1);
 	}
 
-	/* Second pass: fill in previous and next actions, if any. */
+	/* Second pass: fill in previous and next actions, if any. A link to an
+	action that is not in the patch (malformed or truncated file) is dropped. */
 
-	for (const patch::action_t paction : pactions) {
-		if (paction.next == -1 && paction.prev == -1) 
+	for (const patch::action_t& paction : pactions) {
+		auto self = byId.find(paction.id);
+		if (self == byId.end() || (paction.next == -1 && paction.prev == -1))
 			continue;
-		Action* curr = const_cast<Action*>(getActionById_(paction.id, temp));
-		assert(curr != nullptr);
+		Action* curr = self->second;
 		if (paction.next != -1) {
-			curr->next = getActionById_(paction.next, temp);
-			assert(curr->next != nullptr);
+			auto it = byId.find(paction.next);
+			if (it != byId.end())
+				curr->next = it->second->handle;
+			else
+				gu_log("[recorderHandler::readPatch] action %d: next action %d not found, link dropped\n",
+					paction.id, paction.next);
 		}
 		if (paction.prev != -1) {
-			curr->prev = getActionById_(paction.prev, temp);
-			assert(curr->prev != nullptr);
+			auto it = byId.find(paction.prev);
+			if (it != byId.end())
+				curr->prev = it->second->handle;
+			else
+				gu_log("[recorderHandler::readPatch] action %d: previous action %d not found, link dropped\n",
+					paction.id, paction.prev);
 		}
 	}
 
-	recorder::updateActionMap(std::move(temp));
+	recorder::rec(actions);
 }
 }}}; // giada::m::recorderHandler::
 
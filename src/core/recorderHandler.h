@@ -44,18 +44,6 @@ namespace recorderHandler
 {
 bool isBoundaryEnvelopeAction(const Action* a);
 
-/* updateBpm
-Changes actions position by calculating the new bpm value. */
-
-void updateBpm(float oldval, float newval, int oldquanto);
-
-/* updateSamplerate
-Changes actions position by taking in account the new samplerate. If 
-f_system == f_patch nothing will change, otherwise the conversion is 
-mandatory. */
-
-void updateSamplerate(int systemRate, int patchRate);
-
 /* cloneActions
 Clones actions in channel 'chanIndex', giving them a new channel index. Returns
 whether any action has been cloned. */
@@ -0,0 +1,271 @@
+/* -----------------------------------------------------------------------------
+ *
+ * Giada - Your Hardcore Loopmachine
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2019 Giovanni A. Zuliani | Monocasual
+ *
+ * This file is part of Giada - Your Hardcore Loopmachine.
+ *
+ * Giada - Your Hardcore Loopmachine is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * Giada - Your Hardcore Loopmachine is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Giada - Your Hardcore Loopmachine. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------------- */
+
+
+#include <atomic>
+#include <cstdint>
+#include "../utils/log.h"
+#include "../utils/time.h"
+#include "const.h"
+#include "clock.h"
+#include "audioBuffer.h"
+#include "retroCapture.h"
+
+
+namespace giada {
+namespace m {
+namespace retroCapture
+{
+namespace
+{
+constexpr int SWAP_TIMEOUT = 1000;  // ms
+
+/* State
+Capture position, in absolute frames since the buffer went live. */
+
+struct State
+{
+	int64_t written     = 0;   // frames written so far
+	int64_t loopStart   = -1;  // where the sequencer was last on frame 0
+	int64_t syncedSince = 0;   // sequencer running without jumps since here
+};
+
+/* ring_, state_, expectedFrame_, lastBlock_
+Audio thread only: the live capture buffer and its state. expectedFrame_ is 
+where the sequencer should be at the next block, if the loop doesn't start 
+over in the meantime; lastBlock_ is the length of the previous block. */
+
+AudioBuffer* ring_ = nullptr;
+State        state_;
+Frame        expectedFrame_ = -1;
+Frame        lastBlock_     = 0;
+
+/* next_, retired_, retiredState_
+Buffer handoff. commit() posts the spare buffer to next_; the audio thread 
+swaps it in and posts the old live one, together with its state, to 
+retired_. */
+
+std::atomic<AudioBuffer*> next_(nullptr);
+std::atomic<AudioBuffer*> retired_(nullptr);
+State                     retiredState_;
+
+/* spare_
+UI thread only: the buffer that replaces the live one on commit. */
+
+AudioBuffer* spare_ = nullptr;
+Frame        bufferSize_ = 0;
+
+
+/* -------------------------------------------------------------------------- */
+
+
+AudioBuffer* makeBuffer_()
+{
+	AudioBuffer* b = new AudioBuffer();
+	b->alloc(bufferSize_, G_MAX_IO_CHANS);
+	return b;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+/* swap_
+Takes the buffer committed by the UI thread, if any, and retires the live 
+one. */
+
+void swap_()
+{
+	AudioBuffer* next = next_.exchange(nullptr);
+	if (next == nullptr)
+		return;
+	retiredState_  = state_;
+	state_         = State();
+	expectedFrame_ = -1;
+	retired_.store(ring_);
+	ring_ = next;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+/* waitRetired_
+Waits for the audio thread to swap buffers. Takes the spare buffer back and
+returns nullptr if the audio thread doesn't show up, e.g. stream stopped. */
+
+AudioBuffer* waitRetired_()
+{
+	AudioBuffer* b;
+	int waited = 0;
+	while ((b = retired_.exchange(nullptr)) == nullptr) {
+		if (waited++ > SWAP_TIMEOUT) {
+			AudioBuffer* n = next_.exchange(nullptr);
+			if (n != nullptr) {
+				spare_ = n;
+				return nullptr;
+			}
+		}
+		u::time::sleep(1);
+	}
+	return b;
+}
+} // {anonymous}
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+
+void init(int budget)
+{
+	close();
+	if (budget <= 0)
+		return;
+
+	/* Budget covers both the live and the spare buffer. */
+
+	bufferSize_ = (static_cast<int64_t>(budget) * 1024 * 1024 / 2) / 
+		(sizeof(float) * G_MAX_IO_CHANS);
+	ring_  = makeBuffer_();
+	spare_ = makeBuffer_();
+
+	gu_log("[retroCapture::init] capture buffers ready - %d frames each\n", bufferSize_);
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void close()
+{
+	delete ring_;
+	delete spare_;
+	delete next_.exchange(nullptr);
+	delete retired_.exchange(nullptr);
+	ring_       = nullptr;
+	spare_      = nullptr;
+	state_      = State();
+	bufferSize_ = 0;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+bool isEnabled()
+{
+	return bufferSize_ > 0;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void write(const AudioBuffer& in, float vol, Frame clockOffset)
+{
+	swap_();
+	if (ring_ == nullptr)
+		return;
+
+	/* Keep track of the sequencer position, to align commits to loop and bars.
+	Any jump (stop, rewind, tempo change) breaks the alignment. */
+
+	if (clock::isRunning()) {
+		Frame frame = clock::getCurrentFrame();
+		Frame wrap  = clock::getWrapFrame();  // Still the one of the previous block
+		Frame expected = expectedFrame_ != -1 && wrap != -1 ? lastBlock_ - wrap : expectedFrame_;
+		if (frame != expected)
+			state_.syncedSince = state_.written + clockOffset;
+		state_.loopStart = state_.written + clockOffset - frame;
+		expectedFrame_   = frame + in.countFrames() - clockOffset;
+		lastBlock_       = in.countFrames();
+	}
+	else
+		expectedFrame_ = -1;
+
+	Frame size = ring_->countFrames();
+	for (int i=0; i<in.countFrames(); i++) {
+		float* frame = (*ring_)[(state_.written + i) % size];
+		for (int j=0; j<G_MAX_IO_CHANS; j++)
+			frame[j] = in[i][j] * vol;
+	}
+	state_.written += in.countFrames();
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+std::shared_ptr<AudioBuffer> commit(Frame latency)
+{
+	if (spare_ == nullptr)
+		return nullptr;
+
+	next_.store(spare_);
+	spare_ = nullptr;
+
+	AudioBuffer* b = waitRetired_();
+	if (b == nullptr) {
+		gu_log("[retroCapture::commit] audio thread not running, nothing to commit\n");
+		return nullptr;
+	}
+
+	/* The region to commit is one loop long and ends on the latest bar. The 
+	input lags behind the sequencer by 'latency' frames, so does the region. */
+
+	const State& s     = retiredState_;
+	int64_t size       = b->countFrames();
+	int64_t loop       = clock::getFramesInLoop();
+	int64_t bar        = clock::getFramesInBar();
+	int64_t loopStart  = s.loopStart + latency;
+	int64_t end        = loopStart + ((s.written - loopStart) / bar) * bar;
+	int64_t begin      = end - loop;
+
+	if (s.loopStart == -1 || s.written < loopStart || begin < 0 || 
+	    begin < s.syncedSince + latency || begin < s.written - size) {
+		gu_log("[retroCapture::commit] not enough input captured\n");
+		spare_ = b;  // Old data, but can be reused as it is
+		return nullptr;
+	}
+
+	/* Copy the region into a buffer of its own, so that the first frame of a 
+	loop goes first. The capture buffer goes back to being the spare one: the 
+	memory budget stays the same, no matter how many commits. */
+
+	int64_t first = (((loopStart - begin) % loop) + loop) % loop;
+
+	std::shared_ptr<AudioBuffer> out = std::make_shared<AudioBuffer>();
+	out->alloc(loop, b->countChannels());
+	for (int64_t i=0; i<loop; i++)
+		out->copyFrame(i, (*b)[(begin + (first + i) % loop) % size]);
+
+	spare_ = b;
+
+	gu_log("[retroCapture::commit] %d frames committed\n", (int) loop);
+
+	return out;
+}
+}}}; // giada::m::retroCapture::
@@ -0,0 +1,74 @@
+/* -----------------------------------------------------------------------------
+ *
+ * Giada - Your Hardcore Loopmachine
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2019 Giovanni A. Zuliani | Monocasual
+ *
+ * This file is part of Giada - Your Hardcore Loopmachine.
+ *
+ * Giada - Your Hardcore Loopmachine is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * Giada - Your Hardcore Loopmachine is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Giada - Your Hardcore Loopmachine. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------------- */
+
+
+#ifndef G_RETRO_CAPTURE_H
+#define G_RETRO_CAPTURE_H
+
+
+#include <memory>
+#include "types.h"
+
+
+namespace giada {
+namespace m 
+{
+class AudioBuffer;
+
+namespace retroCapture
+{
+/* init
+Preallocates the capture buffers, 'budget' megabytes in total. Retroactive 
+capture stays disabled if 'budget' is 0. */
+
+void init(int budget);
+void close();
+
+bool isEnabled();
+
+/* write
+Audio thread side: appends the input block 'in', scaled by 'vol', to the 
+capture buffer. 'clockOffset' is the frame in the block where the sequencer
+started running, if it did in this block. Call it before clock::beginBlock():
+it reads where the loop started over in the previous block. Never allocates 
+nor blocks. */
+
+void write(const AudioBuffer& in, float vol, Frame clockOffset);
+
+/* commit
+Hands over the last captured loop, i.e. the latest clock::getFramesInLoop() 
+frames of input ending on a bar, rotated so that frame 0 falls on the first 
+beat. The input is assumed to be late by 'latency' frames (round-trip) and 
+aligned accordingly. The loop is copied into a buffer of its own, while 
+capture goes on in the spare buffer and the old one becomes the new spare. 
+Returns nullptr if not enough input has been captured while the sequencer was
+running. */
+
+std::shared_ptr<AudioBuffer> commit(Frame latency=0);
+}}}; // giada::m::retroCapture::
+
+
+#endif
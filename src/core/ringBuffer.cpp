@@ -0,0 +1,139 @@
+/* -----------------------------------------------------------------------------
+ *
+ * Giada - Your Hardcore Loopmachine
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2019 Giovanni A. Zuliani | Monocasual
+ *
+ * This file is part of Giada - Your Hardcore Loopmachine.
+ *
+ * Giada - Your Hardcore Loopmachine is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * Giada - Your Hardcore Loopmachine is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Giada - Your Hardcore Loopmachine. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------------- */
+
+
+#include <algorithm>
+#include <cstring>
+#include "ringBuffer.h"
+
+
+namespace giada {
+namespace m
+{
+RingBuffer::RingBuffer()
+: m_mask(0),
+  m_head(0),
+  m_tail(0)
+{
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void RingBuffer::alloc(int size)
+{
+	size_t s = 1;
+	while (s < static_cast<size_t>(size))
+		s <<= 1;
+	m_data.assign(s, 0.0f);
+	m_mask = s - 1;
+	clear();
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void RingBuffer::free()
+{
+	m_data.clear();
+	m_data.shrink_to_fit();
+	m_mask = 0;
+	clear();
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void RingBuffer::clear()
+{
+	m_head.store(0);
+	m_tail.store(0);
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+int RingBuffer::countSamples() const
+{
+	return m_data.size();
+}
+
+
+int RingBuffer::countReadable() const
+{
+	return m_head.load(std::memory_order_acquire) - m_tail.load(std::memory_order_acquire);
+}
+
+
+int RingBuffer::countWritable() const
+{
+	return m_data.size() - countReadable();
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+int RingBuffer::write(const float* data, int count)
+{
+	size_t head = m_head.load(std::memory_order_relaxed);
+	size_t tail = m_tail.load(std::memory_order_acquire);
+	size_t n    = std::min<size_t>(count, m_data.size() - (head - tail));
+
+	/* Copy in two steps, in case the write wraps around the end of m_data. */
+
+	size_t start = head & m_mask;
+	size_t first = std::min(n, m_data.size() - start);
+	std::memcpy(m_data.data() + start, data, first * sizeof(float));
+	std::memcpy(m_data.data(), data + first, (n - first) * sizeof(float));
+
+	m_head.store(head + n, std::memory_order_release);
+	return n;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+int RingBuffer::read(float* data, int count)
+{
+	size_t tail = m_tail.load(std::memory_order_relaxed);
+	size_t head = m_head.load(std::memory_order_acquire);
+	size_t n    = std::min<size_t>(count, head - tail);
+
+	size_t start = tail & m_mask;
+	size_t first = std::min(n, m_data.size() - start);
+	std::memcpy(data, m_data.data() + start, first * sizeof(float));
+	std::memcpy(data + first, m_data.data(), (n - first) * sizeof(float));
+
+	m_tail.store(tail + n, std::memory_order_release);
+	return n;
+}
+}} // giada::m::
@@ -0,0 +1,98 @@
+/* -----------------------------------------------------------------------------
+ *
+ * Giada - Your Hardcore Loopmachine
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2019 Giovanni A. Zuliani | Monocasual
+ *
+ * This file is part of Giada - Your Hardcore Loopmachine.
+ *
+ * Giada - Your Hardcore Loopmachine is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * Giada - Your Hardcore Loopmachine is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Giada - Your Hardcore Loopmachine. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------------- */
+
+
+#ifndef G_RING_BUFFER_H
+#define G_RING_BUFFER_H
+
+
+#include <atomic>
+#include <vector>
+#include <cstddef>
+
+
+namespace giada {
+namespace m
+{
+/* RingBuffer
+Lock-free single-producer, single-consumer queue of audio samples. Memory is
+preallocated by alloc(), so that write() and read() never allocate nor block
+and can be safely called from the audio thread. Only one thread may write and
+only one thread may read at any given time. */
+
+class RingBuffer
+{
+public:
+
+	RingBuffer();
+	RingBuffer(const RingBuffer&) = delete;
+	RingBuffer& operator=(const RingBuffer&) = delete;
+
+	/* alloc
+	Allocates room for at least 'size' samples. Size is rounded up to the next 
+	power of two. Not thread safe: call it when nobody is reading or writing. */
+
+	void alloc(int size);
+	void free();
+
+	/* clear
+	Discards all pending samples. Not thread safe, as alloc(). */
+
+	void clear();
+
+	int countSamples() const;
+	int countReadable() const;
+	int countWritable() const;
+
+	/* write
+	Pushes up to 'count' samples from 'data'. Returns the number of samples 
+	actually written, which is less than 'count' if the buffer is full. */
+
+	int write(const float* data, int count);
+
+	/* read
+	Pops up to 'count' samples into 'data'. Returns the number of samples 
+	actually read. */
+
+	int read(float* data, int count);
+
+private:
+
+	std::vector<float> m_data;
+	size_t m_mask;
+
+	/* m_head, m_tail
+	Write and read counters. They grow indefinitely: the actual position in 
+	m_data is counter & m_mask. Kept on separate cache lines, as they are 
+	written by different threads. */
+
+	alignas(64) std::atomic<size_t> m_head;
+	alignas(64) std::atomic<size_t> m_tail;
+};
+}} // giada::m::
+
+
+#endif
@@ -79,9 +79,9 @@ SampleChannel::~SampleChannel()
 /* -------------------------------------------------------------------------- */
 
 
-void SampleChannel::copy(const Channel* src_, pthread_mutex_t* pluginMutex)
+void SampleChannel::copy(const Channel* src_)
 {
-	Channel::copy(src_, pluginMutex);
+	Channel::copy(src_);
 	const SampleChannel* src = static_cast<const SampleChannel*>(src_);
 	tracker         = src->tracker;
 	begin           = src->begin;
@@ -103,6 +103,22 @@ void SampleChannel::parseEvents(mixer::FrameEvents fe)
 {
 	sampleChannelProc::parseEvents(this, fe);
 	sampleChannelRec::parseEvents(this, fe);
+
+	/* Frozen loops are heard while playing, as live ones. Frozen data of single
+	samples comes from their actions: heard as long as actions are read. */
+
+	if (isFrozen())
+		parseFrozen(fe, isAnyLoopMode() ? isPlaying() : readActions);
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void SampleChannel::setBufferSize(int bufferSize)
+{
+	Channel::setBufferSize(bufferSize);
+	bufferPreview.alloc(bufferSize, G_MAX_IO_CHANS);
 }
 
 
@@ -111,6 +127,9 @@ void SampleChannel::parseEvents(mixer::FrameEvents fe)
 
 void SampleChannel::prepareBuffer(bool running)
 {
+	/* Keep the tracker going even when frozen: the channel status depends on 
+	it. */
+
 	sampleChannelProc::prepareBuffer(this, running);
 }
 
@@ -234,6 +253,10 @@ void SampleChannel::setSolo(bool value)
 void SampleChannel::process(AudioBuffer& out, const AudioBuffer& in, 
 	bool audible, bool running)
 {
+	if (isFrozen()) {
+		processFrozen(out, audible);
+		return;
+	}
 	sampleChannelProc::process(this, out, in, audible, running);
 }
 
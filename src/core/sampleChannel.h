@@ -49,8 +49,9 @@ public:
 	SampleChannel(bool inputMonitor, int bufferSize);
 	~SampleChannel();
 
-	void copy(const Channel* src, pthread_mutex_t* pluginMutex) override;
+	void copy(const Channel* src) override;
 	void prepareBuffer(bool running) override;
+	void setBufferSize(int bufferSize) override;
 	void parseEvents(mixer::FrameEvents fe) override;
 	void process(AudioBuffer& out, const AudioBuffer& in, bool audible, bool running) override;
 	void readPatch(const std::string& basePath, const patch::channel_t& pch) override;
@@ -211,9 +211,10 @@ void processData_(SampleChannel* ch, m::AudioBuffer& out, const m::AudioBuffer&
 	for (int i=0; i<out.countFrames(); i++) {
 		if (running)
 			ch->calcVolumeEnvelope();
+		const float volume = ch->volumeSmooth.next(ch->volume);
 		if (!ch->mute)
 			for (int j=0; j<out.countChannels(); j++)
-				out[i][j] += ch->buffer[i][j] * ch->volume * ch->volume_i * ch->calcPanning(j) * ch->boost;	
+				out[i][j] += ch->buffer[i][j] * volume * ch->volume_i * ch->calcPanning(j) * ch->boost;	
 	}
 }
 
@@ -492,6 +493,12 @@ void parseEvents(SampleChannel* ch, mixer::FrameEvents fe)
 void process(SampleChannel* ch, m::AudioBuffer& out, const m::AudioBuffer& in,
 	bool audible, bool running)
 {
+	/* Volume ramps make sense only while the channel is heard: playing or 
+	monitoring the input. */
+
+	if (!audible || (!ch->isPlaying() && !(ch->armed && ch->inputMonitor)))
+		ch->volumeSmooth.reset();
+
 	if (audible)
 		processData_(ch, out, in, running);
 
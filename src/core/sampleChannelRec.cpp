@@ -93,9 +93,9 @@ Computes any changes in volume done via envelope tool. */
 void calcVolumeEnv_(SampleChannel* ch, const Action* a1)
 {
 	assert(a1 != nullptr);
-	assert(a1->next != nullptr);
+	assert(a1->getNext() != nullptr);
 
-	const Action* a2 = a1->next;
+	const Action* a2 = a1->getNext();
 
 	double vf1 = u::math::map<int, double>(a1->event.getVelocity(), 0, G_MAX_VELOCITY, 0, 1.0);
 	double vf2 = u::math::map<int, double>(a2->event.getVelocity(), 0, G_MAX_VELOCITY, 0, 1.0);
@@ -0,0 +1,91 @@
+/* -----------------------------------------------------------------------------
+ *
+ * Giada - Your Hardcore Loopmachine
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2019 Giovanni A. Zuliani | Monocasual
+ *
+ * This file is part of Giada - Your Hardcore Loopmachine.
+ *
+ * Giada - Your Hardcore Loopmachine is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * Giada - Your Hardcore Loopmachine is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Giada - Your Hardcore Loopmachine. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------------- */
+
+
+#ifndef G_SMOOTHED_VALUE_H
+#define G_SMOOTHED_VALUE_H
+
+
+#include "const.h"
+
+
+namespace giada {
+namespace m
+{
+/* SmoothedValue
+Follows a target value with a linear ramp, one step per frame, G_SMOOTHING_FRAMES
+long. A new target restarts the ramp from the current value. The very first 
+target is taken as is, so that nothing fades in on startup. Audio thread 
+only. */
+
+class SmoothedValue
+{
+public:
+
+	SmoothedValue() : m_value(0.0f), m_target(0.0f), m_step(0.0f), m_left(-1) {}
+
+	/* next
+	Moves one frame towards 'target' and returns the current value. */
+
+	float next(float target)
+	{
+		if (m_left == -1) {
+			m_value  = target;
+			m_target = target;
+			m_left   = 0;
+		}
+		else
+		if (target != m_target) {
+			m_target = target;
+			m_step   = (target - m_value) / G_SMOOTHING_FRAMES;
+			m_left   = G_SMOOTHING_FRAMES;
+		}
+		if (m_left > 0)
+			m_value = --m_left == 0 ? m_target : m_value + m_step;
+		return m_value;
+	}
+
+	/* reset
+	Takes the next target as is, as the very first one. Call it when the value 
+	is no longer followed (e.g. the channel is idle), so that no ramp starts 
+	from a stale value later on. */
+
+	void reset()
+	{
+		m_left = -1;
+	}
+
+private:
+
+	float m_value;
+	float m_target;
+	float m_step;
+	int   m_left;
+};
+}} // giada::m::
+
+
+#endif
@@ -0,0 +1,373 @@
+/* -----------------------------------------------------------------------------
+ *
+ * Giada - Your Hardcore Loopmachine
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2019 Giovanni A. Zuliani | Monocasual
+ *
+ * This file is part of Giada - Your Hardcore Loopmachine.
+ *
+ * Giada - Your Hardcore Loopmachine is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * Giada - Your Hardcore Loopmachine is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Giada - Your Hardcore Loopmachine. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------------- */
+
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <vector>
+#include <thread>
+#include <sndfile.h>
+#include "../utils/log.h"
+#include "../utils/time.h"
+#include "const.h"
+#include "audioBuffer.h"
+#include "queue.h"
+#include "ringBuffer.h"
+#include "takeWriter.h"
+
+
+namespace giada {
+namespace m {
+namespace takeWriter
+{
+namespace
+{
+constexpr int CHUNK_FRAMES    = 1024;
+constexpr int WRAP_QUEUE_SIZE = 64;
+constexpr int GAP_QUEUE_SIZE  = 64;
+
+/* Gap_
+A span of 'frames' input frames dropped at position 'at' of the stream. */
+
+struct Gap_
+{
+	int64_t at     = -1;
+	Frame   frames = 0;
+};
+
+std::thread       thread_;
+std::atomic<bool> running_(false);
+std::atomic<int>  dropped_(0);
+
+/* ring_
+Input queue from the audio thread to the writer thread. */
+
+RingBuffer ring_;
+
+/* wraps_, pushed_
+Where the sequencer loop starts over, as positions in the input stream: the 
+take is rewound right there. Loops don't last the same number of frames with
+fractional tempos, so the writer can't tell by itself. pushed_ is the stream 
+length so far, audio thread only. */
+
+Queue<int64_t, WRAP_QUEUE_SIZE> wraps_;
+int64_t pushed_ = 0;
+
+/* gaps_, gap_
+Input dropped when the writer falls behind. Consecutive drops pile up in gap_
+(audio thread only), queued as a whole before the next frames that make it 
+through. */
+
+Queue<Gap_, GAP_QUEUE_SIZE> gaps_;
+Gap_ gap_;
+
+/* scratch_
+Audio thread only: input block scaled by the input volume, before queueing. */
+
+AudioBuffer scratch_;
+
+/* take_, tracker_, latency_
+Writer thread only while recording: the in-memory take and the current 
+overdub position in it. Nobody else reads the take until stop(). latency_ is
+how late the input is with respect to the sequencer, see start(). */
+
+std::shared_ptr<AudioBuffer> take_;
+Frame tracker_ = 0;
+Frame latency_ = 0;
+
+/* consumed_, nextWrap_, nextGap_
+Writer thread only: stream position of the next frame to consume, of the next
+loop start and of the next gap, -1 if none is known yet. */
+
+int64_t consumed_ = 0;
+int64_t nextWrap_ = -1;
+Gap_    nextGap_;
+
+SNDFILE* file_ = nullptr;
+
+/* files_
+Take files written so far. Takes are saved with the project: files are only 
+needed after a crash, and are removed on close(). */
+
+std::vector<std::string> files_;
+
+
+/* -------------------------------------------------------------------------- */
+
+void writeFile_(const float* data, int frames)
+{
+	if (file_ != nullptr && frames > 0 && sf_writef_float(file_, data, frames) != frames)
+		gu_log("[takeWriter::writeFile_] warning: incomplete write!\n");
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+/* sync_
+Rewinds the overdub position if the sequencer loop starts over on the current
+stream position. The input there is still latency_ frames behind: it belongs
+to the end of the previous loop. */
+
+void sync_()
+{
+	if (nextWrap_ == -1)
+		wraps_.pop(nextWrap_);
+	if (consumed_ == nextWrap_) {
+		tracker_  = (take_->countFrames() - latency_) % take_->countFrames();
+		nextWrap_ = -1;
+	}
+	if (tracker_ >= take_->countFrames())
+		tracker_ = 0;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+/* isOnGap_, skipGap_
+Dropped input goes to the file as silence and leaves the take untouched, so 
+that what follows lands where it belongs. */
+
+bool isOnGap_()
+{
+	if (nextGap_.at == -1)
+		gaps_.pop(nextGap_);
+	return nextGap_.at != -1 && nextGap_.at == consumed_;
+}
+
+
+void skipGap_()
+{
+	const float silence[CHUNK_FRAMES * G_MAX_IO_CHANS] = {};
+	for (Frame left = nextGap_.frames; left > 0; left -= CHUNK_FRAMES)
+		writeFile_(silence, std::min(left, CHUNK_FRAMES));
+
+	for (Frame i=0; i<nextGap_.frames; i++, tracker_++, consumed_++)
+		sync_();
+
+	nextGap_ = Gap_();
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+/* consume_
+Moves everything pending in the queue into the file and the take. */
+
+void consume_()
+{
+	float chunk[CHUNK_FRAMES * G_MAX_IO_CHANS];
+
+	int samples;
+	while ((samples = ring_.read(chunk, CHUNK_FRAMES * G_MAX_IO_CHANS)) > 0) {
+		int frames = samples / G_MAX_IO_CHANS;
+		int from   = 0;  // First frame of the chunk not in the file yet
+
+		for (int i=0; i<frames; i++, tracker_++, consumed_++) {
+			if (isOnGap_()) {
+				writeFile_(chunk + (from * G_MAX_IO_CHANS), i - from);
+				from = i;
+				skipGap_();
+			}
+			sync_();
+			for (int j=0; j<G_MAX_IO_CHANS; j++)
+				(*take_)[tracker_][j] += chunk[(i * G_MAX_IO_CHANS) + j];  // adding: overdub!
+		}
+		writeFile_(chunk + (from * G_MAX_IO_CHANS), frames - from);
+	}
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void run_()
+{
+	while (running_.load()) {
+		consume_();
+		u::time::sleep(G_WORKER_RATE);
+	}
+	consume_();
+}
+} // {anonymous}
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+
+void start(Frame frames, Frame offset, Frame latency, int samplerate, 
+	Frame bufferSize, const std::string& path)
+{
+	stop();
+
+	take_ = std::make_shared<AudioBuffer>();
+	take_->alloc(frames, G_MAX_IO_CHANS);
+	tracker_ = offset;
+	latency_ = latency % frames;
+
+	int64_t w;
+	Gap_    g;
+	while (wraps_.pop(w));
+	while (gaps_.pop(g));
+	pushed_   = 0;
+	consumed_ = 0;
+	nextWrap_ = -1;
+	gap_      = Gap_();
+	nextGap_  = Gap_();
+
+	ring_.alloc(samplerate * G_TAKE_RING_SECONDS * G_MAX_IO_CHANS);
+	scratch_.alloc(bufferSize, G_MAX_IO_CHANS);
+	dropped_.store(0);
+
+	/* Header is rewritten on each write, so that the file is always readable 
+	even if Giada dies while recording. */
+
+	SF_INFO header;
+	header.samplerate = samplerate;
+	header.channels   = G_MAX_IO_CHANS;
+	header.format     = SF_FORMAT_WAV | SF_FORMAT_FLOAT;
+	file_ = sf_open(path.c_str(), SFM_WRITE, &header);
+	if (file_ == nullptr)
+		gu_log("[takeWriter::start] unable to open %s, take kept in memory only. %s\n", 
+			path.c_str(), sf_strerror(file_));
+	else {
+		sf_command(file_, SFC_SET_UPDATE_HEADER_AUTO, nullptr, SF_TRUE);
+		files_.push_back(path);
+	}
+
+	running_.store(true);
+	thread_ = std::thread(run_);
+
+	gu_log("[takeWriter::start] take started - frames=%d, offset=%d, latency=%d, path=%s\n", 
+		frames, offset, latency, path.c_str());
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void stop()
+{
+	if (!running_.load())
+		return;
+	running_.store(false);
+	thread_.join();
+
+	if (file_ != nullptr) {
+		sf_close(file_);
+		file_ = nullptr;
+	}
+
+	gu_log("[takeWriter::stop] take stopped - dropped frames=%d\n", dropped_.load());
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void discard()
+{
+	stop();
+	take_.reset();
+	if (!files_.empty()) {
+		std::remove(files_.back().c_str());
+		files_.pop_back();
+	}
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void close()
+{
+	stop();
+	take_.reset();
+	for (const std::string& f : files_)
+		std::remove(f.c_str());
+	files_.clear();
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+std::shared_ptr<AudioBuffer> getTake()
+{
+	return take_;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void push(const AudioBuffer& in, float vol, Frame a, Frame b, Frame wrap)
+{
+	if (!running_.load())
+		return;
+	if (b == -1)
+		b = in.countFrames();
+
+	/* Queued before the frames, so that the writer knows about it in time. */
+
+	if (wrap >= a && wrap <= b)
+		wraps_.push(pushed_ + wrap - a);
+
+	/* Large ranges (e.g. the rec trigger pre-roll) are queued in scratch-sized 
+	chunks. A pending gap must reach the writer before any new frame. */
+
+	while (a < b) {
+		Frame frames = std::min(b - a, scratch_.countFrames());
+		bool  fits   = frames * G_MAX_IO_CHANS <= ring_.countWritable();
+		if (!fits || (gap_.at != -1 && !gaps_.push(gap_))) {
+			if (gap_.at == -1)
+				gap_.at = pushed_;
+			gap_.frames += b - a;
+			pushed_     += b - a;
+			dropped_.fetch_add(b - a);
+			return;
+		}
+		gap_ = Gap_();
+		for (int i=0; i<frames; i++)
+			for (int j=0; j<G_MAX_IO_CHANS; j++)
+				scratch_[i][j] = in[a + i][j] * vol;
+		ring_.write(scratch_[0], frames * G_MAX_IO_CHANS);
+		pushed_ += frames;
+		a       += frames;
+	}
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+int countDropped()
+{
+	return dropped_.load();
+}
+}}}; // giada::m::takeWriter::
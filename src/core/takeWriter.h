@@ -0,0 +1,95 @@
+/* -----------------------------------------------------------------------------
+ *
+ * Giada - Your Hardcore Loopmachine
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2019 Giovanni A. Zuliani | Monocasual
+ *
+ * This file is part of Giada - Your Hardcore Loopmachine.
+ *
+ * Giada - Your Hardcore Loopmachine is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * Giada - Your Hardcore Loopmachine is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Giada - Your Hardcore Loopmachine. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------------- */
+
+
+#ifndef G_TAKE_WRITER_H
+#define G_TAKE_WRITER_H
+
+
+#include <memory>
+#include <string>
+#include "types.h"
+
+
+namespace giada {
+namespace m 
+{
+class AudioBuffer;
+
+namespace takeWriter
+{
+/* start
+Prepares a new input take 'frames' long, overdubbed in a loop from frame 
+'offset' onwards, and spawns the writer thread. 'latency' is how many frames
+the input lags behind the sequencer: each time the loop starts over the take 
+is rewound to 'frames - latency'. The writer streams the raw input to the WAV
+file 'path' while recording, so that takes survive a crash. 'bufferSize' is 
+the largest block the audio thread is going to push. */
+
+void start(Frame frames, Frame offset, Frame latency, int samplerate, 
+	Frame bufferSize, const std::string& path);
+
+/* stop
+Flushes pending input, closes the file and stops the writer thread. */
+
+void stop();
+
+/* discard
+Stops and throws away the current take, file included. */
+
+void discard();
+
+/* close
+Stops and removes all the take files written so far. Call it on shutdown: by
+then takes have been either saved with the project or thrown away. */
+
+void close();
+
+/* getTake
+Returns the in-memory take, once stopped: the writer thread owns it while 
+recording. All channels recording the same input then reference this one 
+buffer through Wave::shareData(). */
+
+std::shared_ptr<AudioBuffer> getTake();
+
+/* push
+Audio thread side: queues frames in range ['a', 'b') of the input block 'in' 
+(the whole block by default), scaled by 'vol'. 'wrap' is the frame of the 
+block where the sequencer loop started over, if any (see 
+clock::getWrapFrame()): the take starts over from there too. Never blocks nor
+allocates. Frames are dropped if the writer thread falls behind: they end up
+as silence in the take and in the file. */
+
+void push(const AudioBuffer& in, float vol, Frame a=0, Frame b=-1, Frame wrap=-1);
+
+/* countDropped
+Number of input frames dropped during the last take. */
+
+int countDropped();
+}}}; // giada::m::takeWriter::
+
+
+#endif
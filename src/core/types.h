@@ -29,10 +29,17 @@
 #define G_TYPES_H
 
 
+#include <cstdint>
+
+
 namespace giada
 {
 using Pixel = int;
 using Frame = int;
+using Tick  = int;
+using ActionHandle = uint32_t;
+
+constexpr ActionHandle NO_ACTION = UINT32_MAX;
 
 enum class ClockStatus { STOPPED, WAITING, RUNNING };
 
@@ -39,7 +39,8 @@ using namespace giada;
 
 
 Wave::Wave()
-: m_rate   (0),
+: buffer   (std::make_shared<giada::m::AudioBuffer>()),
+  m_rate   (0),
   m_bits   (0),
   m_logical(false),
   m_edited (false) 
@@ -52,7 +53,7 @@ Wave::Wave()
 
 float* Wave::operator [](int offset) const
 {
-	return buffer[offset];
+	return (*buffer)[offset];
 }
 
 
@@ -60,14 +61,15 @@ float* Wave::operator [](int offset) const
 
 
 Wave::Wave(const Wave& other)
-:	m_rate    (other.m_rate),
+:	buffer    (std::make_shared<giada::m::AudioBuffer>()),
+	m_rate    (other.m_rate),
 	m_bits    (other.m_bits),	
 	m_logical (true),   // A cloned wave does not exist on disk
 	m_edited  (false),
 	m_path    (other.m_path)
 {
-	buffer.alloc(other.getSize(), other.getChannels());
-	buffer.copyData(other.getFrame(0), other.getSize());
+	buffer->alloc(other.getSize(), other.getChannels());
+	buffer->copyData(other.getFrame(0), other.getSize());
 }
 
 
@@ -76,7 +78,8 @@ Wave::Wave(const Wave& other)
 
 void Wave::alloc(int size, int channels, int rate, int bits, const std::string& path)
 {
-	buffer.alloc(size, channels);
+	buffer = std::make_shared<giada::m::AudioBuffer>();
+	buffer->alloc(size, channels);
 	m_rate = rate;
 	m_bits = bits;
 	m_path = path;
@@ -96,12 +99,13 @@ string Wave::getBasename(bool ext) const
 
 
 int Wave::getRate() const { return m_rate; }
-int Wave::getChannels() const { return buffer.countChannels(); }
+int Wave::getChannels() const { return buffer->countChannels(); }
 std::string Wave::getPath() const { return m_path; }
-int Wave::getSize() const { return buffer.countFrames(); }
+int Wave::getSize() const { return buffer->countFrames(); }
 int Wave::getBits() const { return m_bits; }
 bool Wave::isLogical() const { return m_logical; }
 bool Wave::isEdited() const { return m_edited; }
+bool Wave::isShared() const { return buffer.use_count() > 1; }
 
 
 /* -------------------------------------------------------------------------- */
@@ -109,7 +113,7 @@ bool Wave::isEdited() const { return m_edited; }
 
 int Wave::getDuration() const
 {
-	return buffer.countFrames() / m_rate;
+	return buffer->countFrames() / m_rate;
 }
 
 
@@ -127,7 +131,7 @@ std::string Wave::getExtension() const
 
 float* Wave::getFrame(int f) const
 {
-	return buffer[f];
+	return (*buffer)[f];
 }
 
 
@@ -156,7 +160,8 @@ void Wave::setPath(const string& p, int id)
 
 void Wave::copyData(float* data, int frames, int offset)
 {
-	buffer.copyData(data, frames, offset);
+	detach();
+	buffer->copyData(data, frames, offset);
 }
 
 
@@ -165,5 +170,30 @@ void Wave::copyData(float* data, int frames, int offset)
 
 void Wave::moveData(giada::m::AudioBuffer& b)
 {
-	buffer.moveData(b);
+	if (isShared())
+		buffer = std::make_shared<giada::m::AudioBuffer>();
+	buffer->moveData(b);
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void Wave::shareData(std::shared_ptr<giada::m::AudioBuffer> b)
+{
+	buffer = b;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void Wave::detach()
+{
+	if (!isShared())
+		return;
+	std::shared_ptr<giada::m::AudioBuffer> b = std::make_shared<giada::m::AudioBuffer>();
+	b->alloc(buffer->countFrames(), buffer->countChannels());
+	b->copyData((*buffer)[0], buffer->countFrames());
+	buffer = b;
 }
\ No newline at end of file
@@ -30,6 +30,7 @@
 
 
 #include <sndfile.h>
+#include <memory>
 #include <string>
 #include "const.h"
 #include "audioBuffer.h"
@@ -82,11 +83,26 @@ public:
 
 	void copyData(float* data, int frames, int offset=0);
 
+	/* shareData
+	References the buffer 'b' without copying it. Several Waves may share the 
+	same data, e.g. the channels recording the same input take. */
+
+	void shareData(std::shared_ptr<giada::m::AudioBuffer> b);
+
+	/* detach
+	Gives this Wave its own copy of the data, if currently shared. Call it before
+	editing data in place. It swaps the buffer right away: if the audio thread 
+	may be reading this Wave, make the copy first and swap it in with 
+	shareData() under the mixer lock instead. */
+
+	void detach();
+	bool isShared() const;
+
 	void alloc(int size, int channels, int rate, int bits, const std::string& path);
 
 private:
 
-	giada::m::AudioBuffer buffer;
+	std::shared_ptr<giada::m::AudioBuffer> buffer;
 	int m_rate;
 	int m_bits;
 	bool m_logical;     // memory only (a take)
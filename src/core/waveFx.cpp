@@ -92,6 +92,8 @@ void normalizeHard(Wave& w, int a, int b)
 	if (peak == 0.0f || peak > 1.0f)  // as in ::normalizeSoft
 		return;
 
+	w.detach();
+
 	for (int i=a; i<b; i++) {
 		for (int j=0; j<w.getChannels(); j++)
 			w[i][j] = w[i][j] * (1.0f / peak);
@@ -128,6 +130,8 @@ void silence(Wave& w, int a, int b)
 {
 	gu_log("[wfx::silence] silencing from %d to %d\n", a, b);
 
+	w.detach();
+
 	for (int i=a; i<b; i++) {
 		for (int j=0; j<w.getChannels(); j++)	
 			w[i][j] = 0.0f;
@@ -227,6 +231,8 @@ void fade(Wave& w, int a, int b, int type)
 {
 	gu_log("[wfx::fade] fade from %d to %d (range = %d)\n", a, b, b-a);
 
+	w.detach();
+
 	float m = 0.0f;
 	float d = 1.0f / (float) (b - a);
 
@@ -269,6 +275,8 @@ void shift(Wave& w, int offset)
 	if (offset < 0)
 		offset = (w.getSize() + w.getChannels()) + offset;
 
+	w.detach();
+
 	float* begin = w.getFrame(0);
 	float* end   = w.getFrame(0) + (w.getSize() * w.getChannels());
 
@@ -284,6 +292,8 @@ void reverse(Wave& w, int a, int b)
 {
 	/* https://stackoverflow.com/questions/33201528/reversing-an-array-of-structures-in-c */
 
+	w.detach();
+
 	float* begin = w.getFrame(0) + (a * w.getChannels());
 	float* end   = w.getFrame(0) + (b * w.getChannels());
 
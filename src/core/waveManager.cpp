@@ -31,6 +31,7 @@
 #include "../utils/log.h"
 #include "../utils/fs.h"
 #include "const.h"
+#include "audioBuffer.h"
 #include "wave.h"
 #include "waveFx.h"
 #include "waveManager.h"
@@ -130,6 +131,24 @@ std::unique_ptr<Wave> createEmpty(int frames, int channels, int samplerate,
 /* -------------------------------------------------------------------------- */
 
 
+std::unique_ptr<Wave> createFromBuffer(std::shared_ptr<AudioBuffer> b, 
+	int samplerate, const string& name)
+{
+	std::unique_ptr<Wave> wave = std::make_unique<Wave>();
+	wave->alloc(0, b->countChannels(), samplerate, G_DEFAULT_BIT_DEPTH, name);
+	wave->shareData(b);
+	wave->setLogical(true);
+
+	gu_log("[waveManager::createFromBuffer] new shared Wave created, %d frames\n", 
+		wave->getSize());
+
+	return wave;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
 std::unique_ptr<Wave> createFromWave(const Wave* src, int a, int b)
 {
 	int channels = src->getChannels();
@@ -37,7 +37,10 @@ class Wave;
 
 
 namespace giada {
-namespace m {
+namespace m 
+{
+class AudioBuffer;
+
 namespace waveManager
 {
 struct Result
@@ -57,6 +60,13 @@ Creates a new silent Wave object. */
 std::unique_ptr<Wave> createEmpty(int frames, int channels, int samplerate, 
     const std::string& name);
 
+/* createFromBuffer
+Creates a new memory-only Wave that references the shared buffer 'b', with no
+copy involved. */
+
+std::unique_ptr<Wave> createFromBuffer(std::shared_ptr<AudioBuffer> b, 
+    int samplerate, const std::string& name);
+
 /* createFromWave
 Creates a new Wave from an existing one, copying the data in range a - b. */
 
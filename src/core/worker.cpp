@@ -0,0 +1,147 @@
+/* -----------------------------------------------------------------------------
+ *
+ * Giada - Your Hardcore Loopmachine
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2019 Giovanni A. Zuliani | Monocasual
+ *
+ * This file is part of Giada - Your Hardcore Loopmachine.
+ *
+ * Giada - Your Hardcore Loopmachine is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * Giada - Your Hardcore Loopmachine is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Giada - Your Hardcore Loopmachine. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------------- */
+
+
+#include <atomic>
+#include <thread>
+#include "../glue/main.h"
+#include "../glue/transport.h"
+#include "../utils/log.h"
+#include "../utils/time.h"
+#include "const.h"
+#include "clock.h"
+#include "mixer.h"
+#include "pluginHost.h"
+#include "recorder.h"
+#include "worker.h"
+
+
+namespace giada {
+namespace m {
+namespace worker
+{
+namespace
+{
+std::thread       thread_;
+std::atomic<bool> running_(false);
+
+/* bpm_, bpmChanged_
+Tempo change posted by the audio thread. Only the latest value matters: 
+intermediate changes that occur before the worker wakes up are dropped. */
+
+std::atomic<float> bpm_(G_DEFAULT_BPM);
+std::atomic<bool>  bpmChanged_(false);
+
+/* transport_
+Sequencer start or stop posted by the audio thread, if any. As above, only 
+the latest one matters. */
+
+enum class Transport_ { NONE, START, STOP };
+
+std::atomic<Transport_> transport_(Transport_::NONE);
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void run_()
+{
+	while (running_.load()) {
+		if (bpmChanged_.exchange(false)) {
+			recorder::prepareFrames();
+			c::main::setBpm(bpm_.load());
+		}
+		Transport_ t = transport_.exchange(Transport_::NONE);
+		if (t != Transport_::NONE)
+			c::transport::setRunning(t == Transport_::START);
+#ifdef WITH_VST
+		pluginHost::reclaim();
+#endif
+		u::time::sleep(G_WORKER_RATE);
+	}
+}
+} // {anonymous}
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+
+void init()
+{
+	running_.store(true);
+	thread_ = std::thread(run_);
+	gu_log("[worker::init] worker thread started\n");
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void close()
+{
+	if (!running_.load())
+		return;
+	running_.store(false);
+	thread_.join();
+	gu_log("[worker::close] worker thread stopped\n");
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void setBpm(float b)
+{
+	if (mixer::recording)
+		return;
+	if (b < G_MIN_BPM)
+		b = G_MIN_BPM;
+	else
+	if (b > G_MAX_BPM)
+		b = G_MAX_BPM;
+
+	clock::setBpm(b);
+	bpm_.store(b);
+	bpmChanged_.store(true);
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void startSeq()
+{
+	transport_.store(Transport_::START);
+}
+
+
+void stopSeq()
+{
+	transport_.store(Transport_::STOP);
+}
+}}}; // giada::m::worker::
@@ -0,0 +1,63 @@
+/* -----------------------------------------------------------------------------
+ *
+ * Giada - Your Hardcore Loopmachine
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2019 Giovanni A. Zuliani | Monocasual
+ *
+ * This file is part of Giada - Your Hardcore Loopmachine.
+ *
+ * Giada - Your Hardcore Loopmachine is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * Giada - Your Hardcore Loopmachine is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Giada - Your Hardcore Loopmachine. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------------- */
+
+
+#ifndef G_WORKER_H
+#define G_WORKER_H
+
+
+namespace giada {
+namespace m {
+namespace worker
+{
+/* init, close
+Starts and stops the worker thread, a non-realtime thread that carries out the
+heavy work the audio thread must never do by itself. */
+
+void init();
+void close();
+
+/* setBpm
+Real-time safe tempo change, meant to be called from the audio thread. Updates
+the clock right away (O(1)) and defers the follow-up work to the worker 
+thread. The worker computes the actions remap, then posts the rest to the UI 
+thread, which just swaps the new actions in and refreshes the UI. Ignored 
+while recording audio, as c::main::setBpm() does. */
+
+void setBpm(float b);
+
+/* startSeq, stopSeq
+Real-time safe follow-up of a sequencer start or stop already applied to the 
+clock by the audio thread, e.g. when following a MIDI master. The rest of the
+work (Jack transport, input recording, UI) is handed over to the UI thread 
+through c::transport::setRunning(). Only the latest request matters. */
+
+void startSeq();
+void stopSeq();
+}}}; // giada::m::worker::
+
+
+#endif
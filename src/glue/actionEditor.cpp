@@ -67,12 +67,14 @@ void recordFirstEnvelopeAction_(int channel, Frame frame, int value)
 
 	m::MidiEvent e1 = m::MidiEvent(m::MidiEvent::ENVELOPE, 0, G_MAX_VELOCITY);
 	m::MidiEvent e2 = m::MidiEvent(m::MidiEvent::ENVELOPE, 0, value);
-	const m::Action* a1 = mr::rec(channel, 0, e1);	
-	const m::Action* a2 = mr::rec(channel, frame, e2);
-	const m::Action* a3 = mr::rec(channel, m::clock::getFramesInLoop() - 1, e1);
-	mr::updateSiblings(a1, a3, a2); // Circular loop (begin)
-	mr::updateSiblings(a2, a1, a3);
-	mr::updateSiblings(a3, a2, a1); // Circular loop (end)
+	mr::Transaction t;
+	const m::Action* a1 = t.rec(channel, 0, e1);	
+	const m::Action* a2 = t.rec(channel, frame, e2);
+	const m::Action* a3 = t.rec(channel, m::clock::getFramesInLoop() - 1, e1);
+	t.updateSiblings(a1, a3, a2); // Circular loop (begin)
+	t.updateSiblings(a2, a1, a3);
+	t.updateSiblings(a3, a2, a1); // Circular loop (end)
+	mr::commit(t);
 }
 
 
@@ -89,28 +91,25 @@ void recordNonFirstEnvelopeAction_(int channel, Frame frame, int value)
 
 	m::MidiEvent e2 = m::MidiEvent(m::MidiEvent::ENVELOPE, 0, value);
 	const m::Action* a1 = mr::getClosestAction(channel, frame, m::MidiEvent::ENVELOPE);
-	const m::Action* a3 = a1->next;
+	const m::Action* a3 = a1->getNext();
 	assert(a1 != nullptr);
 	assert(a3 != nullptr);
 	frame = fixVerticalEnvActions_(frame, a1, a3);
 	if (frame == -1) // Vertical points, nothing to do here
 		return;
-	const m::Action* a2 = mr::rec(channel, frame, e2);
-	mr::updateSiblings(a2, a1, a3);
+	mr::Transaction t;
+	const m::Action* a2 = t.rec(channel, frame, e2);
+	t.updateSiblings(a2, a1, a3);
+	mr::commit(t);
 }
-}; // {anonymous}
 
 
-/* -------------------------------------------------------------------------- */
-/* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
 
-void recordMidiAction(m::MidiChannel* ch, int note, int velocity, Frame f1, Frame f2)
+void recordMidiAction_(m::recorder::Transaction& t, int channel, int note, 
+	int velocity, Frame f1, Frame f2)
 {
-	namespace mr = m::recorder;
-	namespace cr = c::recorder;
-
 	if (f2 == 0)
 		f2 = f1 + G_DEFAULT_ACTION_SIZE;
 
@@ -125,38 +124,111 @@ void recordMidiAction(m::MidiChannel* ch, int note, int velocity, Frame f1, Fram
 	m::MidiEvent e1 = m::MidiEvent(m::MidiEvent::NOTE_ON,  note, velocity);
 	m::MidiEvent e2 = m::MidiEvent(m::MidiEvent::NOTE_OFF, note, velocity);
 
-	const m::Action* a1 = mr::rec(ch->index, f1, e1);
-	const m::Action* a2 = mr::rec(ch->index, f2, e2);
+	const m::Action* a1 = t.rec(channel, f1, e1);
+	const m::Action* a2 = t.rec(channel, f2, e2);
 
-	mr::updateSiblings(a1, nullptr, a2);
-
-	cr::updateChannel(ch->guiChannel, /*refreshActionEditor=*/false);
+	t.updateSiblings(a1, nullptr, a2);
 }
 
 
 /* -------------------------------------------------------------------------- */
 
 
-void deleteMidiAction(m::MidiChannel* ch, const m::Action* a)
+void deleteMidiAction_(m::recorder::Transaction& t, m::MidiChannel* ch, 
+	const m::Action* a)
 {
-	namespace mr = m::recorder;
-	namespace cr = c::recorder;
-
 	assert(a != nullptr);
 	assert(a->event.getStatus() == m::MidiEvent::NOTE_ON);
 
 	/* Send a note-off first in case we are deleting it in a middle of a 
 	key_on/key_off sequence. */
 	
-	if (a->next != nullptr) {
-		ch->sendMidi(a->next, 0);
-		mr::deleteAction(a->next);
+	if (a->getNext() != nullptr) {
+		ch->sendMidi(a->getNext(), 0);
+		t.deleteAction(a->getNext());
+	}
+	t.deleteAction(a);
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void recordSampleAction_(m::recorder::Transaction& t, const m::SampleChannel* ch, 
+	int type, Frame f1, Frame f2)
+{
+	if (ch->mode == ChannelMode::SINGLE_PRESS) {
+		m::MidiEvent e1 = m::MidiEvent(m::MidiEvent::NOTE_ON, 0, 0);
+		m::MidiEvent e2 = m::MidiEvent(m::MidiEvent::NOTE_OFF, 0, 0);
+		const m::Action* a1 = t.rec(ch->index, f1, e1);
+		const m::Action* a2 = t.rec(ch->index, f2 == 0 ? f1 + G_DEFAULT_ACTION_SIZE : f2, e2);
+		t.updateSiblings(a1, nullptr, a2);
 	}
-	mr::deleteAction(a);
+	else {
+		m::MidiEvent e1 = m::MidiEvent(type, 0, 0);
+		t.rec(ch->index, f1, e1);
+	}
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void deleteSampleAction_(m::recorder::Transaction& t, const m::Action* a)
+{
+	assert(a != nullptr);
+
+	if (a->getNext() != nullptr) // For ChannelMode::SINGLE_PRESS combo
+		t.deleteAction(a->getNext());
+	t.deleteAction(a);
+}
+}; // {anonymous}
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+
+void recordMidiAction(m::MidiChannel* ch, int note, int velocity, Frame f1, Frame f2)
+{
+	namespace mr = m::recorder;
+	namespace cr = c::recorder;
+
+	mr::Transaction t;
+	recordMidiAction_(t, ch->index, note, velocity, f1, f2);
+	mr::commit(t);
+
+	cr::updateChannel(ch->guiChannel, /*refreshActionEditor=*/false);
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void deleteMidiAction(m::MidiChannel* ch, const m::Action* a)
+{
+	deleteMidiActions(ch, { a });
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void deleteMidiActions(m::MidiChannel* ch, const vector<const m::Action*>& as)
+{
+	namespace mr = m::recorder;
+	namespace cr = c::recorder;
+
+	mr::Transaction t;
+	for (const m::Action* a : as)
+		deleteMidiAction_(t, ch, a);
+	mr::commit(t);
 
 	cr::updateChannel(ch->guiChannel, /*refreshActionEditor=*/false);
 }
 
+
 /* -------------------------------------------------------------------------- */
 
 
@@ -164,33 +236,60 @@ void updateMidiAction(m::MidiChannel* ch, const m::Action* a, int note, int velo
 	Frame f1, Frame f2)
 {
 	namespace mr = m::recorder;
+	namespace cr = c::recorder;
 
-	mr::deleteAction(a->next);
-	mr::deleteAction(a);
-	
-	recordMidiAction(ch, note, velocity, f1, f2);
+	mr::Transaction t;
+	t.deleteAction(a->getNext());
+	t.deleteAction(a);
+	recordMidiAction_(t, ch->index, note, velocity, f1, f2);
+	mr::commit(t);
+
+	cr::updateChannel(ch->guiChannel, /*refreshActionEditor=*/false);
 }
 
 
 /* -------------------------------------------------------------------------- */
 
 
-void recordSampleAction(const m::SampleChannel* ch, int type, Frame f1, Frame f2)
+void moveMidiActions(m::MidiChannel* ch, const vector<const m::Action*>& as, 
+	Frame delta)
 {
 	namespace mr = m::recorder;
 	namespace cr = c::recorder;
 
-	if (ch->mode == ChannelMode::SINGLE_PRESS) {
-		m::MidiEvent e1 = m::MidiEvent(m::MidiEvent::NOTE_ON, 0, 0);
-		m::MidiEvent e2 = m::MidiEvent(m::MidiEvent::NOTE_OFF, 0, 0);
-		const m::Action* a1 = mr::rec(ch->index, f1, e1);
-		const m::Action* a2 = mr::rec(ch->index, f2 == 0 ? f1 + G_DEFAULT_ACTION_SIZE : f2, e2);
-		mr::updateSiblings(a1, nullptr, a2);
+	Frame framesInLoop = m::clock::getFramesInLoop();
+
+	/* Don't move anything if one of the notes would fall outside the loop. */
+
+	for (const m::Action* a : as) {
+		const m::Action* b = a->getNext() != nullptr ? a->getNext() : a;
+		if (a->frame + delta < 0 || b->frame + delta >= framesInLoop)
+			return;
 	}
-	else {
-		m::MidiEvent e1 = m::MidiEvent(type, 0, 0);
-		mr::rec(ch->index, f1, e1);
+
+	mr::Transaction t;
+	for (const m::Action* a : as) {
+		t.moveAction(a, a->frame + delta);
+		if (a->getNext() != nullptr)
+			t.moveAction(a->getNext(), a->getNext()->frame + delta);
 	}
+	mr::commit(t);
+
+	cr::updateChannel(ch->guiChannel, /*refreshActionEditor=*/false);
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void recordSampleAction(const m::SampleChannel* ch, int type, Frame f1, Frame f2)
+{
+	namespace mr = m::recorder;
+	namespace cr = c::recorder;
+
+	mr::Transaction t;
+	recordSampleAction_(t, ch, type, f1, f2);
+	mr::commit(t);
 	
 	cr::updateChannel(ch->guiChannel, /*refreshActionEditor=*/false);
 }
@@ -203,12 +302,42 @@ void updateSampleAction(m::SampleChannel* ch, const m::Action* a, int type, Fram
 	Frame f2)
 {
 	namespace mr = m::recorder;	
+	namespace cr = c::recorder;
 
+	mr::Transaction t;
 	if (ch->mode == ChannelMode::SINGLE_PRESS)
-		mr::deleteAction(a->next);
-	mr::deleteAction(a);
+		t.deleteAction(a->getNext());
+	t.deleteAction(a);
+	recordSampleAction_(t, ch, type, f1, f2);
+	mr::commit(t);
 
-	recordSampleAction(ch, type, f1, f2);
+	cr::updateChannel(ch->guiChannel, /*refreshActionEditor=*/false);
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void deleteSampleAction(m::SampleChannel* ch, const m::Action* a)
+{
+	deleteSampleActions(ch, { a });
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void deleteSampleActions(m::SampleChannel* ch, const vector<const m::Action*>& as)
+{
+	namespace mr = m::recorder;
+	namespace cr = c::recorder;
+
+	mr::Transaction t;
+	for (const m::Action* a : as)
+		deleteSampleAction_(t, a);
+	mr::commit(t);
+
+	cr::updateChannel(ch->guiChannel, /*refreshActionEditor=*/false);
 }
 
 
@@ -258,15 +387,17 @@ void deleteEnvelopeAction(m::Channel* ch, const m::Action* a)
 		return;
 	}
 
-	const m::Action* a1 = a->prev;
-	const m::Action* a3 = a->next; 
+	const m::Action* a1 = a->getPrev();
+	const m::Action* a3 = a->getNext(); 
 
 	/* Original status:   a1--->a--->a3
 	   Modified status:   a1-------->a3 */
 
-	mr::deleteAction(a);
-	mr::updateSiblings(a1, a1->prev, a3);
-	mr::updateSiblings(a3, a1, a3->next);
+	mr::Transaction t;
+	t.deleteAction(a);
+	t.updateSiblings(a1, a1->getPrev(), a3);
+	t.updateSiblings(a3, a1, a3->getNext());
+	mr::commit(t);
 
 	cr::updateChannel(ch->guiChannel, /*refreshActionEditor=*/false);
 }
@@ -300,24 +431,6 @@ void updateEnvelopeAction(m::Channel* ch, const m::Action* a, int frame, int val
 /* -------------------------------------------------------------------------- */
 
 
-void deleteSampleAction(m::SampleChannel* ch, const m::Action* a)
-{
-	namespace mr = m::recorder;
-	namespace cr = c::recorder;
-
-	assert(a != nullptr);
-
-	if (a->next != nullptr) // For ChannelMode::SINGLE_PRESS combo
-		mr::deleteAction(a->next);
-	mr::deleteAction(a);
-
-	cr::updateChannel(ch->guiChannel, /*refreshActionEditor=*/false);
-}
-
-
-/* -------------------------------------------------------------------------- */
-
-
 vector<const m::Action*> getActions(const m::Channel* ch)
 {
 	return m::recorder::getActionsOnChannel(ch->index);
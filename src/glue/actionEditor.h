@@ -51,12 +51,21 @@ void recordMidiAction(m::MidiChannel* ch, int note, int velocity, Frame f1, Fram
 void deleteMidiAction(m::MidiChannel* ch, const m::Action* a);
 void updateMidiAction(m::MidiChannel* ch, const m::Action* a, int note, int velocity, 
     Frame f1, Frame f2);
+
+/* deleteMidiActions, moveMidiActions
+Multiple selection versions: all NOTE_ON actions in 'as' (and their NOTE_OFF
+partners) are deleted or shifted by 'delta' frames in one go. */
+
+void deleteMidiActions(m::MidiChannel* ch, const std::vector<const m::Action*>& as);
+void moveMidiActions(m::MidiChannel* ch, const std::vector<const m::Action*>& as, 
+    Frame delta);
 void updateVelocity(const m::MidiChannel* ch, const m::Action* a, int value);
 
 /* Sample Actions. */
 
 void recordSampleAction(const m::SampleChannel* ch, int type, Frame f1, Frame f2=0);
 void deleteSampleAction(m::SampleChannel* ch, const m::Action* a);
+void deleteSampleActions(m::SampleChannel* ch, const std::vector<const m::Action*>& as);
 void updateSampleAction(m::SampleChannel* ch, const m::Action* a, int type, Frame f1, Frame f2=0);
 
 /* Envelope actions (only volume for now). */
@@ -49,8 +49,10 @@
 #include "../core/kernelAudio.h"
 #include "../core/mixerHandler.h"
 #include "../core/mixer.h"
+#include "../core/midiDispatcher.h"
 #include "../core/clock.h"
 #include "../core/pluginHost.h"
+#include "../core/pluginManager.h"
 #include "../core/conf.h"
 #include "../core/wave.h"
 #include "../core/channel.h"
@@ -59,6 +61,7 @@
 #include "../core/recorder.h"
 #include "../core/plugin.h"
 #include "../core/waveManager.h"
+#include "../core/freezer.h"
 #include "main.h"
 #include "channel.h"
 
@@ -88,6 +91,8 @@ int loadChannel(m::SampleChannel* ch, const string& fname)
 
 	conf::samplePath = gu_dirname(fname);
 
+	freezer::unfreeze(ch);
+
 	waveManager::Result res = waveManager::createFromFile(fname); 
 
 	if (res.status != G_RES_OK)
@@ -133,7 +138,8 @@ void deleteChannel(m::Channel* ch)
 	recorder::clearChannel(ch->index);
 	ch->hasActions = false;
 #ifdef WITH_VST
-	pluginHost::freeStack(pluginHost::StackType::CHANNEL, &mixer::mutex, ch);
+	pluginManager::cancelAsync(ch);
+	pluginHost::freeStack(pluginHost::StackType::CHANNEL, ch);
 #endif
 	Fl::lock();
 	G_MainWin->keyboard->deleteChannel(ch->guiChannel);
@@ -158,6 +164,7 @@ void freeChannel(m::Channel* ch)
 
 	G_MainWin->keyboard->freeChannel(ch->guiChannel);
 	m::recorder::clearChannel(ch->index);
+	m::freezer::unfreeze(ch);
 	ch->empty();
 
 	/* delete any related subwindow */
@@ -197,12 +204,17 @@ int cloneChannel(m::Channel* src)
 {
 	using namespace giada::m;
 
+#ifdef WITH_VST
+	pluginManager::finishAsync();
+#endif
+
 	Channel* ch    = mh::addChannel(src->type);
 	geChannel* gch = G_MainWin->keyboard->addChannel(src->guiChannel->getColumnIndex(), 
 		ch, src->guiChannel->getSize());
 
 	ch->guiChannel = gch;
-	ch->copy(src, &mixer::mutex);
+	ch->copy(src);
+	midiDispatcher::invalidate();
 
 	G_MainWin->keyboard->updateChannel(ch->guiChannel);
 	return true;
@@ -212,6 +224,28 @@ int cloneChannel(m::Channel* src)
 /* -------------------------------------------------------------------------- */
 
 
+void toggleFreeze(m::Channel* ch)
+{
+	using namespace giada::m;
+
+	if (ch->isFrozen()) {
+		freezer::unfreeze(ch);
+		return;
+	}
+
+	if (mixer::recording || recorder::isActive()) {
+		gdAlert("Can't freeze a channel while recording.");
+		return;
+	}
+
+	if (freezer::freeze(ch) == G_RES_ERR_NO_DATA)
+		gdAlert("Nothing to freeze: the channel has no sample or plug-ins.");
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
 void setVolume(m::Channel* ch, float v, bool gui, bool editor)
 {
 	ch->volume = v;
@@ -70,6 +70,12 @@ Makes an exact copy of Channel *ch. */
 
 int cloneChannel(m::Channel* ch);
 
+/* toggleFreeze
+Renders the channel to audio and plays it in place of the live chain, or goes 
+back to the live chain if already frozen. */
+
+void toggleFreeze(m::Channel* ch);
+
 /* toggle/set*
 Toggles or set several channel properties. If gui == true the signal comes from 
 a manual interaction on the GUI, otherwise it's a MIDI/Jack/external signal. */
@@ -37,6 +37,7 @@
 #include "../utils/gui.h"
 #include "../utils/log.h"
 #include "../utils/math.h"
+#include "../utils/string.h"
 #include "../core/recorder.h"
 #include "../core/conf.h"
 #include "../core/recManager.h"
@@ -51,6 +52,11 @@
 #include "../core/sampleChannel.h"
 #include "../core/midiChannel.h"
 #include "../core/recorderHandler.h"
+#include "../core/retroCapture.h"
+#include "../core/latencyProbe.h"
+#include "../core/waveManager.h"
+#include "../core/audioBuffer.h"
+#include "../core/patch.h"
 #include "main.h"
 #include "channel.h"
 #include "transport.h"
@@ -194,4 +200,58 @@ void stopInputRec(bool gui)
 	if (!gui) Fl::unlock();
 }
 
+
+/* -------------------------------------------------------------------------- */
+
+
+void commitRetroCapture()
+{
+	m::SampleChannel* sch = nullptr;
+	for (m::Channel* ch : m::mixer::channels)
+		if (ch->type == ChannelType::SAMPLE && static_cast<m::SampleChannel*>(ch)->wave == nullptr) {
+			sch = static_cast<m::SampleChannel*>(ch);
+			break;
+		}
+
+	if (sch == nullptr) {
+		gdAlert("No empty sample channels available for the captured input.");
+		return;
+	}
+
+	std::shared_ptr<m::AudioBuffer> take = m::retroCapture::commit(m::conf::recLatency);
+	if (take == nullptr) {
+		gdAlert("Not enough input captured yet: keep the sequencer\n"
+			"running for at least a whole loop.");
+		return;
+	}
+
+	std::string name = "TAKE-" + u::string::iToString(m::patch::lastTakeId++);
+
+	sch->pushWave(m::waveManager::createFromBuffer(take, m::conf::samplerate, name + ".wav"));
+	sch->name = name;
+
+	G_MainWin->keyboard->updateChannel(sch->guiChannel);
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+int measureLatency()
+{
+	if (!m::kernelAudio::isInputEnabled()) {
+		gdAlert("Input device disabled: latency can't be measured.");
+		return -1;
+	}
+
+	if (!gdConfirmWin("Measure latency", 
+		"Connect the output to the input (e.g. with a cable), then turn the\n"
+		"volume down: a click is going to be played. Continue?"))
+		return -1;
+
+	int latency = m::latencyProbe::measure(m::conf::samplerate);
+	if (latency == -1)
+		gdAlert("No signal from the input: is the output connected to it?");
+	return latency;
+}
 }}} // giada::c::io::
\ No newline at end of file
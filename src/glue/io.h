@@ -67,6 +67,18 @@ internal interaction on the GUI, otherwise it's a MIDI/Jack/external signal. */
 void toggleInputRec(bool gui=true);
 bool startInputRec (bool gui=true);
 void stopInputRec  (bool gui=true);
+
+/* commitRetroCapture
+Moves the last loop of input, captured in background, into the first empty 
+sample channel. */
+
+void commitRetroCapture();
+
+/* measureLatency
+Measures the round-trip latency of the running audio device, through a 
+loopback. Returns the latency in frames, or -1 on failure. */
+
+int measureLatency();
 }}} // giada::c::io::
 
 #endif
@@ -26,12 +26,14 @@
 
 
 #include <cmath>
+#include <atomic>
 #include <FL/Fl.H>
 #include "../gui/elems/mainWindow/mainIO.h"
 #include "../gui/elems/mainWindow/mainTimer.h"
 #include "../gui/elems/mainWindow/keyboard/sampleChannel.h"
 #include "../gui/elems/mainWindow/keyboard/keyboard.h"
 #include "../gui/dialogs/mainWindow.h"
+#include "../gui/dialogs/warnings.h"
 #include "../utils/gui.h"
 #include "../utils/string.h"
 #include "../utils/log.h"
@@ -42,11 +44,11 @@
 #include "../core/kernelMidi.h"
 #include "../core/kernelAudio.h"
 #include "../core/recorder.h"
-#include "../core/recorderHandler.h"
 #include "../core/conf.h"
 #include "../core/const.h"
 #include "../core/pluginManager.h"
 #include "../core/pluginHost.h"
+#include "../core/freezer.h"
 #include "main.h"
 
 
@@ -62,6 +64,96 @@ namespace main
 {
 namespace
 {
+/* bpm_
+Latest tempo posted by the worker thread, picked up later by the UI thread. */
+
+std::atomic<float> bpm_(G_DEFAULT_BPM);
+
+
+/* -------------------------------------------------------------------------- */
+
+
+/* bpmToString_
+Tempo as shown in the UI, rounded to one decimal: the clock may run on a more 
+precise value, e.g. when following a MIDI master. */
+
+string bpmToString_(float f)
+{
+	int tenths = std::lround(f * 10);
+	return std::to_string(tenths / 10) + "." + std::to_string(tenths % 10);
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+/* onBpmChanged_
+Follow-up of a tempo change already applied to the clock. UI thread only: the
+UI reads actions without locks, so the new map must be swapped in here. When 
+the change comes from the worker, the remap is already computed and only the
+swap is left (see m::recorder::prepareFrames()). */
+
+void onBpmChanged_(const string& s)
+{
+	recorder::updateFrames();
+	freezer::refresh();
+
+	if (G_MainWin != nullptr) {
+		u::gui::refreshActionEditor();
+		G_MainWin->mainTimer->setBpm(s.c_str());
+	}
+
+	gu_log("[glue::setBpm_] Bpm changed to %s (real=%f)\n", s.c_str(), clock::getBpm());
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+/* onWorkerBpm_
+Fl::awake() callback for tempo changes coming from the worker thread. The
+clock already runs at the new tempo (see m::worker::setBpm()). */
+
+void onWorkerBpm_(void* p)
+{
+	onBpmChanged_(bpmToString_(bpm_.load()));
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+#ifdef G_OS_LINUX
+
+/* onJackReconnect_
+Timer callback: tries again every G_JACK_RECONNECT_RATE seconds until the JACK
+server is back. */
+
+void onJackReconnect_(void* p)
+{
+	if (!kernelAudio::jackReconnect())
+		Fl::repeat_timeout(G_JACK_RECONNECT_RATE, onJackReconnect_);
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+/* onJackShutdown_
+Fl::awake() callback for the JACK server going away. */
+
+void onJackShutdown_(void* p)
+{
+	Fl::add_timeout(G_JACK_RECONNECT_RATE, onJackReconnect_);
+	gdAlert("The JACK server has shut down: audio is stopped.\n"
+		"Giada will reconnect as soon as the server is back.");
+}
+
+#endif
+
+
+/* -------------------------------------------------------------------------- */
+
+
 void setBpm_(float f, string s)
 {
 	if (f < G_MIN_BPM) {
@@ -74,20 +166,14 @@ void setBpm_(float f, string s)
 		s = G_MAX_BPM_STR;		
 	}
 
-	float vPre = clock::getBpm();
-	clock::setBpm(f);
-	recorderHandler::updateBpm(vPre, f, clock::getQuanto());
-	mixer::allocVirtualInput(clock::getFramesInLoop());
+	/* The audio thread reads the clock while rendering: change it between two
+	blocks. */
 
-	/* This function might get called by Jack callback BEFORE the UI is up
-	and running, that is when G_MainWin == nullptr. */
-	
-	if (G_MainWin != nullptr) {
-		u::gui::refreshActionEditor();
-		G_MainWin->mainTimer->setBpm(s.c_str());
-	}
+	pthread_mutex_lock(&mixer::mutex);
+	clock::setBpm(f);
+	pthread_mutex_unlock(&mixer::mutex);
 
-	gu_log("[glue::setBpm_] Bpm changed to %s (real=%f)\n", s.c_str(), clock::getBpm());
+	onBpmChanged_(s);
 }
 } // {anonymous}
 
@@ -131,14 +217,26 @@ void setBpm(float f)
 	if (mixer::recording)
 		return;
 
-	float intpart;
-	float fracpart = std::round(std::modf(f, &intpart) * 10);
-	string s = std::to_string((int) intpart) + "." + std::to_string((int)fracpart);
+	/* Hand it over to the UI thread, that owns the actions. Only the latest 
+	value matters if more changes pile up in the meantime. */
 
-	setBpm_(f, s);
+	bpm_.store(f);
+	Fl::awake(onWorkerBpm_, nullptr);
 }
 
 
+/* -------------------------------------------------------------------------- */
+
+#ifdef G_OS_LINUX
+
+void onJackShutdown()
+{
+	Fl::awake(onJackShutdown_, nullptr);
+}
+
+#endif
+
+
 /* -------------------------------------------------------------------------- */
 
 
@@ -149,10 +247,13 @@ void setBeats(int beats, int bars)
 	if (mixer::recording)
 		return;
 
+	pthread_mutex_lock(&mixer::mutex);
 	clock::setBeats(beats);
 	clock::setBars(bars);
 	clock::updateFrameBars();
-	mixer::allocVirtualInput(clock::getFramesInLoop());
+	pthread_mutex_unlock(&mixer::mutex);
+	recorder::updateFrames();
+	freezer::refresh();
 
 	G_MainWin->mainTimer->setMeter(clock::getBeats(), clock::getBars());
 	u::gui::refreshActionEditor();  // in case the action editor is open
@@ -229,13 +330,16 @@ void clearAllActions()
 void resetToInitState(bool resetGui, bool createColumns)
 {
 	u::gui::closeAllSubwindows();
+#ifdef WITH_VST
+	pluginManager::cancelAsync();
+#endif
 	mixer::close();
 	clock::init(conf::samplerate, conf::midiTCfps);
-	mixer::init(clock::getFramesInLoop(), kernelAudio::getRealBufSize());
+	mixer::init(kernelAudio::getRealBufSize());
 	recorder::init(&mixer::mutex);
 
 #ifdef WITH_VST
-	pluginHost::freeAllStacks(&mixer::channels, &mixer::mutex);
+	pluginHost::freeAllStacks(&mixer::channels);
 	pluginManager::init(conf::samplerate, kernelAudio::getRealBufSize());
 #endif
 
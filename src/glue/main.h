@@ -46,10 +46,22 @@ Sets bpm value from string to float. */
 void setBpm(const char* v1, const char* v2);
 
 /* setBpm (2)
-Sets bpm value. Usually called from the Jack callback or non-UI components. */
+Follow-up of a tempo change already applied to the clock by a non-UI thread, 
+usually the worker one on Jack tempo changes. The actual work is posted to the
+UI thread. Never call it from the audio thread: use m::worker::setBpm() there. */
 
 void setBpm(float v);
 
+#ifdef __linux__
+
+/* onJackShutdown
+Called by kernelAudio from a JACK thread when the server shuts down. Warns the
+user and keeps trying to reconnect from the UI thread. */
+
+void onJackShutdown();
+
+#endif
+
 void setBeats(int beats, int bars);
 void quantize(int val);
 void setOutVol(float v, bool gui=true);
@@ -86,7 +86,7 @@ void addPlugin(Channel* ch, int index, m::pluginHost::StackType t)
 		return;
 	std::unique_ptr<Plugin> p = pluginManager::makePlugin(index);
 	if (p != nullptr)
-		pluginHost::addPlugin(std::move(p), t, &mixer::mutex, ch);
+		pluginHost::addPlugin(std::move(p), t, ch);
 }
 
 
@@ -95,8 +95,7 @@ void addPlugin(Channel* ch, int index, m::pluginHost::StackType t)
 
 void swapPlugins(Channel* ch, int index1, int index2, m::pluginHost::StackType t)
 {
-  pluginHost::swapPlugin(index1, index2, t, &mixer::mutex,
-    ch);
+  pluginHost::swapPlugin(index1, index2, t, ch);
 }
 
 
@@ -105,7 +104,7 @@ void swapPlugins(Channel* ch, int index1, int index2, m::pluginHost::StackType t
 
 void freePlugin(Channel* ch, int index, m::pluginHost::StackType t)
 {
-  pluginHost::freePlugin(index, t, &mixer::mutex, ch);
+  pluginHost::freePlugin(index, t, ch);
 }
 
 
@@ -41,6 +41,8 @@
 #include "../gui/elems/sampleEditor/waveform.h"
 #include "../gui/elems/mainWindow/keyboard/channel.h"
 #include "../core/sampleChannel.h"
+#include "../core/audioBuffer.h"
+#include "../core/mixer.h"
 #include "../core/waveFx.h"
 #include "../core/wave.h"
 #include "../core/waveManager.h"
@@ -64,6 +66,27 @@ namespace
 	A Wave used during cut/copy/paste operations. */
 
 	std::unique_ptr<Wave> waveBuffer_;
+
+
+	/* detach_
+	Channels recording the same take share its data: give this one its own copy
+	before editing it in place. The copy is made here, the swap happens between 
+	two audio blocks. The old data is still referenced by the other channels, 
+	so nothing gets freed in the lock. */
+
+	void detach_(m::SampleChannel* ch)
+	{
+		if (!ch->wave->isShared())
+			return;
+
+		std::shared_ptr<m::AudioBuffer> b = std::make_shared<m::AudioBuffer>();
+		b->alloc(ch->wave->getSize(), ch->wave->getChannels());
+		b->copyData(ch->wave->getFrame(0), ch->wave->getSize());
+
+		pthread_mutex_lock(&m::mixer::mutex);
+		ch->wave->shareData(b);
+		pthread_mutex_unlock(&m::mixer::mutex);
+	}
 }; // {anonymous}
 
 
@@ -102,6 +125,7 @@ void setBeginEnd(m::SampleChannel* ch, int b, int e)
 void cut(m::SampleChannel* ch, int a, int b)
 {
 	copy(ch, a, b);
+	detach_(ch);
 	if (!m::wfx::cut(*ch->wave, a, b)) {
 		gdAlert("Unable to cut the sample!");
 		return;
@@ -133,6 +157,7 @@ void paste(m::SampleChannel* ch, int a)
 		return;
 	}
 	
+	detach_(ch);
 	m::wfx::paste(*waveBuffer_.get(), *ch->wave.get(), a);
 
 	/* Shift begin/end points to keep the previous position. */
@@ -155,6 +180,7 @@ void paste(m::SampleChannel* ch, int a)
 
 void silence(m::SampleChannel* ch, int a, int b)
 {
+	detach_(ch);
 	m::wfx::silence(*ch->wave, a, b);
 	gdSampleEditor* gdEditor = getSampleEditorWindow();
 	gdEditor->waveTools->waveform->refresh();
@@ -166,6 +192,7 @@ void silence(m::SampleChannel* ch, int a, int b)
 
 void fade(m::SampleChannel* ch, int a, int b, int type)
 {
+	detach_(ch);
 	m::wfx::fade(*ch->wave, a, b, type);
 	gdSampleEditor* gdEditor = getSampleEditorWindow();
 	gdEditor->waveTools->waveform->refresh();
@@ -177,6 +204,7 @@ void fade(m::SampleChannel* ch, int a, int b, int type)
 
 void smoothEdges(m::SampleChannel* ch, int a, int b)
 {
+	detach_(ch);
 	m::wfx::smooth(*ch->wave, a, b);
 	gdSampleEditor* gdEditor = getSampleEditorWindow();
 	gdEditor->waveTools->waveform->refresh();
@@ -188,6 +216,7 @@ void smoothEdges(m::SampleChannel* ch, int a, int b)
 
 void reverse(m::SampleChannel* ch, int a, int b)
 {
+	detach_(ch);
 	m::wfx::reverse(*ch->wave, a, b);
 	gdSampleEditor* gdEditor = getSampleEditorWindow();
 	gdEditor->waveTools->waveform->refresh();
@@ -199,6 +228,7 @@ void reverse(m::SampleChannel* ch, int a, int b)
 
 void normalizeHard(m::SampleChannel* ch, int a, int b)
 {
+	detach_(ch);
 	m::wfx::normalizeHard(*ch->wave, a, b);
 	gdSampleEditor* gdEditor = getSampleEditorWindow();
 	gdEditor->waveTools->waveform->refresh();
@@ -210,6 +240,7 @@ void normalizeHard(m::SampleChannel* ch, int a, int b)
 
 void trim(m::SampleChannel* ch, int a, int b)
 {
+	detach_(ch);
 	if (!m::wfx::trim(*ch->wave, a, b)) {
 		gdAlert("Unable to trim the sample!");
 		return;
@@ -284,6 +315,7 @@ bool isWaveBufferFull()
 
 void shift(m::SampleChannel* ch, int offset)
 {
+	detach_(ch);
 	m::wfx::shift(*ch->wave, offset - ch->shift);
 	ch->shift = offset;
 	gdSampleEditor* gdEditor = getSampleEditorWindow();
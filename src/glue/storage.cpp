@@ -28,7 +28,7 @@
 #include "../core/mixer.h"
 #include "../core/mixerHandler.h"
 #include "../core/channel.h"
-#include "../core/recorderHandler.h"
+#include "../core/recorder.h"
 #include "../core/pluginManager.h"
 #include "../core/pluginHost.h"
 #include "../core/plugin.h"
@@ -78,8 +78,10 @@ void fillPatchGlobalsPlugins_(vector<m::Plugin*> stack, vector<m::patch::plugin_
 		patch::plugin_t ppl;
 		ppl.path   = plugin->getUniqueId();
 		ppl.bypass = plugin->isBypassed();
-		for (int k=0; k<plugin->getNumParameters(); k++)
-			ppl.params.push_back(plugin->getParameter(k));
+		ppl.state  = plugin->getState();
+		if (ppl.state.empty())  // No chunk: parameters are the only way
+			for (int k=0; k<plugin->getNumParameters(); k++)
+				ppl.params.push_back(plugin->getParameter(k));
 		patch.push_back(ppl);
 	}
 }
@@ -163,6 +165,10 @@ bool savePatch_(const string& fullPath, const string& name, bool isProject)
 {
 	using namespace giada::m;
 
+#ifdef WITH_VST
+	pluginManager::finishAsync();
+#endif
+
 	patch::init();
 
 	fillPatchGlobals_(name);
@@ -294,12 +300,13 @@ void loadPatch(void* data)
 		}
 	}
 
-	/* Prepare Mixer and Recorder. The latter has to recompute the actions' 
-	positions if the current samplerate != patch samplerate.*/
+	/* Prepare Mixer and Recorder. The latter has to compute the actions' 
+	positions in frames, now that the clock is set according to the patch and 
+	the current samplerate. */
 
 	mh::updateSoloCount();
 	mh::readPatch();
-	recorderHandler::updateSamplerate(conf::samplerate, patch::samplerate);
+	recorder::updateFrames();
 
 	/* Save patchPath by taking the last dir of the broswer, in order to reuse it 
 	the next time. */
@@ -25,6 +25,7 @@
  * -------------------------------------------------------------------------- */
 
 
+#include <atomic>
 #include <FL/Fl.H>
 #include "../gui/elems/mainWindow/mainTransport.h"
 #include "../gui/dialogs/mainWindow.h"
@@ -50,6 +51,34 @@ namespace giada {
 namespace c {
 namespace transport 
 {
+namespace
+{
+/* running_
+Latest sequencer status posted by the worker thread, picked up later by the 
+UI thread. */
+
+std::atomic<bool> running_(false);
+
+
+/* -------------------------------------------------------------------------- */
+
+
+/* onSetRunning_
+Fl::awake() callback for sequencer starts and stops coming from the worker 
+thread. The clock status is already set (see m::worker::startSeq()). */
+
+void onSetRunning_(void* p)
+{
+	running_.load() ? startSeq(false) : stopSeq(false);
+}
+} // {anonymous}
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+
 void startStopSeq(bool gui)
 {
 	clock::isRunning() ? stopSeq(gui) : startSeq(gui);
@@ -150,6 +179,16 @@ void rewindSeq(bool gui, bool notifyJack)
 /* -------------------------------------------------------------------------- */
 
 
+void setRunning(bool running)
+{
+	running_.store(running);
+	Fl::awake(onSetRunning_, nullptr);
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
 void toggleMetronome(bool gui)
 {
 	mixer::toggleMetronome();
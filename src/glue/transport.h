@@ -38,6 +38,14 @@ void startSeq(bool gui=true);
 void stopSeq(bool gui=true);
 void rewindSeq(bool gui=true, bool notifyJack=true);
 void toggleMetronome(bool gui=true);
+
+/* setRunning
+Follow-up of a sequencer start or stop already applied to the clock by a 
+non-UI thread, usually the worker one when following a MIDI master. The actual
+work is posted to the UI thread. Never call it from the audio thread: use 
+m::worker::startSeq() or stopSeq() there. */
+
+void setRunning(bool running);
 }}} // giada::c::transport::
 
 
@@ -41,6 +41,7 @@ geBaseAction::geBaseAction(Pixel X, Pixel Y, Pixel W, Pixel H, bool resizable,
   onLeftEdge (false),
   hovered    (false),
   altered    (false),
+  selected   (false),
   pick       (0),
   a1         (a1),
   a2         (a2)
@@ -71,6 +71,7 @@ public:
 	bool onLeftEdge;
 	bool hovered;
 	bool altered;
+	bool selected;
 	Pixel pick;
 
 	const m::Action* a1;
@@ -42,7 +42,8 @@ geBaseActionEditor::geBaseActionEditor(Pixel x, Pixel y, Pixel w, Pixel h, m::Ch
 :	Fl_Group(x, y, w, h),
 	m_ch    (ch),
 	m_base  (static_cast<gdBaseActionEditor*>(window())),
-	m_action(nullptr)
+	m_action     (nullptr),
+	m_multiSelect(false)
 {
 }
 
@@ -64,6 +65,21 @@ geBaseAction* geBaseActionEditor::getActionAtCursor() const
 /* -------------------------------------------------------------------------- */
 
 
+std::vector<const m::Action*> geBaseActionEditor::getSelectedActions() const
+{
+	std::vector<const m::Action*> out;
+	for (int i=0; i<children(); i++) {
+		const geBaseAction* a = static_cast<const geBaseAction*>(child(i));
+		if (a->selected)
+			out.push_back(a->a1);
+	}
+	return out;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
 void geBaseActionEditor::baseDraw(bool clear) const
 {
 	/* Clear the screen. */
@@ -142,6 +158,12 @@ int geBaseActionEditor::push()
 			if (Fl::event_x() < m_base->loopWidth) // Avoid click on grey area
 				onAddAction();
 		}
+		else
+		if (m_multiSelect && Fl::event_ctrl()) { // Toggle selection
+			m_action->selected = !m_action->selected;
+			m_action->redraw();
+			m_action = nullptr;
+		}
 		else                        // Prepare for dragging
 			m_action->pick = Fl::event_x() - m_action->x();
 	}
@@ -30,6 +30,7 @@
 #define GE_BASE_ACTION_EDITOR_H
 
 
+#include <vector>
 #include <FL/Fl_Group.H>
 
 
@@ -63,6 +64,11 @@ protected:
 
 	geBaseAction* m_action;
 
+	/* m_multiSelect
+	Whether Ctrl+click can add actions to a multiple selection. */
+
+	bool m_multiSelect;
+
 	/* baseDraw
 	Draws basic things like borders and grids. Optional background clear. */
 
@@ -93,6 +99,11 @@ public:
 	Fl::belowmouse? It would require a boring dynamic_cast. */
 
 	geBaseAction* getActionAtCursor() const;	
+
+	/* getSelectedActions
+	Returns the first action of each selected widget. */
+
+	std::vector<const m::Action*> getSelectedActions() const;
 };
 }} // giada::v::
 
@@ -60,7 +60,7 @@ bool gePianoItem::isResizable() const
 
 void gePianoItem::draw()
 {
-	Fl_Color color = hovered ? G_COLOR_LIGHT_2 : G_COLOR_LIGHT_1;
+	Fl_Color color = selected ? G_COLOR_RED_ALERT : hovered ? G_COLOR_LIGHT_2 : G_COLOR_LIGHT_1;
 
 	Pixel by = y() + 2;
 	Pixel bh = h() - 3;
@@ -55,6 +55,7 @@ gePianoRoll::gePianoRoll(Pixel X, Pixel Y, Pixel W, m::MidiChannel* ch)
 	  pick              (0)
 {
 	position(x(), m::conf::pianoRollY == -1 ? y()-(h()/2) : m::conf::pianoRollY);
+	m_multiSelect = true;
 }
 
 
@@ -231,7 +232,14 @@ void gePianoRoll::onAddAction()
 
 void gePianoRoll::onDeleteAction()
 {
-	c::actionEditor::deleteMidiAction(static_cast<m::MidiChannel*>(m_ch), m_action->a1);	
+	m::MidiChannel* ch = static_cast<m::MidiChannel*>(m_ch);
+
+	/* Right click on a selected action deletes the whole selection. */
+
+	if (m_action->selected)
+		c::actionEditor::deleteMidiActions(ch, getSelectedActions());
+	else
+		c::actionEditor::deleteMidiAction(ch, m_action->a1);	
 	
 	m_base->rebuild();  // Rebuild velocityEditor as well
 }
@@ -314,6 +322,16 @@ void gePianoRoll::onRefreshAction()
 
 	assert(f2 != 0);
 
+	/* Dragging a selected action moves the whole selection in time, by the 
+	same amount. Notes are left untouched. */
+
+	if (!m_action->isOnEdges() && m_action->selected) {
+		ca::moveMidiActions(static_cast<m::MidiChannel*>(m_ch), getSelectedActions(), 
+			f1 - m_action->a1->frame);
+		m_base->rebuild();
+		return;
+	}
+
 	int note     = yToNote(m_action->y() - y());
 	int velocity = m_action->a1->event.getVelocity();
 
@@ -375,7 +393,7 @@ void gePianoRoll::rebuild()
 			continue;
 
 		const m::Action* a1 = action;
-		const m::Action* a2 = action->next;
+		const m::Action* a2 = action->getNext();
 
 		assert(a1 != nullptr);  // a2 might be null if orphaned
 
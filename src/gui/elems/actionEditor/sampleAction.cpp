@@ -48,7 +48,7 @@ geSampleAction::geSampleAction(Pixel X, Pixel Y, Pixel W, Pixel H,
 
 void geSampleAction::draw()
 {
-	Fl_Color color = hovered ? G_COLOR_LIGHT_2 : G_COLOR_LIGHT_1; 
+	Fl_Color color = selected ? G_COLOR_RED_ALERT : hovered ? G_COLOR_LIGHT_2 : G_COLOR_LIGHT_1;
 
 	if (m_ch->mode == ChannelMode::SINGLE_PRESS) {
 		fl_rectf(x(), y(), w(), h(), color);
@@ -48,6 +48,7 @@ namespace v
 geSampleActionEditor::geSampleActionEditor(Pixel x, Pixel y, m::SampleChannel* ch)
 : geBaseActionEditor(x, y, 200, m::conf::sampleActionEditorH, ch)
 {
+	m_multiSelect = true;
 }
 
 
@@ -81,7 +82,7 @@ void geSampleActionEditor::rebuild()
 		if (a1->event.getStatus() == m::MidiEvent::ENVELOPE || isNoteOffSinglePress(a1))
 			continue;
 
-		const m::Action* a2 = a1->next;
+		const m::Action* a2 = a1->getNext();
 
 		Pixel px = x() + m_base->frameToPixel(a1->frame);
 		Pixel py = y() + 4;
@@ -145,7 +146,14 @@ void geSampleActionEditor::onAddAction()
 
 void geSampleActionEditor::onDeleteAction()  
 {
-	c::actionEditor::deleteSampleAction(static_cast<m::SampleChannel*>(m_ch), m_action->a1);
+	m::SampleChannel* ch = static_cast<m::SampleChannel*>(m_ch);
+
+	/* Right click on a selected action deletes the whole selection. */
+
+	if (m_action->selected)
+		c::actionEditor::deleteSampleActions(ch, getSelectedActions());
+	else
+		c::actionEditor::deleteSampleAction(ch, m_action->a1);
 	
 	m_base->rebuild();
 }
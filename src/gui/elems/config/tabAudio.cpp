@@ -31,6 +31,7 @@
 #include "../../../core/conf.h"
 #include "../../../core/kernelAudio.h"
 #include "../../../utils/string.h"
+#include "../../../glue/io.h"
 #include "../../../gui/dialogs/devInfo.h"
 #include "../basics/box.h"
 #include "../basics/choice.h"
@@ -49,19 +50,23 @@ geTabAudio::geTabAudio(int X, int Y, int W, int H)
 	: Fl_Group(X, Y, W, H, "Sound System")
 {
 	begin();
-	soundsys        = new geChoice(x()+114, y()+9,  250, 20, "System");
-	buffersize      = new geChoice(x()+114, y()+37, 55,  20, "Buffer size");
-	samplerate      = new geChoice(x()+309, y()+37, 55,  20, "Sample rate");
-	sounddevOut     = new geChoice(x()+114, y()+65, 222, 20, "Output device");
-	devOutInfo      = new geButton(x()+344, y()+65, 20,  20, "?");
-	channelsOut     = new geChoice(x()+114, y()+93, 55,  20, "Output channels");
-	limitOutput     = new geCheck (x()+177, y()+97, 55,  20, "Limit output");
-	sounddevIn      = new geChoice(x()+114, y()+121, 222, 20, "Input device");
-	devInInfo       = new geButton(x()+344, y()+121, 20,  20, "?");
-	channelsIn      = new geChoice(x()+114, y()+149, 55,  20, "Input channels");
-	recTriggerLevel = new geInput (x()+309, y()+149, 55,  20, "Rec threshold (dB)");
-	rsmpQuality     = new geChoice(x()+114, y()+177, 250, 20, "Resampling");
-                      new geBox(x(), rsmpQuality->y()+rsmpQuality->h()+8, w(), 92, "Restart Giada for the changes to take effect.");
+	soundsys           = new geChoice(x()+114, y()+9,  250, 20, "System");
+	buffersize         = new geChoice(x()+114, y()+37, 55,  20, "Buffer size");
+	samplerate         = new geChoice(x()+309, y()+37, 55,  20, "Sample rate");
+	sounddevOut        = new geChoice(x()+114, y()+65, 222, 20, "Output device");
+	devOutInfo         = new geButton(x()+344, y()+65, 20,  20, "?");
+	channelsOut        = new geChoice(x()+114, y()+93, 55,  20, "Output channels");
+	limitOutput        = new geCheck (x()+177, y()+97, 55,  20, "Limit output");
+	jackDirectOuts     = new geCheck (x()+271, y()+97, 55,  20, "Direct outs");
+	sounddevIn         = new geChoice(x()+114, y()+121, 222, 20, "Input device");
+	devInInfo          = new geButton(x()+344, y()+121, 20,  20, "?");
+	channelsIn         = new geChoice(x()+114, y()+149, 55,  20, "Input channels");
+	recTriggerLevel    = new geInput (x()+309, y()+149, 55,  20, "Rec threshold (dB)");
+	recTriggerLookback = new geInput (x()+309, y()+177, 55,  20, "Rec lookback (ms)");
+	recLatency         = new geInput (x()+114, y()+205, 55,  20, "Latency (frames)");
+	measureLatency     = new geButton(x()+177, y()+205, 70,  20, "Measure");
+	rsmpQuality        = new geChoice(x()+114, y()+233, 250, 20, "Resampling");
+                         new geBox(x(), rsmpQuality->y()+rsmpQuality->h()+8, w(), 36, "Restart Giada for the changes to take effect.");
 	end();
 
 	labelsize(G_GUI_FONT_SIZE_BASE);
@@ -69,6 +74,10 @@ geTabAudio::geTabAudio(int X, int Y, int W, int H)
 
 	soundsys->add("(none)");
 
+	/* Direct outputs are for JACK only, see below. */
+
+	jackDirectOuts->deactivate();
+
 #if defined(__linux__)
 
 	if (kernelAudio::hasAPI(RtAudio::LINUX_ALSA))
@@ -89,6 +98,7 @@ geTabAudio::geTabAudio(int X, int Y, int W, int H)
 			soundsys->showItem("Jack");
 			buffersize->deactivate();
 			samplerate->deactivate();
+			jackDirectOuts->activate();
 			break;
 		case G_SYS_API_PULSE:
 			soundsys->showItem("PulseAudio");
@@ -144,6 +154,7 @@ geTabAudio::geTabAudio(int X, int Y, int W, int H)
 
 	devOutInfo->callback(cb_showOutputInfo, this);
 	devInInfo->callback(cb_showInputInfo, this);
+	measureLatency->callback(cb_measureLatency, this);
 
 	if (conf::soundSystem != G_SYS_API_NONE) {
 		fetchSoundDevs();
@@ -191,8 +202,11 @@ geTabAudio::geTabAudio(int X, int Y, int W, int H)
 	rsmpQuality->value(conf::rsmpQuality);
 
 	recTriggerLevel->value(u::string::fToString(conf::recTriggerLevel, 1).c_str());
+	recTriggerLookback->value(u::string::iToString(conf::recTriggerLookback).c_str());
+	recLatency->value(u::string::iToString(conf::recLatency).c_str());
 
 	limitOutput->value(conf::limitOutput);
+	jackDirectOuts->value(conf::jackDirectOuts);
 }
 
 
@@ -204,6 +218,7 @@ void geTabAudio::cb_fetchInChans(Fl_Widget* w, void* p)        { ((geTabAudio*)p
 void geTabAudio::cb_fetchOutChans(Fl_Widget* w, void* p)       { ((geTabAudio*)p)->cb_fetchOutChans(); }
 void geTabAudio::cb_showInputInfo(Fl_Widget* w, void* p)       { ((geTabAudio*)p)->cb_showInputInfo(); }
 void geTabAudio::cb_showOutputInfo(Fl_Widget* w, void* p)      { ((geTabAudio*)p)->cb_showOutputInfo(); }
+void geTabAudio::cb_measureLatency(Fl_Widget* w, void* p)      { ((geTabAudio*)p)->cb_measureLatency(); }
 
 
 /* -------------------------------------------------------------------------- */
@@ -249,6 +264,17 @@ void geTabAudio::cb_showOutputInfo()
 /* -------------------------------------------------------------------------- */
 
 
+void geTabAudio::cb_measureLatency()
+{
+	int latency = c::io::measureLatency();
+	if (latency != -1)
+		recLatency->value(u::string::iToString(latency).c_str());
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
 void geTabAudio::cb_deactivate_sounddev()
 {
 	/* if the user changes sound system (eg ALSA->JACK) device menu deactivates.
@@ -256,6 +282,11 @@ void geTabAudio::cb_deactivate_sounddev()
 	 * querying kernelAudio. Watch out if soundsysInitValue == 0: you don't want
 	 * to query kernelAudio for '(none)' soundsystem! */
 
+	if (string(soundsys->text(soundsys->value())) == "Jack")
+		jackDirectOuts->activate();
+	else
+		jackDirectOuts->deactivate();
+
 	if (soundsysInitValue == soundsys->value() && soundsysInitValue != 0) {
 		sounddevOut->clear();
 		sounddevIn->clear();
@@ -303,12 +334,18 @@ void geTabAudio::fetchInChans(int menuItem)
 		devInInfo->deactivate();
 		channelsIn->deactivate();
 		recTriggerLevel->deactivate();
+		recTriggerLookback->deactivate();
+		recLatency->deactivate();
+		measureLatency->deactivate();
 		return;
 	}
 
 	devInInfo->activate();
 	channelsIn->activate();
 	recTriggerLevel->activate();
+	recTriggerLookback->activate();
+	recLatency->activate();
+	measureLatency->activate();
 
 	channelsIn->clear();
 
@@ -487,6 +524,7 @@ void geTabAudio::save()
 	conf::channelsOut    = channelsOut->value();
 	conf::channelsIn     = channelsIn->value();
 	conf::limitOutput    = limitOutput->value();
+	conf::jackDirectOuts = jackDirectOuts->value();
 	conf::rsmpQuality    = rsmpQuality->value();
 
 	/* if sounddevOut is disabled (because of system change e.g. alsa ->
@@ -497,6 +535,8 @@ void geTabAudio::save()
 
 	conf::buffersize = std::atoi(buffersize->text());
 	conf::recTriggerLevel = std::atof(recTriggerLevel->value());
+	conf::recTriggerLookback = std::atoi(recTriggerLookback->value());
+	conf::recLatency         = std::atoi(recLatency->value());
 
 	const Fl_Menu_Item* i = nullptr;
 	i = samplerate->mvalue(); // mvalue() returns a pointer to the last menu item that was picked
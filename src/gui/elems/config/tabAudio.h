@@ -47,11 +47,13 @@ private:
 	static void cb_fetchOutChans      (Fl_Widget* w, void* p);
 	static void cb_showInputInfo      (Fl_Widget* w, void* p);
 	static void cb_showOutputInfo     (Fl_Widget* w, void* p);
+	static void cb_measureLatency     (Fl_Widget* w, void* p);
 	void cb_deactivate_sounddev();
 	void cb_fetchInChans();
 	void cb_fetchOutChans();
 	void cb_showInputInfo();
 	void cb_showOutputInfo();
+	void cb_measureLatency();
 
 	void fetchSoundDevs();
 	void fetchInChans(int menuItem);
@@ -69,10 +71,14 @@ public:
 	geButton* devOutInfo;
 	geChoice* channelsOut;
 	geCheck*  limitOutput;
+	geCheck*  jackDirectOuts;
 	geChoice* sounddevIn;
 	geButton* devInInfo;
 	geChoice* channelsIn;
 	geInput*  recTriggerLevel;
+	geInput*  recTriggerLookback;
+	geInput*  recLatency;
+	geButton* measureLatency;
 	geChoice* rsmpQuality;
 
 	geTabAudio(int x, int y, int w, int h);
@@ -25,12 +25,15 @@
  * -------------------------------------------------------------------------- */
 
 
+#include <cstdlib>
 #include <FL/Fl_Pack.H>
 #include "../../../core/const.h"
 #include "../../../core/conf.h"
+#include "../../../utils/string.h"
 #include "../basics/box.h"
 #include "../basics/radio.h"
 #include "../basics/check.h"
+#include "../basics/input.h"
 #include "tabBehaviors.h"
 
 
@@ -57,6 +60,9 @@ geTabBehaviors::geTabBehaviors(int X, int Y, int W, int H)
 
 	treatRecsAsLoops = new geCheck(x(), y()+155, 280, 20, "Treat one shot channels with actions as loops");
   inputMonitorDefaultOn = new geCheck(x(), y()+180, 280, 20, "New sample channels have input monitor on by default");
+  retroCapture = new geCheck(x(), y()+205, 280, 20, "Keep capturing input for retroactive recording");
+  retroCaptureBudget = new geInput(x()+309, y()+230, 55, 20, "Retroactive capture memory (MB)");
+  new geBox(x(), y()+255, w(), 20, "(changes to retroactive capture require a restart)", FL_ALIGN_LEFT);
 
   end();
 
@@ -67,6 +73,8 @@ geTabBehaviors::geTabBehaviors(int X, int Y, int W, int H)
 	conf::chansStopOnSeqHalt == 1 ? chansStopOnSeqHalt_1->value(1) : chansStopOnSeqHalt_0->value(1);
 	treatRecsAsLoops->value(conf::treatRecsAsLoops);
 	inputMonitorDefaultOn->value(conf::inputMonitorDefaultOn);
+	retroCapture->value(conf::retroCapture);
+	retroCaptureBudget->value(giada::u::string::iToString(conf::retroCaptureBudget).c_str());
 
 	recsStopOnChanHalt_1->callback(cb_radio_mutex, (void*)this);
 	recsStopOnChanHalt_0->callback(cb_radio_mutex, (void*)this);
@@ -99,4 +107,6 @@ void geTabBehaviors::save()
 	conf::chansStopOnSeqHalt = chansStopOnSeqHalt_1->value() == 1 ? 1 : 0;
 	conf::treatRecsAsLoops = treatRecsAsLoops->value() == 1 ? 1 : 0;
 	conf::inputMonitorDefaultOn = inputMonitorDefaultOn->value() == 1 ? 1 : 0;
+	conf::retroCapture = retroCapture->value() == 1 ? 1 : 0;
+	conf::retroCaptureBudget = std::atoi(retroCaptureBudget->value());
 }
@@ -34,6 +34,7 @@
 
 class geRadio;
 class geCheck;
+class geInput;
 
 
 class geTabBehaviors : public Fl_Group
@@ -51,6 +52,8 @@ public:
 	geRadio *chansStopOnSeqHalt_0;
 	geCheck *treatRecsAsLoops;
 	geCheck *inputMonitorDefaultOn;
+	geCheck *retroCapture;
+	geInput *retroCaptureBudget;
 
 	geTabBehaviors(int x, int y, int w, int h);
 
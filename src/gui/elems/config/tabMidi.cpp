@@ -72,12 +72,18 @@ geTabMidi::geTabMidi(int X, int Y, int W, int H)
 	sync->add("(disabled)");
 	sync->add("MIDI Clock (master)");
 	sync->add("MTC (master)");
+	sync->add("MIDI Clock (slave)");
+	sync->add("MTC (slave)");
 	if      (conf::midiSync == MIDI_SYNC_NONE)
 		sync->value(0);
 	else if (conf::midiSync == MIDI_SYNC_CLOCK_M)
 		sync->value(1);
 	else if (conf::midiSync == MIDI_SYNC_MTC_M)
 		sync->value(2);
+	else if (conf::midiSync == MIDI_SYNC_CLOCK_S)
+		sync->value(3);
+	else if (conf::midiSync == MIDI_SYNC_MTC_S)
+		sync->value(4);
 
 	systemInitValue = system->value();
 }
@@ -178,6 +184,10 @@ void geTabMidi::save()
 		conf::midiSync = MIDI_SYNC_CLOCK_M;
 	else if (sync->value() == 2)
 		conf::midiSync = MIDI_SYNC_MTC_M;
+	else if (sync->value() == 3)
+		conf::midiSync = MIDI_SYNC_CLOCK_S;
+	else if (sync->value() == 4)
+		conf::midiSync = MIDI_SYNC_MTC_S;
 }
 
 
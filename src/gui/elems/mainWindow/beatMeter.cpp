@@ -32,6 +32,7 @@
 #include "../../../core/recManager.h"
 #include "../../../core/mixer.h"
 #include "../../../core/clock.h"
+#include "../../../core/engineState.h"
 #include "../../../utils/gui.h"
 #include "beatMeter.h"
 
@@ -50,7 +51,7 @@ geBeatMeter::geBeatMeter(int x, int y, int w, int h, const char* l)
 
 Fl_Color geBeatMeter::getCursorColor()
 {
-	if (m::clock::getStatus() == ClockStatus::WAITING && u::gui::shouldBlink())
+	if (m::engineState::get().clockStatus == ClockStatus::WAITING && u::gui::shouldBlink())
 		return FL_BACKGROUND_COLOR;
 	return G_COLOR_LIGHT_1;
 }
@@ -73,7 +74,7 @@ void geBeatMeter::draw()
 
 	/* Cursor. */
 
-	fl_rectf(x() + (clock::getCurrentBeat() * cursorW) + 3, y() + 3, cursorW - 5, h() - 6, getCursorColor());	
+	fl_rectf(x() + (engineState::get().currentBeat * cursorW) + 3, y() + 3, cursorW - 5, h() - 6, getCursorColor());	
 
 	/* Beat cells. */
 
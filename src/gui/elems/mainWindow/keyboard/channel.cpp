@@ -28,6 +28,7 @@
 #include <FL/Fl.H>
 #include "../../../../core/const.h"
 #include "../../../../core/channel.h"
+#include "../../../../core/engineState.h"
 #include "../../../../core/graphics.h"
 #include "../../../../core/pluginHost.h"
 #include "../../../../utils/gui.h"
@@ -142,7 +143,11 @@ void geChannel::blink()
 
 void geChannel::setColorsByStatus()
 {
-	switch (ch->status) {
+	const m::engineState::ChannelState* cs = m::engineState::getChannel(ch);
+	if (cs == nullptr)
+		return;
+
+	switch (cs->status) {
 		case ChannelStatus::OFF:
 		case ChannelStatus::EMPTY:
 			mainButton->setDefaultMode();
@@ -167,7 +172,7 @@ void geChannel::setColorsByStatus()
 		default: break;
 	}
 
-	switch (ch->recStatus) {
+	switch (cs->recStatus) {
 		case ChannelStatus::WAIT:
 			blink();
 			break;
@@ -29,7 +29,7 @@
 #include "../../../../core/mixer.h"
 #include "../../../../core/clock.h"
 #include "../../../../core/sampleChannel.h"
-#include "../../../../core/recorder.h"
+#include "../../../../core/engineState.h"
 #include "../../../../core/const.h"
 #include "channelStatus.h"
 
@@ -54,30 +54,34 @@ void geChannelStatus::draw()
   if (ch == nullptr) 
     return;
 
-  if (ch->status == ChannelStatus::WAIT    || 
-      ch->status == ChannelStatus::ENDING  ||
-      ch->recStatus == ChannelStatus::WAIT || 
-      ch->recStatus == ChannelStatus::ENDING)
+  const engineState::ChannelState* cs = engineState::getChannel(ch);
+  if (cs == nullptr)
+    return;
+
+  if (cs->status == ChannelStatus::WAIT    || 
+      cs->status == ChannelStatus::ENDING  ||
+      cs->recStatus == ChannelStatus::WAIT || 
+      cs->recStatus == ChannelStatus::ENDING)
   {
     fl_rect(x(), y(), w(), h(), G_COLOR_LIGHT_1);
   }
   else
-  if (ch->status == ChannelStatus::PLAY)
+  if (cs->status == ChannelStatus::PLAY)
     fl_rect(x(), y(), w(), h(), G_COLOR_LIGHT_1);
   else
     fl_rectf(x()+1, y()+1, w()-2, h()-2, G_COLOR_GREY_2);  // status empty
 
 
-  if (mixer::recording && ch->armed)
+  if (engineState::get().recording && cs->armed)
     fl_rectf(x()+1, y()+1, w()-2, h()-2, G_COLOR_RED);     // take in progress
   else
-  if (recorder::isActive())
+  if (engineState::get().actionRecording)
     fl_rectf(x()+1, y()+1, w()-2, h()-2, G_COLOR_BLUE);    // action recording
 
   /* Equation for the progress bar: 
   ((chanTracker - chanStart) * w()) / (chanEnd - chanStart). */
 
-  int pos = ch->getPosition();
+  int pos = cs->position;
   if (pos == -1)
     pos = 0;
   else
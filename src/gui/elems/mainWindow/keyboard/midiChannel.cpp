@@ -29,7 +29,7 @@
 #include "../../../../core/const.h"
 #include "../../../../core/graphics.h"
 #include "../../../../core/midiChannel.h"
-#include "../../../../core/recorder.h"
+#include "../../../../core/engineState.h"
 #include "../../../../utils/gui.h"
 #include "../../../../utils/string.h"
 #include "../../../../glue/channel.h"
@@ -77,6 +77,7 @@ enum class Menu
 	RESIZE_H3,
 	RESIZE_H4,
 	__END_RESIZE_SUBMENU__,
+	FREEZE_CHANNEL,
 	RENAME_CHANNEL,
 	CLONE_CHANNEL,
 	DELETE_CHANNEL
@@ -133,6 +134,9 @@ void menuCallback(Fl_Widget* w, void* v)
 			gch->changeSize(G_GUI_CHANNEL_H_4);
 			static_cast<geColumn*>(gch->parent())->repositionChannels();
 			break;
+		case Menu::FREEZE_CHANNEL:
+			c::channel::toggleFreeze(gch->ch);
+			break;
 		case Menu::CLONE_CHANNEL:
 			c::channel::cloneChannel(gch->ch);
 			break;		
@@ -241,6 +245,7 @@ void geMidiChannel::cb_openMenu()
 			{"Large",   0, menuCallback, (void*) Menu::RESIZE_H3},
 			{"X-Large", 0, menuCallback, (void*) Menu::RESIZE_H4},
 			{0},
+		{ch->isFrozen() ? "Unfreeze" : "Freeze", 0, menuCallback, (void*) Menu::FREEZE_CHANNEL},
 		{"Rename", 0, menuCallback, (void*) Menu::RENAME_CHANNEL},
 		{"Clone",  0, menuCallback, (void*) Menu::CLONE_CHANNEL},
 		{"Delete", 0, menuCallback, (void*) Menu::DELETE_CHANNEL},
@@ -271,7 +276,8 @@ void geMidiChannel::cb_openMenu()
 void geMidiChannel::refresh()
 {
 	setColorsByStatus();
-	if (m::recorder::isActive() && ch->armed)
+	const m::engineState::ChannelState* cs = m::engineState::getChannel(ch);
+	if (m::engineState::get().actionRecording && cs != nullptr && cs->armed)
 		mainButton->setActionRecordMode();
 	mainButton->redraw();
 }
@@ -314,7 +320,7 @@ void geMidiChannel::update()
 	arm->value(mch->armed);
 
 #ifdef WITH_VST
-	fx->status = mch->plugins.size() > 0;
+	fx->status = mch->plugins.get().size() > 0;
 	fx->redraw();
 #endif
 }
@@ -31,6 +31,7 @@
 #include "../../../../core/graphics.h"
 #include "../../../../core/wave.h"
 #include "../../../../core/recorder.h"
+#include "../../../../core/engineState.h"
 #include "../../../../core/sampleChannel.h"
 #include "../../../../glue/io.h"
 #include "../../../../glue/channel.h"
@@ -89,6 +90,7 @@ enum class Menu
 	RESIZE_H3,
 	RESIZE_H4,
 	__END_RESIZE_SUBMENU__,
+	FREEZE_CHANNEL,
 	RENAME_CHANNEL,
 	CLONE_CHANNEL,
 	FREE_CHANNEL,
@@ -184,6 +186,10 @@ void menuCallback(Fl_Widget* w, void* v)
 			static_cast<geColumn*>(gch->parent())->repositionChannels();
 			break;
 		}
+		case Menu::FREEZE_CHANNEL: {
+			c::channel::toggleFreeze(gch->ch);
+			break;
+		}
 		case Menu::CLONE_CHANNEL: {
 			c::channel::cloneChannel(gch->ch);
 			break;
@@ -318,6 +324,7 @@ void geSampleChannel::cb_openMenu()
 			{"Large",   0, menuCallback, (void*) Menu::RESIZE_H3},
 			{"X-Large", 0, menuCallback, (void*) Menu::RESIZE_H4},
 			{0},
+		{ch->isFrozen() ? "Unfreeze" : "Freeze", 0, menuCallback, (void*) Menu::FREEZE_CHANNEL},
 		{"Rename", 0, menuCallback, (void*) Menu::RENAME_CHANNEL},
 		{"Clone",  0, menuCallback, (void*) Menu::CLONE_CHANNEL},
 		{"Free",   0, menuCallback, (void*) Menu::FREE_CHANNEL},
@@ -331,6 +338,7 @@ void geSampleChannel::cb_openMenu()
 		rclick_menu[(int) Menu::EXPORT_SAMPLE].deactivate();
 		rclick_menu[(int) Menu::EDIT_SAMPLE].deactivate();
 		rclick_menu[(int) Menu::FREE_CHANNEL].deactivate();
+		rclick_menu[(int) Menu::FREEZE_CHANNEL].deactivate();
 		rclick_menu[(int) Menu::RENAME_CHANNEL].deactivate();
 	}
 
@@ -380,9 +388,11 @@ void geSampleChannel::refresh()
 	setColorsByStatus();
 
 	if (static_cast<m::SampleChannel*>(ch)->wave != nullptr) {
-		if (m::mixer::recording && ch->armed)
+		const m::engineState::State&        s  = m::engineState::get();
+		const m::engineState::ChannelState* cs = m::engineState::getChannel(ch);
+		if (s.recording && cs != nullptr && cs->armed)
 			mainButton->setInputRecordMode();
-		if (m::recorder::isActive())
+		if (s.actionRecording)
 			mainButton->setActionRecordMode();
 		status->redraw(); // status invisible? sampleButton too (see below)
 	}
@@ -446,7 +456,7 @@ void geSampleChannel::update()
 	arm->value(sch->armed);
 
 #ifdef WITH_VST
-	fx->status = sch->plugins.size() > 0;
+	fx->status = sch->plugins.get().size() > 0;
 	fx->redraw();
 #endif
 }
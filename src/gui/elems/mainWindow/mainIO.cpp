@@ -25,12 +25,15 @@
 * -------------------------------------------------------------------------- */
 
 
+#include <string>
 #include "../../../core/const.h"
 #include "../../../core/graphics.h"
 #include "../../../core/mixer.h"
+#include "../../../core/engineState.h"
 #include "../../../core/pluginHost.h"
 #include "../../../glue/main.h"
 #include "../../../utils/gui.h"
+#include "../../../utils/string.h"
 #include "../../elems/soundMeter.h"
 #include "../../elems/basics/statusButton.h"
 #include "../../elems/basics/dial.h"
@@ -79,6 +82,9 @@ geMainIO::geMainIO(int x, int y)
 	masterFxIn->callback(cb_masterFxIn, (void*)this);
 	inToOut->callback(cb_inToOut, (void*)this);
 	inToOut->type(FL_TOGGLE_BUTTON);
+
+	pluginsProcessed = -1;
+	pluginsSkipped   = -1;
 #endif
 }
 
@@ -175,10 +181,21 @@ void geMainIO::setMasterFxInFull(bool v)
 
 void geMainIO::refresh()
 {
-	outMeter->mixerPeak = m::mixer::peakOut.load();
-	inMeter->mixerPeak  = m::mixer::peakIn.load();
+	outMeter->mixerPeak = m::engineState::get().peakOut;
+	inMeter->mixerPeak  = m::engineState::get().peakIn;
 	outMeter->redraw();
 	inMeter->redraw();
+
+#ifdef WITH_VST
+	const m::engineState::State& s = m::engineState::get();
+	if (s.pluginsProcessed == pluginsProcessed && s.pluginsSkipped == pluginsSkipped)
+		return;
+	pluginsProcessed = s.pluginsProcessed;
+	pluginsSkipped   = s.pluginsSkipped;
+	std::string tip = "Plug-ins: " + u::string::iToString(pluginsProcessed) + 
+		" active, " + u::string::iToString(pluginsSkipped) + " idle";
+	masterFxOut->copy_tooltip(tip.c_str());
+#endif
 }
 
 }} // giada::v::
\ No newline at end of file
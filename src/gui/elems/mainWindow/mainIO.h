@@ -53,6 +53,12 @@ private:
   geStatusButton* masterFxOut;
   geStatusButton* masterFxIn;
   geButton*       inToOut;
+
+	/* pluginsProcessed, pluginsSkipped
+	Last plug-in stats shown in the master FX tooltip. */
+
+	int pluginsProcessed;
+	int pluginsSkipped;
 #endif
 
 	static void cb_outVol     (Fl_Widget* v, void* p);
@@ -33,9 +33,11 @@
 #include "../../../core/patch.h"
 #include "../../../core/channel.h"
 #include "../../../core/sampleChannel.h"
+#include "../../../core/retroCapture.h"
 #include "../../../utils/gui.h"
 #include "../../../glue/storage.h"
 #include "../../../glue/main.h"
+#include "../../../glue/io.h"
 #include "../../elems/basics/boxtypes.h"
 #include "../../elems/basics/button.h"
 #include "../../dialogs/mainWindow.h"
@@ -171,6 +173,7 @@ void geMainMenu::cb_edit()
 		{"Remove empty columns"},
 		{"Reset to init state"},
 		{"Setup global MIDI input..."},
+		{"Capture last loop from input"},
 		{0}
 	};
 
@@ -179,6 +182,9 @@ void geMainMenu::cb_edit()
 
 	menu[1].deactivate();
 
+	if (!m::retroCapture::isEnabled())
+		menu[5].deactivate();
+
 	for (const m::Channel* ch : m::mixer::channels)
 		if (ch->hasActions) {
 			menu[1].activate();
@@ -228,6 +234,10 @@ void geMainMenu::cb_edit()
 		u::gui::openSubWindow(G_MainWin, new gdMidiInputMaster(), 0);
 		return;
 	}
+	if (strcmp(m->label(), "Capture last loop from input") == 0) {
+		c::io::commitRetroCapture();
+		return;
+	}
 }
 
 }} // giada::v::
\ No newline at end of file
@@ -95,6 +95,7 @@ void geMidiLearner::cb_value()
 {
 	if (Fl::event_button() == FL_RIGHT_MOUSE) {
 		*param = 0x0;
+		m::midiDispatcher::invalidate();
 		updateValue();
 	}
 	/// TODO - elif (LEFT_MOUSE) : insert values by hand
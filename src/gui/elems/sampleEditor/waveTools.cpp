@@ -29,6 +29,7 @@
 #include <FL/Fl_Menu_Item.H>
 #include <FL/Fl_Menu_Button.H>
 #include "../../../core/sampleChannel.h"
+#include "../../../core/engineState.h"
 #include "../../../core/waveFx.h"
 #include "../../../glue/sampleEditor.h"
 #include "../basics/boxtypes.h"
@@ -217,7 +218,8 @@ void geWaveTools::openMenu()
 		{0}
 	};
 
-	if (ch->status == ChannelStatus::PLAY) {
+	const m::engineState::ChannelState* cs = m::engineState::getChannel(ch);
+	if (cs != nullptr && cs->status == ChannelStatus::PLAY) {
 		menu[(int)Menu::CUT].deactivate();
 		menu[(int)Menu::TRIM].deactivate();
 	}
@@ -35,6 +35,7 @@
 #include "../../../core/mixer.h"
 #include "../../../core/waveFx.h"
 #include "../../../core/sampleChannel.h"
+#include "../../../core/engineState.h"
 #include "../../../glue/channel.h"
 #include "../../../glue/sampleEditor.h"
 #include "../../../utils/log.h"
@@ -302,7 +303,10 @@ void geWaveform::drawStartEndPoints()
 
 void geWaveform::drawPlayHead()
 {
-	int p = frameToPixel(m_ch->trackerPreview) + x();
+	const engineState::ChannelState* cs = engineState::getChannel(m_ch);
+	if (cs == nullptr)
+		return;
+	int p = frameToPixel(cs->trackerPreview) + x();
 	fl_color(G_COLOR_LIGHT_2);
 	fl_line(p, y() + 1, p, y() + h() - 2);
 }
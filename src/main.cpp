@@ -26,8 +26,11 @@
 
 
 #include <atomic>
+#include <string>
 #include <FL/Fl.H>
+#include "core/const.h"
 #include "core/init.h"
+#include "core/pluginManager.h"
 
 
 std::atomic<bool> G_quit(false);
@@ -38,6 +41,11 @@ int main(int argc, char** argv)
 {
 	using namespace giada;
 
+#ifdef WITH_VST
+	if (argc == 4 && std::string(argv[1]) == G_PLUGIN_SCAN_ARG)
+		return m::pluginManager::scanFile(argv[2], argv[3]);
+#endif
+
 	m::init::startup(argc, argv);
 
 	int ret = Fl::run();
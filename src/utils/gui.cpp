@@ -35,6 +35,8 @@
 #endif
 #include "../core/mixer.h"
 #include "../core/clock.h"
+#include "../core/engineState.h"
+#include "../core/midiDispatcher.h"
 #include "../core/pluginHost.h"
 #include "../core/channel.h"
 #include "../core/conf.h"
@@ -44,13 +46,17 @@
 #include "../gui/dialogs/actionEditor/baseActionEditor.h"
 #include "../gui/dialogs/window.h"
 #include "../gui/dialogs/sampleEditor.h"
+#include "../gui/dialogs/pluginWindow.h"
 #include "../gui/elems/mainWindow/mainIO.h"
 #include "../gui/elems/mainWindow/mainTimer.h"
 #include "../gui/elems/mainWindow/mainTransport.h"
 #include "../gui/elems/mainWindow/beatMeter.h"
 #include "../gui/elems/mainWindow/keyboard/keyboard.h"
 #include "../gui/elems/mainWindow/keyboard/channel.h"
+#include "../gui/elems/basics/dial.h"
 #include "../gui/elems/sampleEditor/waveTools.h"
+#include "../gui/elems/sampleEditor/volumeTool.h"
+#include "../gui/elems/sampleEditor/pitchTool.h"
 #include "log.h"
 #include "string.h"
 #include "gui.h"
@@ -66,6 +72,52 @@ namespace gui
 namespace
 {
 int blinker_ = 0;
+
+
+/* -------------------------------------------------------------------------- */
+
+/* refreshControls_
+Brings volume knobs, the Sample Editor and the plug-in parameter windows up 
+to date with what MIDI controllers did since the last frame. */
+
+void refreshControls_()
+{
+	using namespace giada::m;
+
+	for (const Channel* ch : mixer::channels)
+		ch->guiChannel->vol->value(ch->volume);
+
+	G_MainWin->mainIO->setOutVol(mixer::outVol.load());
+	G_MainWin->mainIO->setInVol(mixer::inVol.load());
+
+	gdSampleEditor* se = static_cast<gdSampleEditor*>(getSubwindow(G_MainWin, WID_SAMPLE_EDITOR));
+	if (se != nullptr) {
+		se->volumeTool->refresh();
+		se->pitchTool->refresh();
+	}
+
+#ifdef WITH_VST
+
+	/* Plug-ins with their own editor update it on their own. */
+
+	gdWindow* list = getSubwindow(G_MainWin, WID_FX_LIST);
+	if (list == nullptr)
+		return;
+
+	auto refresh = [list] (const Plugin* p)
+	{
+		gdPluginWindow* w = static_cast<gdPluginWindow*>(getSubwindow(list, p->getId() + 1));
+		if (w != nullptr && !p->hasEditor())
+			w->updateParameters(true);
+	};
+
+	pluginHost::forEachPlugin(pluginHost::StackType::MASTER_IN, nullptr, refresh);
+	pluginHost::forEachPlugin(pluginHost::StackType::MASTER_OUT, nullptr, refresh);
+	for (const Channel* ch : mixer::channels)
+		pluginHost::forEachPlugin(pluginHost::StackType::CHANNEL, ch, refresh);
+
+#endif
+}
 } // {anonymous}
 
 
@@ -78,6 +130,14 @@ void refreshUI()
 {
 	Fl::lock();
 
+	/* Grab the latest engine state published by the audio thread: widgets below
+	read from it instead of poking into engine objects. */
+
+	m::engineState::fetch();
+
+	if (m::midiDispatcher::fetchControlChanges())
+		refreshControls_();
+
 	/* update dynamic elements: in and out meters, beat meter and
 	 * each channel */
 
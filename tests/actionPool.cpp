@@ -0,0 +1,56 @@
+#include "../src/core/actionPool.h"
+#include "../src/core/action.h"
+#include "../src/core/types.h"
+#include <catch.hpp>
+
+
+TEST_CASE("actionPool")
+{
+	using namespace giada;
+	using namespace giada::m;
+
+	size_t used = actionPool::countUsed();
+
+	Action* a1 = actionPool::alloc();
+	Action* a2 = actionPool::alloc();
+
+	REQUIRE(a1 != nullptr);
+	REQUIRE(a2 != nullptr);
+	REQUIRE(a1->handle != a2->handle);
+	REQUIRE(a1->prev == NO_ACTION);
+	REQUIRE(a1->next == NO_ACTION);
+	REQUIRE(actionPool::get(a1->handle) == a1);
+	REQUIRE(actionPool::get(NO_ACTION) == nullptr);
+	REQUIRE(actionPool::countUsed() == used + 2);
+
+	SECTION("Test siblings")
+	{
+		a1->next = a2->handle;
+		a2->prev = a1->handle;
+
+		REQUIRE(a1->getNext() == a2);
+		REQUIRE(a2->getPrev() == a1);
+		REQUIRE(a1->getPrev() == nullptr);
+
+		actionPool::free({ a1, a2 });
+	}
+
+	SECTION("Test reuse")
+	{
+		ActionHandle h = a2->handle;
+		actionPool::free(a2);
+
+		REQUIRE(actionPool::get(h) == nullptr);
+
+		Action* a3 = actionPool::alloc();
+
+		REQUIRE(a3 == a2);             // Same slot...
+		REQUIRE(a3->handle != h);      // ...new generation
+		REQUIRE(actionPool::get(h) == nullptr);
+		REQUIRE(actionPool::get(a3->handle) == a3);
+
+		actionPool::free({ a1, a3 });
+	}
+
+	REQUIRE(actionPool::countUsed() == used);
+}
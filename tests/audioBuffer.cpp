@@ -96,4 +96,54 @@ TEST_CASE("AudioBuffer")
 
 		delete[] data;
 	}
+
+	SECTION("test planar conversion")
+	{
+		SECTION("test stereo")
+		{
+			for (int i=0; i<buffer.countFrames(); i++) {
+				buffer[i][0] = (float) i;
+				buffer[i][1] = (float) -i;
+			}
+
+			float l[BUFFER_SIZE], r[BUFFER_SIZE];
+			float* planar[] = { l, r };
+
+			buffer.deinterleave(planar);
+
+			REQUIRE(l[0]    == 0.0f);
+			REQUIRE(r[16]   == -16.0f);
+			REQUIRE(l[1024] == 1024.0f);
+			REQUIRE(r[BUFFER_SIZE - 1] == -(BUFFER_SIZE - 1));
+
+			buffer.clear();
+			buffer.interleave(planar);
+
+			REQUIRE(buffer[16][0] == 16.0f);
+			REQUIRE(buffer[16][1] == -16.0f);
+			REQUIRE(buffer[BUFFER_SIZE - 1][1] == -(BUFFER_SIZE - 1));
+		}
+
+		SECTION("test odd channels count")
+		{
+			buffer.alloc(16, 3);
+			for (int i=0; i<buffer.countFrames(); i++)
+				for (int k=0; k<buffer.countChannels(); k++)
+					buffer[i][k] = (float) (i * 10 + k);
+
+			float a[16], b[16], c[16];
+			float* planar[] = { a, b, c };
+
+			buffer.deinterleave(planar);
+
+			REQUIRE(a[5] == 50.0f);
+			REQUIRE(b[5] == 51.0f);
+			REQUIRE(c[15] == 152.0f);
+
+			buffer.clear();
+			buffer.interleave(planar);
+
+			REQUIRE(buffer[7][2] == 72.0f);
+		}
+	}
 }
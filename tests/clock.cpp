@@ -0,0 +1,103 @@
+#include <cmath>
+#include "../src/core/clock.h"
+#include "../src/core/conf.h"
+#include "../src/core/const.h"
+#include "../src/core/types.h"
+#include <catch.hpp>
+
+
+TEST_CASE("clock")
+{
+	using namespace giada;
+	using namespace giada::m;
+
+	clock::init(/*sampleRate=*/44100, /*midiTCfps=*/25.0f);
+	clock::rewind();
+
+	SECTION("Test integer tempo")
+	{
+		clock::setBpm(120.0f);
+		clock::rewind();
+
+		REQUIRE(clock::getFramesInLoop() == 88200);
+		REQUIRE(clock::getFramesInBeat() == 22050);
+
+		int beats = 0;
+		int bars  = 0;
+		for (Frame f=0; f<88200*2; f++) {
+			if (clock::isOnBeat()) {
+				REQUIRE(f % 22050 == 0);
+				beats++;
+			}
+			if (clock::isOnBar()) {
+				REQUIRE(clock::getCurrentFrame() == 0);
+				bars++;
+			}
+			clock::incrCurrentFrame();
+		}
+		REQUIRE(beats == 8);
+		REQUIRE(bars == 2);
+	}
+
+	SECTION("Test fractional tempo doesn't drift")
+	{
+		clock::setBpm(133.3f);
+		clock::rewind();
+
+		const double framesInBeat = conf::samplerate * (60.0 / clock::getBpm());
+		const int    beats        = 400;
+
+		int  beat    = 0;
+		bool inRange = true;
+		for (Frame f=0; f<framesInBeat * beats; f++) {
+			if (clock::isOnBeat()) {
+				REQUIRE(f == std::lround(beat * framesInBeat));
+				REQUIRE(clock::isOnBar() == (beat % clock::getBeats() == 0));
+				REQUIRE((clock::getCurrentFrame() == 0) == (beat % clock::getBeats() == 0));
+				REQUIRE(clock::getCurrentBeat() == beat % clock::getBeats());
+				beat++;
+			}
+			inRange = inRange && clock::getCurrentFrame() < clock::getFramesInLoop();
+			clock::incrCurrentFrame();
+		}
+		REQUIRE(beat == beats);
+		REQUIRE(inRange);
+	}
+
+	SECTION("Test wrap frame")
+	{
+		/* Loops are one frame shorter from time to time: wraps must be reported
+		exactly where the current frame goes back to 0. */
+
+		clock::setBpm(133.3f);
+		clock::rewind();
+
+		const int BLOCK_SIZE = 256;
+
+		int  wraps = 0;
+		bool exact = true;
+		for (int block=0; block<clock::getFramesInLoop() * 20 / BLOCK_SIZE; block++) {
+			clock::beginBlock(0);
+			Frame wrap = -1;
+			for (int i=0; i<BLOCK_SIZE; i++) {
+				clock::incrCurrentFrame();
+				if (clock::getCurrentFrame() == 0)
+					wrap = i + 1;
+			}
+			exact = exact && clock::getWrapFrame() == wrap;
+			wraps += wrap != -1;
+		}
+		REQUIRE(exact);
+		REQUIRE(wraps >= 19);
+	}
+
+	SECTION("Test frame/tick round trip")
+	{
+		clock::setBpm(133.3f);
+
+		for (Frame f=0; f<clock::getFramesInLoop(); f+=7)
+			REQUIRE(clock::tickToFrame(clock::frameToTick(f)) == f);
+	}
+
+	clock::setBpm(G_DEFAULT_BPM);
+}
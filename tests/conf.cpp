@@ -23,6 +23,7 @@ TEST_CASE("conf")
     conf::samplerate = 7;
     conf::buffersize = 8;
     conf::limitOutput = true;
+    conf::jackDirectOuts = true;
     conf::rsmpQuality = 10;
     conf::midiSystem = 11;
     conf::midiPortOut = 12;
@@ -96,6 +97,7 @@ TEST_CASE("conf")
     REQUIRE(conf::samplerate == 44100);  // sanitized
     REQUIRE(conf::buffersize == 8);
     REQUIRE(conf::limitOutput == true);
+    REQUIRE(conf::jackDirectOuts == true);
     REQUIRE(conf::rsmpQuality == 0); // sanitized
     REQUIRE(conf::midiSystem == 11);
     REQUIRE(conf::midiPortOut == 12);
@@ -0,0 +1,44 @@
+#include "../src/core/engineState.h"
+#include "../src/core/mixer.h"
+#include "../src/core/const.h"
+#include "../src/core/types.h"
+#include <catch.hpp>
+
+
+TEST_CASE("engineState")
+{
+	using namespace giada;
+	using namespace giada::m;
+
+	mixer::peakOut.store(0.5f);
+	mixer::peakIn.store(0.25f);
+
+	engineState::writeChannels();
+	engineState::publish();
+
+	SECTION("Test fetch")
+	{
+		engineState::fetch();
+
+		REQUIRE(engineState::get().peakOut == 0.5f);
+		REQUIRE(engineState::get().peakIn == 0.25f);
+		REQUIRE(engineState::get().channelsCount == 0);
+		REQUIRE(engineState::get().channelsDropped == 0);
+	}
+
+	SECTION("Test latest state wins")
+	{
+		mixer::peakOut.store(0.7f);
+		engineState::writeChannels();
+		engineState::publish();
+		engineState::fetch();
+
+		REQUIRE(engineState::get().peakOut == 0.7f);
+
+		/* Nothing new published: fetch keeps the current state. */
+
+		engineState::fetch();
+
+		REQUIRE(engineState::get().peakOut == 0.7f);
+	}
+}
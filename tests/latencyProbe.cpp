@@ -0,0 +1,72 @@
+#include <future>
+#include <vector>
+#include "../src/core/latencyProbe.h"
+#include "../src/core/audioBuffer.h"
+#include "../src/core/const.h"
+#include "../src/core/types.h"
+#include <catch.hpp>
+
+
+TEST_CASE("latencyProbe")
+{
+	using namespace giada;
+	using namespace giada::m;
+
+	const int BLOCK_SIZE = 256;
+	const int SAMPLERATE = 44100;
+
+	AudioBuffer out, in;
+	out.alloc(BLOCK_SIZE, G_MAX_IO_CHANS);
+	in.alloc(BLOCK_SIZE, G_MAX_IO_CHANS);
+
+	/* Fake audio device: the output goes back to the input through a delay 
+	line 'latency' frames long, plus some noise. Like in any real device, the 
+	latency can't be shorter than a block. */
+
+	auto measure = [&](Frame latency, float noise, float gain)
+	{
+		std::vector<float> line(latency + BLOCK_SIZE, 0.0f);
+		int pos = 0;
+
+		std::future<Frame> f = std::async(std::launch::async, latencyProbe::measure, SAMPLERATE);
+		while (f.wait_for(std::chrono::milliseconds(0)) != std::future_status::ready) {
+			for (int i=0; i<BLOCK_SIZE; i++) {
+				float n = noise * ((i % 2) ? 1.0f : -1.0f);
+				for (int j=0; j<G_MAX_IO_CHANS; j++)
+					in[i][j] = line[(pos + i) % line.size()] * gain + n;
+			}
+			out.clear();
+			latencyProbe::process(out, in);
+			for (int i=0; i<BLOCK_SIZE; i++)
+				line[(pos + i + latency) % line.size()] = out[i][0];
+			pos = (pos + BLOCK_SIZE) % line.size();
+		}
+		return f.get();
+	};
+
+	SECTION("Test measure")
+	{
+		REQUIRE(measure(BLOCK_SIZE, 0.0f, 1.0f) == BLOCK_SIZE);
+		REQUIRE(measure(300, 0.0f, 1.0f) == 300);
+		REQUIRE(measure(1000, 0.0f, 1.0f) == 1000);
+	}
+
+	SECTION("Test measure with noise and attenuation")
+	{
+		REQUIRE(measure(777, 0.001f, 0.5f) == 777);
+	}
+
+	SECTION("Test no loopback")
+	{
+		REQUIRE(measure(1000, 0.0f, 0.0f) == -1);
+	}
+
+	SECTION("Test idle")
+	{
+		/* No measurement in progress: output untouched. */
+
+		out[0][0] = 0.3f;
+		latencyProbe::process(out, in);
+		REQUIRE(out[0][0] == 0.3f);
+	}
+}
@@ -0,0 +1,135 @@
+#include <cmath>
+#include <vector>
+#include "../src/core/midiSync.h"
+#include "../src/core/conf.h"
+#include "../src/core/const.h"
+#include <catch.hpp>
+
+
+using namespace giada::m;
+
+
+namespace
+{
+/* jitter
+Deterministic noise in [-0.001, 0.001] s, to fake a real-world MIDI input. */
+
+double jitter(unsigned& seed)
+{
+	seed = seed * 1103515245 + 12345;
+	return (((seed >> 16) & 0x7FFF) / 32767.0 - 0.5) * 0.002;
+}
+
+
+std::vector<midiSync::Event> drain()
+{
+	std::vector<midiSync::Event> events;
+	midiSync::Event e;
+	while (midiSync::getEvent(e))
+		events.push_back(e);
+	return events;
+}
+
+
+void send(std::vector<unsigned char> msg, double time)
+{
+	midiSync::receive(msg.data(), msg.size(), time);
+}
+} // {anonymous}
+
+
+TEST_CASE("midiSync")
+{
+	midiSync::reset();
+
+	SECTION("test DLL")
+	{
+		const double period = 1.0 / 48;  // 120 bpm, 24 ppq
+		unsigned seed = 1;
+
+		midiSync::Dll dll(G_MIDI_SYNC_BANDWIDTH);
+		dll.reset(0.0, period);
+		double filtered = 0.0;
+		for (int i=2; i<500; i++)
+			filtered = dll.update(i * period + jitter(seed));
+
+		REQUIRE(dll.getPeriod() == Approx(period).epsilon(0.005));
+		REQUIRE(std::abs(filtered - 499 * period) < 0.0005);
+	}
+
+	SECTION("test MIDI clock")
+	{
+		conf::midiSync = MIDI_SYNC_CLOCK_S;
+
+		const double period = 60.0 / (140.0 * G_MIDI_CLOCK_PPQ);
+		const int    ticks  = G_MIDI_CLOCK_PPQ * 32;
+		unsigned seed = 1;
+
+		/* Drain once per beat, as the audio thread would do every block. */
+
+		std::vector<midiSync::Event> events;
+		send({ MIDI_START }, 0.0);
+		for (int i=0; i<ticks; i++) {
+			send({ MIDI_CLOCK }, i * period + jitter(seed));
+			if (i % G_MIDI_CLOCK_PPQ == 0 || i == ticks - 1)
+				for (const midiSync::Event& e : drain())
+					events.push_back(e);
+		}
+
+		REQUIRE(events.size() == ticks);  // START + all ticks but the first one
+		REQUIRE(events.front().type == midiSync::Event::Type::START);
+		REQUIRE(events.front().position == 0.0);
+		REQUIRE(events.back().type == midiSync::Event::Type::TICK);
+		REQUIRE(events.back().position == Approx((ticks - 1) / double(G_MIDI_CLOCK_PPQ)));
+		REQUIRE(60.0 / (events.back().period * G_MIDI_CLOCK_PPQ) == Approx(140.0).epsilon(0.002));
+
+		send({ MIDI_STOP }, ticks * period);
+		send({ MIDI_POSITION_PTR, 0x10, 0x00 }, ticks * period); // 16 16th notes
+		events = drain();
+
+		REQUIRE(events.size() == 2);
+		REQUIRE(events[0].type == midiSync::Event::Type::STOP);
+		REQUIRE(events[1].type == midiSync::Event::Type::POSITION);
+		REQUIRE(events[1].position == 4.0);
+	}
+
+	SECTION("test MTC")
+	{
+		conf::midiSync = MIDI_SYNC_MTC_S;
+
+		/* 01:02:03:04 at 25 fps, rate code 1 in the last nibble. */
+
+		const unsigned char nibbles[8] = { 4, 0, 3, 0, 2, 0, 1, 1 << 1 };
+		const double quarter = 1.0 / (25 * 4);
+
+		for (int i=0; i<8; i++)
+			send({ MIDI_MTC_QUARTER, static_cast<unsigned char>((i << 4) | nibbles[i]) }, i * quarter);
+
+		std::vector<midiSync::Event> events = drain();
+
+		REQUIRE(events.size() == 1);  // Timecode is known only after piece 7
+		REQUIRE(events[0].type == midiSync::Event::Type::TICK);
+		REQUIRE(events[0].position == Approx(3723.0 + 5.75 / 25));
+		REQUIRE(events[0].period == Approx(quarter));
+
+		send({ MIDI_SYSEX, 0x7F, 0x7F, 0x01, 0x01, 0x20 | 1, 2, 3, 4, MIDI_EOX }, 1.0);
+		events = drain();
+
+		REQUIRE(events.size() == 1);
+		REQUIRE(events[0].type == midiSync::Event::Type::POSITION);
+		REQUIRE(events[0].position == Approx(3723.0 + 4.0 / 25));
+	}
+
+	SECTION("test not a slave")
+	{
+		conf::midiSync = MIDI_SYNC_CLOCK_M;
+
+		send({ MIDI_START }, 0.0);
+		send({ MIDI_CLOCK }, 0.0);
+		send({ MIDI_CLOCK }, 0.1);
+
+		REQUIRE(drain().empty());
+	}
+
+	conf::midiSync = MIDI_SYNC_NONE;
+}
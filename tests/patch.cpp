@@ -59,6 +59,11 @@ TEST_CASE("patch")
 		plugin2.params.push_back(1.0f);
 		plugin2.params.push_back(0.333f);
 		channel1.plugins.push_back(plugin2);
+
+		plugin3.path   = "/path/to/plugin3";
+		plugin3.bypass = false;
+		plugin3.state  = "R2lhZGEgc3RhdGU=";  // "Giada state"
+		channel1.plugins.push_back(plugin3);
 #endif
 
 		channel1.type              = static_cast<int>(ChannelType::SAMPLE);
@@ -216,6 +221,12 @@ TEST_CASE("patch")
 		REQUIRE(plugin1.params.at(4) == Approx(1.0f));
 		REQUIRE(plugin1.params.at(5) == Approx(1.0f));
 		REQUIRE(plugin1.params.at(6) == Approx(0.333f));
+		REQUIRE(plugin1.state.empty());
+
+		patch::plugin_t plugin2 = channel0.plugins.at(2);
+		REQUIRE(plugin2.path  == "/path/to/plugin3");
+		REQUIRE(plugin2.state == "R2lhZGEgc3RhdGU=");
+		REQUIRE(plugin2.params.empty());
 
 		patch::plugin_t masterPlugin0 = patch::masterInPlugins.at(0);
 		REQUIRE(masterPlugin0.path   == "/path/to/plugin1");
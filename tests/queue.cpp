@@ -0,0 +1,77 @@
+#include <thread>
+#include <vector>
+#include "../src/core/queue.h"
+#include <catch.hpp>
+
+
+TEST_CASE("Queue")
+{
+	using namespace giada::m;
+
+	Queue<int, 16> queue;
+
+	SECTION("test push and pop")
+	{
+		int v;
+
+		REQUIRE(queue.pop(v) == false);
+
+		for (int i=0; i<16; i++)
+			REQUIRE(queue.push(i));
+		REQUIRE(queue.push(16) == false);  // full
+
+		for (int i=0; i<16; i++) {
+			REQUIRE(queue.pop(v));
+			REQUIRE(v == i);
+		}
+		REQUIRE(queue.pop(v) == false);
+	}
+
+	SECTION("test wrap around")
+	{
+		int v;
+		for (int i=0; i<100; i++) {
+			REQUIRE(queue.push(i));
+			REQUIRE(queue.pop(v));
+			REQUIRE(v == i);
+		}
+	}
+
+	SECTION("test multiple producers")
+	{
+		const int PRODUCERS = 4;
+		const int ITEMS     = 10000;
+
+		/* Each producer pushes increasing values: order must be preserved per
+		producer, and nothing must get lost. */
+
+		std::vector<std::thread> producers;
+		for (int p=0; p<PRODUCERS; p++)
+			producers.emplace_back([&queue, p]()
+			{
+				for (int i=0; i<ITEMS; i++)
+					while (!queue.push(p * ITEMS + i))
+						std::this_thread::yield();
+			});
+
+		std::vector<int> last(PRODUCERS, -1);
+		int  received = 0;
+		bool ordered  = true;
+		while (received < PRODUCERS * ITEMS) {
+			int v;
+			if (!queue.pop(v))
+				continue;
+			int p = v / ITEMS;
+			if (v % ITEMS != last[p] + 1)
+				ordered = false;
+			last[p] = v % ITEMS;
+			received++;
+		}
+
+		for (std::thread& t : producers)
+			t.join();
+
+		REQUIRE(ordered);
+		REQUIRE(received == PRODUCERS * ITEMS);
+	}
+}
@@ -1,7 +1,9 @@
 #include "../src/core/recorder.h"
+#include "../src/core/clock.h"
 #include "../src/core/const.h"
 #include "../src/core/types.h"
 #include "../src/core/action.h"
+#include "../src/core/actionPool.h"
 #include <catch.hpp>
 
 
@@ -13,6 +15,7 @@ TEST_CASE("recorder")
 	pthread_mutex_t mutex;
 	pthread_mutex_init(&mutex, nullptr);
 
+	clock::init(/*sampleRate=*/44100, /*midiTCfps=*/25.0f);
 	recorder::init(&mutex);
 	recorder::enable();
 
@@ -32,10 +35,10 @@ TEST_CASE("recorder")
 		REQUIRE(recorder::hasActions(ch) == true);
 		REQUIRE(a1->frame == f1);
 		REQUIRE(a2->frame == f2);
-		REQUIRE(a1->prev == nullptr);
-		REQUIRE(a1->next == nullptr);
-		REQUIRE(a2->prev == nullptr);
-		REQUIRE(a2->next == nullptr);
+		REQUIRE(a1->getPrev() == nullptr);
+		REQUIRE(a1->getNext() == nullptr);
+		REQUIRE(a2->getPrev() == nullptr);
+		REQUIRE(a2->getNext() == nullptr);
 
 		SECTION("Test clear actions by channel")
 		{
@@ -65,8 +68,135 @@ TEST_CASE("recorder")
 
 		SECTION("Test clear all")
 		{
+			size_t used = actionPool::countUsed();
+			int    id   = a1->id;
 			recorder::clearAll();
 			REQUIRE(recorder::hasActions(/*channel=*/0) == false);
+			REQUIRE(recorder::getActionById(id) == nullptr);
+			REQUIRE(actionPool::countUsed() == used - 2);
+		}
+
+		SECTION("Test queries")
+		{
+			REQUIRE(recorder::hasActions(ch, MidiEvent::NOTE_ON) == true);
+			REQUIRE(recorder::hasActions(ch, MidiEvent::ENVELOPE) == false);
+			REQUIRE(recorder::getActionById(a1->id) == a1);
+			REQUIRE(recorder::getActionById(a2->id) == a2);
+			REQUIRE(recorder::getActionsOnChannel(ch).size() == 2);
+			REQUIRE(recorder::getActionsOnChannel(ch).at(0) == a1);
+			REQUIRE(recorder::getClosestAction(ch, 5, MidiEvent::NOTE_ON) == a1);
+			REQUIRE(recorder::getClosestAction(ch, 80, MidiEvent::NOTE_OFF) == a2);
+		}
+
+		SECTION("Test delete action")
+		{
+			recorder::deleteAction(a1);
+
+			REQUIRE(recorder::hasActions(ch, MidiEvent::NOTE_ON) == false);
+			REQUIRE(recorder::hasActions(ch, MidiEvent::NOTE_OFF) == true);
+			REQUIRE(recorder::getActionsOnFrame(f1).size() == 0);
+			REQUIRE(recorder::getActionsOnChannel(ch).size() == 1);
+		}
+
+		SECTION("Test transaction")
+		{
+			recorder::Transaction t;
+			const Action* a3 = t.rec(ch, 30, e1);
+			const Action* a4 = t.rec(ch, 40, e2);
+			t.updateSiblings(a3, nullptr, a4);
+			t.deleteAction(a1);
+			t.moveAction(a2, 50);
+
+			/* Nothing changes until commit. */
+
+			REQUIRE(recorder::getActionsOnChannel(ch).size() == 2);
+			REQUIRE(recorder::getActionsOnFrame(30).size() == 0);
+
+			recorder::commit(t);
+
+			REQUIRE(t.isEmpty() == true);
+			REQUIRE(recorder::getActionsOnChannel(ch).size() == 3);
+			REQUIRE(recorder::getActionsOnFrame(f1).size() == 0);
+			REQUIRE(recorder::getActionsOnFrame(f2).size() == 0);
+			REQUIRE(recorder::getActionsOnFrame(50).at(0) == a2);
+			REQUIRE(a2->frame == 50);
+			REQUIRE(a3->getNext() == a4);
+			REQUIRE(a4->getPrev() == a3);
+			REQUIRE(recorder::getClosestAction(ch, 35, MidiEvent::NOTE_ON) == a3);
+		}
+
+		SECTION("Test transaction, delete twice")
+		{
+			size_t used = actionPool::countUsed();
+
+			recorder::Transaction t;
+			t.deleteAction(a1);
+			t.deleteAction(a1);
+			recorder::commit(t);
+
+			REQUIRE(recorder::getActionsOnChannel(ch).size() == 1);
+			REQUIRE(actionPool::countUsed() == used - 1);
+		}
+
+		SECTION("Test abandoned transaction")
+		{
+			size_t used = actionPool::countUsed();
+			{
+				recorder::Transaction t;
+				t.rec(ch, 30, e1);
+				t.rec(ch, 40, e2);
+				REQUIRE(actionPool::countUsed() == used + 2);
+			}
+
+			/* Never committed: actions go back to the pool. */
+
+			REQUIRE(actionPool::countUsed() == used);
+			REQUIRE(recorder::getActionsOnChannel(ch).size() == 2);
+		}
+
+		SECTION("Test update frames")
+		{
+			clock::setBpm(G_DEFAULT_BPM / 2);
+			recorder::updateFrames();
+
+			REQUIRE(a1->frame == f1 * 2);
+			REQUIRE(recorder::getActionsOnFrame(f2 * 2).at(0) == a2);
+			REQUIRE(recorder::getClosestAction(ch, f2 * 2, MidiEvent::NOTE_OFF) == a2);
+
+			/* Back to the original tempo: no drift. */
+
+			clock::setBpm(G_DEFAULT_BPM);
+			recorder::updateFrames();
+
+			REQUIRE(a1->frame == f1);
+			REQUIRE(a2->frame == f2);
+		}
+
+		SECTION("Test prepared frames")
+		{
+			clock::setBpm(G_DEFAULT_BPM / 2);
+			recorder::prepareFrames();
+
+			/* Nothing changes until updateFrames(). */
+
+			REQUIRE(a1->frame == f1);
+
+			/* An edit in between makes the prepared remap useless. */
+
+			recorder::deleteAction(a2);
+			recorder::updateFrames();
+
+			REQUIRE(a1->frame == f1 * 2);
+			REQUIRE(recorder::getActionsOnFrame(f1 * 2).at(0) == a1);
+			REQUIRE(recorder::getActionsOnFrame(f2 * 2).size() == 0);
+			REQUIRE(recorder::getActionsOnChannel(ch).size() == 1);
+
+			clock::setBpm(G_DEFAULT_BPM);
+			recorder::prepareFrames();
+			recorder::updateFrames();
+
+			REQUIRE(a1->frame == f1);
+			REQUIRE(recorder::getActionsOnFrame(f1).at(0) == a1);
 		}
 	}
 }
\ No newline at end of file
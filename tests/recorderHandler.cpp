@@ -0,0 +1,126 @@
+#include <chrono>
+#include "../src/core/recorderHandler.h"
+#include "../src/core/recorder.h"
+#include "../src/core/clock.h"
+#include "../src/core/patch.h"
+#include "../src/core/const.h"
+#include "../src/core/types.h"
+#include "../src/core/action.h"
+#include <catch.hpp>
+
+
+using namespace giada;
+using namespace giada::m;
+
+
+namespace
+{
+/* makeEnvelope_
+Builds a chain of 'size' envelope actions on channel 'ch', each one linked to
+its neighbours, as written in a patch. */
+
+std::vector<patch::action_t> makeEnvelope_(int ch, int firstId, int size)
+{
+	std::vector<patch::action_t> out;
+	for (int i=0; i<size; i++) {
+		int id = firstId + i;
+		out.push_back(patch::action_t {
+			id, ch, i * 10, MidiEvent(MidiEvent::ENVELOPE, 0, 0).getRaw(),
+			i > 0 ? id - 1 : -1, 
+			i < size - 1 ? id + 1 : -1 
+		});
+	}
+	return out;
+}
+} // {anonymous}
+
+
+TEST_CASE("recorderHandler")
+{
+	pthread_mutex_t mutex;
+	pthread_mutex_init(&mutex, nullptr);
+
+	clock::init(/*sampleRate=*/44100, /*midiTCfps=*/25.0f);
+	recorder::init(&mutex);
+
+	patch::versionMajor = G_VERSION_MAJOR;
+	patch::versionMinor = G_VERSION_MINOR;
+	patch::versionPatch = G_VERSION_PATCH;
+	patch::samplerate   = 44100;
+	patch::bpm          = G_DEFAULT_BPM;
+	patch::beats        = G_DEFAULT_BEATS;
+
+	SECTION("Test read patch")
+	{
+		recorderHandler::readPatch(makeEnvelope_(/*ch=*/1, /*firstId=*/0, 3));
+
+		const Action* a0 = recorder::getActionById(0);
+		const Action* a1 = recorder::getActionById(1);
+		const Action* a2 = recorder::getActionById(2);
+
+		REQUIRE(a0 != nullptr);
+		REQUIRE(a0->getPrev() == nullptr);
+		REQUIRE(a0->getNext() == a1);
+		REQUIRE(a1->getPrev() == a0);
+		REQUIRE(a1->getNext() == a2);
+		REQUIRE(a2->getNext() == nullptr);
+		REQUIRE(recorder::getLatestActionId() == 3);
+		REQUIRE(recorder::getActionsOnChannel(1).size() == 3);
+	}
+
+	SECTION("Test read patch with dangling links")
+	{
+		std::vector<patch::action_t> p = makeEnvelope_(/*ch=*/1, /*firstId=*/0, 3);
+		p[0].next = 42;
+		p[2].prev = 43;
+
+		recorderHandler::readPatch(p);
+
+		const Action* a0 = recorder::getActionById(0);
+		const Action* a2 = recorder::getActionById(2);
+
+		REQUIRE(a0 != nullptr);
+		REQUIRE(a0->getNext() == nullptr);
+		REQUIRE(a2->getPrev() == nullptr);
+		REQUIRE(recorder::getActionsOnChannel(1).size() == 3);
+	}
+}
+
+
+TEST_CASE("recorderHandler load benchmark", "[.benchmark]")
+{
+	const int CHANNELS = 10;
+	const int ACTIONS  = 20000;  // per channel
+
+	pthread_mutex_t mutex;
+	pthread_mutex_init(&mutex, nullptr);
+
+	clock::init(/*sampleRate=*/44100, /*midiTCfps=*/25.0f);
+	recorder::init(&mutex);
+
+	patch::versionMajor = G_VERSION_MAJOR;
+	patch::versionMinor = G_VERSION_MINOR;
+	patch::versionPatch = G_VERSION_PATCH;
+	patch::samplerate   = 44100;
+	patch::bpm          = G_DEFAULT_BPM;
+	patch::beats        = G_DEFAULT_BEATS;
+
+	std::vector<std::vector<patch::action_t>> pactions;
+	for (int i=0; i<CHANNELS; i++)
+		pactions.push_back(makeEnvelope_(i, i * ACTIONS, ACTIONS));
+
+	auto start = std::chrono::steady_clock::now();
+
+	for (const std::vector<patch::action_t>& p : pactions)
+		recorderHandler::readPatch(p);
+
+	auto end = std::chrono::steady_clock::now();
+
+	WARN("Loaded " << CHANNELS * ACTIONS << " actions in " << 
+		std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count() << " ms");
+
+	REQUIRE(recorder::getActionsOnChannel(CHANNELS - 1).size() == ACTIONS);
+	REQUIRE(recorder::hasActions(0, MidiEvent::ENVELOPE) == true);
+
+	recorder::clearAll();
+}
@@ -0,0 +1,157 @@
+#include <cmath>
+#include <future>
+#include "../src/core/retroCapture.h"
+#include "../src/core/audioBuffer.h"
+#include "../src/core/clock.h"
+#include "../src/core/conf.h"
+#include "../src/core/const.h"
+#include "../src/core/types.h"
+#include <catch.hpp>
+
+
+TEST_CASE("retroCapture")
+{
+	using namespace giada;
+	using namespace giada::m;
+
+	const int BLOCK_SIZE = 256;
+
+	clock::init(44100, 25.0f);
+	clock::setStatus(ClockStatus::STOPPED);
+	clock::rewind();
+	retroCapture::init(/*budget=*/4);
+
+	/* Sequencer position after 'step' frames of playback. With fractional 
+	tempos loops last one frame more or less from time to time: loop 'k' starts
+	on the frame nearest to its exact position. */
+
+	auto frameAt = [](int64_t step)
+	{
+		const double loop = conf::samplerate * (60.0 / clock::getBpm()) * clock::getBeats();
+		int64_t k = std::floor(step / loop);
+		while (std::llround((k + 1) * loop) <= step) k++;
+		while (std::llround(k * loop) > step) k--;
+		return step - std::llround(k * loop);
+	};
+
+	/* Fake audio callback: the input signal is the sequencer position, so that
+	alignment can be verified on the committed buffer. */
+
+	AudioBuffer in;
+	in.alloc(BLOCK_SIZE, G_MAX_IO_CHANS);
+
+	Frame   latency = 0;
+	int64_t steps   = 0;
+
+	auto process = [&in, &latency, &steps, &frameAt]()
+	{
+		for (int i=0; i<BLOCK_SIZE; i++)
+			for (int j=0; j<G_MAX_IO_CHANS; j++)
+				in[i][j] = clock::isRunning() ? frameAt(steps + i - latency) : -1.0f;
+		if (clock::isRunning())
+			steps += BLOCK_SIZE;
+		retroCapture::write(in, 1.0f, 0);
+		clock::beginBlock(0);
+		for (int i=0; i<BLOCK_SIZE; i++)
+			if (clock::isRunning())
+				clock::incrCurrentFrame();
+	};
+
+	auto commit = [&process, &latency]()
+	{
+		std::future<std::shared_ptr<AudioBuffer>> f = std::async(std::launch::async, retroCapture::commit, latency);
+		while (f.wait_for(std::chrono::milliseconds(0)) != std::future_status::ready)
+			process();
+		return f.get();
+	};
+
+	REQUIRE(retroCapture::isEnabled());
+
+	SECTION("Test not enough input")
+	{
+		for (int i=0; i<10; i++)
+			process();
+		clock::setStatus(ClockStatus::RUNNING);
+		for (int i=0; i<10; i++)
+			process();
+
+		REQUIRE(commit() == nullptr);
+	}
+
+	SECTION("Test commit loop aligned")
+	{
+		for (int i=0; i<10; i++)  // stopped for a while: ignored
+			process();
+		clock::setStatus(ClockStatus::RUNNING);
+		for (int i=0; i<(clock::getFramesInLoop() * 2) / BLOCK_SIZE; i++)
+			process();
+
+		std::shared_ptr<AudioBuffer> b = commit();
+
+		REQUIRE(b != nullptr);
+		REQUIRE(b->countFrames() == clock::getFramesInLoop());
+
+		bool aligned = true;
+		for (int i=0; i<b->countFrames(); i++)
+			if ((*b)[i][0] != i)
+				aligned = false;
+		REQUIRE(aligned);
+
+		/* Capture goes on in the spare buffer. */
+
+		REQUIRE(commit() == nullptr);
+	}
+
+	SECTION("Test commit loop aligned, fractional tempo")
+	{
+		/* 130 BPM: 81415.38 frames per loop. Commit twice in a row, the second
+		time from the recycled buffer. */
+
+		clock::setBpm(130.0f);
+		clock::setStatus(ClockStatus::RUNNING);
+
+		for (int c=0; c<2; c++) {
+			for (int i=0; i<(clock::getFramesInLoop() * 2) / BLOCK_SIZE; i++)
+				process();
+
+			std::shared_ptr<AudioBuffer> b = commit();
+
+			REQUIRE(b != nullptr);
+			REQUIRE(b->countFrames() == clock::getFramesInLoop());
+
+			/* The last frame belongs to the next loop if this one was shorter. */
+
+			bool aligned = true;
+			for (int i=0; i<b->countFrames() - 1; i++)
+				if ((*b)[i][0] != i)
+					aligned = false;
+			REQUIRE(aligned);
+		}
+	}
+
+	SECTION("Test commit with latency")
+	{
+		/* Input lags behind the sequencer: the committed loop must be moved 
+		back accordingly. */
+
+		latency = 1234;
+
+		clock::setStatus(ClockStatus::RUNNING);
+		for (int i=0; i<(clock::getFramesInLoop() * 2) / BLOCK_SIZE; i++)
+			process();
+
+		std::shared_ptr<AudioBuffer> b = commit();
+
+		REQUIRE(b != nullptr);
+
+		bool aligned = true;
+		for (int i=0; i<b->countFrames(); i++)
+			if ((*b)[i][0] != i)
+				aligned = false;
+		REQUIRE(aligned);
+	}
+
+	retroCapture::close();
+	clock::setStatus(ClockStatus::STOPPED);
+	clock::setBpm(G_DEFAULT_BPM);
+}
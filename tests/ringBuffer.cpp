@@ -0,0 +1,91 @@
+#include <thread>
+#include <vector>
+#include "../src/core/ringBuffer.h"
+#include <catch.hpp>
+
+
+TEST_CASE("RingBuffer")
+{
+	using namespace giada::m;
+
+	RingBuffer ring;
+	ring.alloc(1000);
+
+	SECTION("test allocation")
+	{
+		REQUIRE(ring.countSamples() == 1024);  // next power of two
+		REQUIRE(ring.countReadable() == 0);
+		REQUIRE(ring.countWritable() == 1024);
+	}
+
+	SECTION("test write and read")
+	{
+		std::vector<float> in(100), out(100);
+		for (int i=0; i<100; i++)
+			in[i] = i;
+
+		REQUIRE(ring.write(in.data(), 100) == 100);
+		REQUIRE(ring.countReadable() == 100);
+		REQUIRE(ring.read(out.data(), 100) == 100);
+		REQUIRE(ring.countReadable() == 0);
+		REQUIRE(out == in);
+	}
+
+	SECTION("test wrap around")
+	{
+		std::vector<float> in(700), out(700);
+		for (int i=0; i<700; i++)
+			in[i] = i;
+
+		ring.write(in.data(), 700);
+		ring.read(out.data(), 700);
+		REQUIRE(ring.write(in.data(), 700) == 700);  // wraps
+		REQUIRE(ring.read(out.data(), 700) == 700);
+		REQUIRE(out == in);
+	}
+
+	SECTION("test overflow")
+	{
+		std::vector<float> in(2000, 1.0f), out(2000);
+
+		REQUIRE(ring.write(in.data(), 2000) == 1024);
+		REQUIRE(ring.countWritable() == 0);
+		REQUIRE(ring.write(in.data(), 1) == 0);
+		REQUIRE(ring.read(out.data(), 2000) == 1024);
+		REQUIRE(ring.read(out.data(), 1) == 0);
+	}
+
+	SECTION("test concurrent producer and consumer")
+	{
+		const int TOTAL = 1 << 20;
+
+		std::thread producer([&ring, TOTAL]()
+		{
+			float v = 0.0f;
+			float chunk[64];
+			int   written = 0;
+			while (written < TOTAL) {
+				for (int i=0; i<64; i++)
+					chunk[i] = v + i;
+				int n = ring.write(chunk, 64);  // less than 64 if full
+				v += n;
+				written += n;
+			}
+		});
+
+		bool  ordered = true;
+		float expected = 0.0f;
+		float chunk[100];
+		int   read = 0;
+		while (read < TOTAL) {
+			int n = ring.read(chunk, 100);
+			for (int i=0; i<n; i++, expected++)
+				if (chunk[i] != expected)
+					ordered = false;
+			read += n;
+		}
+		producer.join();
+
+		REQUIRE(ordered);
+	}
+}
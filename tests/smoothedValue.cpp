@@ -0,0 +1,57 @@
+#include "../src/core/smoothedValue.h"
+#include "../src/core/const.h"
+#include <catch.hpp>
+
+
+TEST_CASE("SmoothedValue")
+{
+	using namespace giada::m;
+
+	SmoothedValue v;
+
+	SECTION("test first target")
+	{
+		REQUIRE(v.next(0.5f) == Approx(0.5f));
+		REQUIRE(v.next(0.5f) == Approx(0.5f));
+	}
+
+	SECTION("test ramp")
+	{
+		v.next(0.0f);
+
+		float prev = 0.0f;
+		for (int i=1; i<G_SMOOTHING_FRAMES; i++) {
+			float curr = v.next(1.0f);
+			REQUIRE(curr > prev);
+			REQUIRE(curr < 1.0f);
+			prev = curr;
+		}
+		REQUIRE(v.next(1.0f) == 1.0f);
+		REQUIRE(v.next(1.0f) == 1.0f);
+	}
+
+	SECTION("test new target while ramping")
+	{
+		v.next(0.0f);
+		for (int i=0; i<G_SMOOTHING_FRAMES/2; i++)
+			v.next(1.0f);
+
+		float halfway = v.next(0.0f);
+		REQUIRE(halfway > 0.0f);
+		REQUIRE(halfway < 1.0f);
+
+		for (int i=1; i<G_SMOOTHING_FRAMES; i++)
+			REQUIRE(v.next(0.0f) <= halfway);
+		REQUIRE(v.next(0.0f) == 0.0f);
+	}
+
+	SECTION("test reset")
+	{
+		v.next(0.0f);
+		v.next(1.0f);  // Ramp started
+		v.reset();
+
+		REQUIRE(v.next(0.5f) == Approx(0.5f));
+		REQUIRE(v.next(0.5f) == Approx(0.5f));
+	}
+}
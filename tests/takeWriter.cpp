@@ -0,0 +1,71 @@
+#include "../src/core/takeWriter.h"
+#include "../src/core/audioBuffer.h"
+#include "../src/core/const.h"
+#include "../src/core/types.h"
+#include <catch.hpp>
+
+
+TEST_CASE("takeWriter")
+{
+	using namespace giada;
+	using namespace giada::m;
+
+	const int   BLOCK_SIZE = 64;
+	const Frame LOOP       = 1000;
+	const char* PATH       = "tests/resources/test-take.wav";
+
+	AudioBuffer in;
+	in.alloc(BLOCK_SIZE, G_MAX_IO_CHANS);
+
+	/* Fake audio callback: plays 'frames' frames of sequencer from 'current',
+	the input being what the sequencer played 'latency' frames before. Each
+	input frame carries the take position it belongs to. */
+
+	auto record = [&](Frame current, Frame frames, Frame latency)
+	{
+		while (frames > 0) {
+			Frame block = std::min(frames, BLOCK_SIZE);
+			Frame wrap  = -1;
+			for (int i=0; i<block; i++) {
+				Frame seq = (current + i) % LOOP;
+				if (seq == 0)
+					wrap = i;
+				for (int j=0; j<G_MAX_IO_CHANS; j++)
+					in[i][j] = ((seq - latency) % LOOP + LOOP) % LOOP;
+			}
+			takeWriter::push(in, 1.0f, 0, block, wrap);
+			current += block;
+			frames  -= block;
+		}
+	};
+
+	SECTION("Test overdub over multiple loops")
+	{
+		/* Start mid-loop, as mixerHandler::startInputRec() does, and record
+		three loops exactly: every frame of the take is written three times,
+		each time with the same value. */
+
+		for (Frame latency : { 0, 100, 777 }) {
+			Frame current = 300;
+			Frame offset  = ((current - latency) % LOOP + LOOP) % LOOP;
+
+			takeWriter::start(LOOP, offset, latency, 44100, BLOCK_SIZE, PATH);
+			record(current, LOOP * 3, latency);
+			takeWriter::stop();
+
+			std::shared_ptr<AudioBuffer> take = takeWriter::getTake();
+
+			REQUIRE(take != nullptr);
+			REQUIRE(take->countFrames() == LOOP);
+			REQUIRE(takeWriter::countDropped() == 0);
+
+			bool aligned = true;
+			for (int i=0; i<LOOP; i++)
+				if ((*take)[i][0] != i * 3)
+					aligned = false;
+			REQUIRE(aligned);
+		}
+	}
+
+	takeWriter::close();
+}
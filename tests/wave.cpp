@@ -47,4 +47,38 @@ TEST_CASE("Wave")
 			REQUIRE(wave.getBasename(true) == "sample.wav");
 		}
 	}
+
+	SECTION("test shared data")
+	{
+		auto data = std::make_shared<giada::m::AudioBuffer>();
+		data->alloc(BUFFER_SIZE, CHANNELS);
+
+		Wave a, b;
+		a.shareData(data);
+		b.shareData(data);
+
+		REQUIRE(a.isShared());
+		REQUIRE(a.getSize() == BUFFER_SIZE);
+		REQUIRE(a[0] == b[0]);
+
+		SECTION("test detach")
+		{
+			(*data)[0][0] = 1.0f;
+			a.detach();
+			a[0][0] = 0.5f;
+
+			REQUIRE(a[0] != b[0]);
+			REQUIRE(b[0][0] == 1.0f);
+			REQUIRE(a.getSize() == BUFFER_SIZE);
+		}
+
+		SECTION("test copy on write")
+		{
+			float f[CHANNELS] = { 0.5f, 0.5f };
+			a.copyData(f, 1);
+
+			REQUIRE(a[0][0] == 0.5f);
+			REQUIRE(b[0][0] == 0.0f);
+		}
+	}
 }